@@ -642,6 +642,14 @@ int main(int argc, char** argv)
     {
         type = IPC_SUBSCRIBE;
     }
+    else if (strcasecmp(cmdtype, "get_render_statistics") == 0)
+    {
+        type = IPC_GET_RENDER_STATISTICS;
+    }
+    else if (strcasecmp(cmdtype, "get_animation_budget") == 0)
+    {
+        type = IPC_GET_ANIMATION_BUDGET;
+    }
     else
     {
         if (quiet)
@@ -0,0 +1,160 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "animation_budget.h"
+
+#include <algorithm>
+
+using namespace miracle;
+
+namespace
+{
+/// Frames that take this much longer than the refresh period are considered late.
+constexpr float late_frame_factor = 1.5f;
+
+float to_ms(AnimationBudget::clock::duration duration)
+{
+    return std::chrono::duration<float, std::milli>(duration).count();
+}
+}
+
+char const* miracle::to_string(AnimationDegradation degradation)
+{
+    switch (degradation)
+    {
+    case AnimationDegradation::none:
+        return "none";
+    case AnimationDegradation::transform_only:
+        return "transform_only";
+    case AnimationDegradation::snap:
+        return "snap";
+    default:
+        return "unknown";
+    }
+}
+
+void AnimationBudget::set_budget_ms(float value)
+{
+    std::lock_guard lock(mutex);
+    budget_ms = value;
+}
+
+void AnimationBudget::add_cost(clock::duration cost)
+{
+    std::lock_guard lock(mutex);
+    pending_cost += cost;
+}
+
+std::optional<AnimationBudget::Event> AnimationBudget::end_frame(
+    std::optional<FrameTiming> const& frame, clock::time_point now)
+{
+    std::lock_guard lock(mutex);
+    last_frame_cost_ms = to_ms(pending_cost);
+    pending_cost = clock::duration::zero();
+
+    bool is_late = false;
+    if (frame)
+    {
+        last_frame_interval_ms = to_ms(frame->interval);
+        last_refresh_period_ms = to_ms(frame->refresh_period);
+        is_late = last_frame_interval_ms > last_refresh_period_ms.value() * late_frame_factor;
+    }
+
+    if (budget_ms <= 0.f)
+        return std::nullopt;
+
+    if (last_frame_cost_ms > budget_ms || is_late)
+    {
+        frames_within_budget = 0;
+        if (++frames_over_budget >= frames_before_degrading && level != AnimationDegradation::snap)
+        {
+            frames_over_budget = 0;
+            return change_level(static_cast<AnimationDegradation>(static_cast<int>(level) + 1), now);
+        }
+    }
+    else
+    {
+        frames_over_budget = 0;
+        if (++frames_within_budget >= frames_before_recovering && level != AnimationDegradation::none)
+        {
+            frames_within_budget = 0;
+            return change_level(static_cast<AnimationDegradation>(static_cast<int>(level) - 1), now);
+        }
+    }
+
+    return std::nullopt;
+}
+
+std::optional<AnimationBudget::Event> AnimationBudget::resume(clock::time_point now)
+{
+    std::lock_guard lock(mutex);
+    frames_over_budget = 0;
+    frames_within_budget = 0;
+    if (level == AnimationDegradation::none || now - last_change < idle_recovery_period)
+        return std::nullopt;
+
+    return change_level(static_cast<AnimationDegradation>(static_cast<int>(level) - 1), now);
+}
+
+std::optional<AnimationBudget::Event> AnimationBudget::change_level(AnimationDegradation to, clock::time_point now)
+{
+    Event event { now, level, to, last_frame_cost_ms, last_frame_interval_ms };
+    level = to;
+    last_change = now;
+    total_events++;
+    events.push_back(event);
+    if (events.size() > max_events)
+        events.pop_front();
+    return event;
+}
+
+AnimationDegradation AnimationBudget::get_level() const
+{
+    std::lock_guard lock(mutex);
+    return level;
+}
+
+nlohmann::json AnimationBudget::to_json() const
+{
+    std::lock_guard lock(mutex);
+    auto const now = clock::now();
+    nlohmann::json recent_events = nlohmann::json::array();
+    for (auto const& event : events)
+    {
+        recent_events.push_back({
+            { "seconds_ago",       std::chrono::duration<float>(now - event.time).count() },
+            { "from",              to_string(event.from)                                   },
+            { "to",                to_string(event.to)                                    },
+            { "frame_cost_ms",     event.frame_cost_ms                                     },
+            { "frame_interval_ms", event.frame_interval_ms                                 }
+        });
+    }
+
+    nlohmann::json result = {
+        { "budget_ms",         budget_ms              },
+        { "level",             to_string(level)       },
+        { "frame_cost_ms",     last_frame_cost_ms     },
+        { "frame_interval_ms", last_frame_interval_ms },
+        { "total_events",      total_events           },
+        { "events",            recent_events          }
+    };
+
+    if (last_refresh_period_ms)
+        result["refresh_period_ms"] = last_refresh_period_ms.value();
+
+    return result;
+}
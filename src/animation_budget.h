@@ -0,0 +1,120 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_ANIMATION_BUDGET_H
+#define MIRACLEWM_ANIMATION_BUDGET_H
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <optional>
+
+namespace miracle
+{
+
+/// How far animations are cut back to keep the compositor responsive. Each level
+/// includes the savings of the levels before it.
+enum class AnimationDegradation
+{
+    /// Animations run as configured
+    none,
+    /// Moving windows are placed at their final rectangle once and are only transformed afterwards
+    transform_only,
+    /// Animations complete immediately
+    snap
+};
+
+char const* to_string(AnimationDegradation);
+
+/// Tracks the time that the compositor spends on animations in each frame, along with
+/// how regularly frames arrive, and decides when animations need to be degraded.
+///
+/// Animations are degraded by one level after a few consecutive frames over budget and
+/// recover by one level after a long run of frames within budget, or when they start
+/// again after the compositor has been idle for a while.
+class AnimationBudget
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    /// The number of consecutive frames over budget before animations are degraded.
+    static constexpr int frames_before_degrading = 3;
+
+    /// The number of consecutive frames within budget before animations recover.
+    static constexpr int frames_before_recovering = 120;
+
+    /// Animations that start after at least this long without a change recover by a level.
+    static constexpr std::chrono::seconds idle_recovery_period { 2 };
+
+    /// The number of degradation events that are kept for IPC clients.
+    static constexpr size_t max_events = 32;
+
+    struct Event
+    {
+        clock::time_point time;
+        AnimationDegradation from;
+        AnimationDegradation to;
+        float frame_cost_ms;
+        float frame_interval_ms;
+    };
+
+    /// Sets the time that animations may take in each frame. Zero or less disables degradation.
+    void set_budget_ms(float);
+
+    /// Adds time spent on animations to the current frame.
+    void add_cost(clock::duration);
+
+    /// How regularly frames arrive on the output that drove a frame.
+    struct FrameTiming
+    {
+        /// The time since the previous frame on the same output
+        clock::duration interval;
+        /// The refresh period of that output
+        clock::duration refresh_period;
+    };
+
+    /// Completes the current frame. [frame] is set if the animations are being driven by
+    /// the display. Returns the event if the level changed.
+    std::optional<Event> end_frame(std::optional<FrameTiming> const& frame, clock::time_point now);
+
+    /// Called when animations start after none were running. Returns the event if the level changed.
+    std::optional<Event> resume(clock::time_point now);
+
+    [[nodiscard]] AnimationDegradation get_level() const;
+    [[nodiscard]] nlohmann::json to_json() const;
+
+private:
+    std::optional<Event> change_level(AnimationDegradation to, clock::time_point now);
+
+    mutable std::mutex mutex;
+    float budget_ms = 0.f;
+    AnimationDegradation level = AnimationDegradation::none;
+    clock::duration pending_cost = clock::duration::zero();
+    float last_frame_cost_ms = 0.f;
+    float last_frame_interval_ms = 0.f;
+    std::optional<float> last_refresh_period_ms;
+    int frames_over_budget = 0;
+    int frames_within_budget = 0;
+    clock::time_point last_change;
+    uint64_t total_events = 0;
+    std::deque<Event> events;
+};
+
+}
+
+#endif // MIRACLEWM_ANIMATION_BUDGET_H
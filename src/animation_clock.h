@@ -0,0 +1,57 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_ANIMATION_CLOCK_H
+#define MIRACLEWM_ANIMATION_CLOCK_H
+
+#include <atomic>
+#include <chrono>
+
+namespace miracle
+{
+/// Where the [Animator] gets the current time from.
+class AnimationClock
+{
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    virtual ~AnimationClock() = default;
+    [[nodiscard]] virtual time_point now() const = 0;
+};
+
+/// Reads the monotonic wall clock.
+class SteadyAnimationClock : public AnimationClock
+{
+public:
+    [[nodiscard]] time_point now() const override { return std::chrono::steady_clock::now(); }
+};
+
+/// Only moves when it is told to, so that tests and replays advance animations deterministically.
+/// An animator with this clock is expected to be driven by frames rather than started.
+class ManualAnimationClock : public AnimationClock
+{
+public:
+    [[nodiscard]] time_point now() const override { return time_point(time_point::duration(ticks.load())); }
+    void set(time_point time) { ticks = time.time_since_epoch().count(); }
+    void advance(time_point::duration duration) { ticks += duration.count(); }
+
+private:
+    std::atomic<time_point::rep> ticks = 0;
+};
+}
+
+#endif // MIRACLEWM_ANIMATION_CLOCK_H
@@ -113,6 +113,10 @@ std::optional<AnimationType> miracle::from_string_animation_type(std::string con
         return AnimationType::grow;
     else if (str == "shrink")
         return AnimationType::shrink;
+    else if (str == "fade")
+        return AnimationType::fade;
+    else if (str == "spring")
+        return AnimationType::spring;
     else
         return std::nullopt;
 }
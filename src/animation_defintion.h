@@ -19,11 +19,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define MIRACLE_WM_ANIMATION_DEFINTION_H
 
 #include "mir/geometry/point.h"
+#include <memory>
 #include <optional>
 #include <string>
 
 namespace miracle
 {
+class EaseTable;
+
 /// Defines an event that can be animated.
 enum class AnimateableEvent
 {
@@ -77,6 +80,8 @@ enum class AnimationType
     slide,
     grow,
     shrink,
+    fade,
+    spring,
     max
 };
 
@@ -88,6 +93,13 @@ struct AnimationDefinition
     EaseFunction function = EaseFunction::linear;
     float duration_seconds = 1.f;
 
+    /// If true, a slide moves the window to its final rectangle straight away and the
+    /// movement is drawn by the compositor with a transform alone.
+    bool transform_only = false;
+
+    /// The stiffness of a critically damped [AnimationType::spring]. Stiffer springs settle sooner.
+    float stiffness = 400.f;
+
     // Easing function values
     float c1 = 1.2;
     float c2 = 1.83;
@@ -96,6 +108,10 @@ struct AnimationDefinition
     float c5 = 1.3962634015954636;
     float n1 = 7.5625;
     float d1 = 2.75;
+
+    /// A precomputed copy of [function], built when the configuration is loaded. Definitions
+    /// without a table evaluate the exact function instead.
+    std::shared_ptr<EaseTable const> ease_table;
 };
 
 std::optional<AnimateableEvent> from_string_animateable_event(std::string const&);
@@ -0,0 +1,66 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "animation_trace.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace miracle;
+
+/// Replays a trace that was recorded with MIRACLE_WM_ANIMATION_TRACE and reports whether the
+/// current animator produces the same results. Exits with a non-zero status if it does not.
+int main(int argc, char const* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <trace> [tolerance]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in)
+    {
+        std::cerr << "Unable to open " << argv[1] << ": " << strerror(errno) << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    float const tolerance = argc > 2 ? std::strtof(argv[2], nullptr) : 0.f;
+    try
+    {
+        auto const trace = AnimationTrace::read(in);
+        auto const report = trace.replay(tolerance);
+        std::cout << "animations: " << report.num_starts
+                  << ", steps: " << report.num_steps
+                  << ", results: " << report.replayed_results << "/" << report.expected_results
+                  << ", mismatches: " << report.mismatches
+                  << ", replay time: " << std::chrono::duration<double, std::milli>(report.replay_time).count() << "ms"
+                  << std::endl;
+
+        if (report.first_mismatch)
+            std::cout << "first mismatch at result " << report.first_mismatch.value() << std::endl;
+
+        return report.matches() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << argv[1] << ": " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,362 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "animation_trace.h"
+#include "easing.h"
+
+#include <boost/throw_exception.hpp>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+using namespace miracle;
+
+namespace
+{
+constexpr char magic[4] = { 'M', 'W', 'A', 'T' };
+constexpr uint32_t version = 1;
+
+enum class RecordTag : uint8_t
+{
+    start = 1,
+    step = 2,
+    finish = 3,
+    result = 4
+};
+
+enum ResultFlags : uint8_t
+{
+    result_complete = 1 << 0,
+    result_position = 1 << 1,
+    result_size = 1 << 2,
+    result_transform = 1 << 3,
+    result_alpha = 1 << 4
+};
+
+template <typename T>
+void write_value(std::ostream& out, T const& value)
+{
+    out.write(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+template <typename T>
+T read_value(std::istream& in)
+{
+    T value;
+    if (!in.read(reinterpret_cast<char*>(&value), sizeof(T)))
+        BOOST_THROW_EXCEPTION(std::runtime_error("Animation trace ended in the middle of a record"));
+    return value;
+}
+
+void write_rectangle(std::ostream& out, std::optional<mir::geometry::Rectangle> const& rectangle)
+{
+    write_value<uint8_t>(out, rectangle.has_value());
+    if (!rectangle)
+        return;
+
+    write_value<int32_t>(out, rectangle->top_left.x.as_int());
+    write_value<int32_t>(out, rectangle->top_left.y.as_int());
+    write_value<int32_t>(out, rectangle->size.width.as_int());
+    write_value<int32_t>(out, rectangle->size.height.as_int());
+}
+
+std::optional<mir::geometry::Rectangle> read_rectangle(std::istream& in)
+{
+    if (!read_value<uint8_t>(in))
+        return std::nullopt;
+
+    auto const x = read_value<int32_t>(in);
+    auto const y = read_value<int32_t>(in);
+    auto const width = read_value<int32_t>(in);
+    auto const height = read_value<int32_t>(in);
+    return mir::geometry::Rectangle { mir::geometry::Point(x, y), mir::geometry::Size(width, height) };
+}
+
+void write_definition(std::ostream& out, AnimationDefinition const& definition)
+{
+    write_value<uint8_t>(out, static_cast<uint8_t>(definition.type));
+    write_value<uint8_t>(out, static_cast<uint8_t>(definition.function));
+    write_value<uint8_t>(out, definition.transform_only);
+    write_value<uint8_t>(out, definition.ease_table != nullptr);
+    for (float value : { definition.duration_seconds, definition.stiffness, definition.c1, definition.c2,
+             definition.c3, definition.c4, definition.c5, definition.n1, definition.d1 })
+        write_value<float>(out, value);
+}
+
+AnimationDefinition read_definition(std::istream& in)
+{
+    AnimationDefinition definition;
+    definition.type = static_cast<AnimationType>(read_value<uint8_t>(in));
+    definition.function = static_cast<EaseFunction>(read_value<uint8_t>(in));
+    definition.transform_only = read_value<uint8_t>(in);
+    bool const has_ease_table = read_value<uint8_t>(in);
+    for (float* value : { &definition.duration_seconds, &definition.stiffness, &definition.c1, &definition.c2,
+             &definition.c3, &definition.c4, &definition.c5, &definition.n1, &definition.d1 })
+        *value = read_value<float>(in);
+
+    // The table is rebuilt from the same inputs, so the replay eases exactly like the recording
+    if (has_ease_table)
+        definition.ease_table = make_ease_table(definition);
+    return definition;
+}
+
+bool nearly_equal(float a, float b, float tolerance)
+{
+    return a == b || std::abs(a - b) <= tolerance;
+}
+
+template <typename T>
+bool nearly_equal(std::optional<T> const& a, std::optional<T> const& b, float tolerance)
+{
+    if (a.has_value() != b.has_value())
+        return false;
+    if (!a)
+        return true;
+
+    if constexpr (std::is_same_v<T, float>)
+        return nearly_equal(a.value(), b.value(), tolerance);
+    else if constexpr (std::is_same_v<T, glm::mat4>)
+    {
+        for (int column = 0; column < 4; column++)
+            for (int row = 0; row < 4; row++)
+                if (!nearly_equal(a.value()[column][row], b.value()[column][row], tolerance))
+                    return false;
+        return true;
+    }
+    else
+    {
+        for (int i = 0; i < T::length(); i++)
+            if (!nearly_equal(a.value()[i], b.value()[i], tolerance))
+                return false;
+        return true;
+    }
+}
+
+bool nearly_equal(AnimationStepResult const& a, AnimationStepResult const& b, float tolerance)
+{
+    return a.handle == b.handle
+        && a.is_complete == b.is_complete
+        && nearly_equal(a.position, b.position, tolerance)
+        && nearly_equal(a.size, b.size, tolerance)
+        && nearly_equal(a.transform, b.transform, tolerance)
+        && nearly_equal(a.alpha, b.alpha, tolerance);
+}
+}
+
+AnimationRecorder::AnimationRecorder(std::shared_ptr<std::ostream> const& out) :
+    out { out }
+{
+    this->out->write(magic, sizeof(magic));
+    write_value<uint32_t>(*this->out, version);
+}
+
+AnimationRecorder::~AnimationRecorder()
+{
+    out->flush();
+}
+
+std::chrono::nanoseconds AnimationRecorder::relative(std::chrono::steady_clock::time_point time)
+{
+    if (!start_time)
+        start_time = time;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time - start_time.value());
+}
+
+void AnimationRecorder::record_start(
+    std::chrono::steady_clock::time_point time,
+    AnimationHandle handle,
+    AnimationDefinition const& definition,
+    std::optional<mir::geometry::Rectangle> const& from,
+    std::optional<mir::geometry::Rectangle> const& to,
+    std::optional<mir::geometry::Rectangle> const& current)
+{
+    std::lock_guard lock(mutex);
+    write_value(*out, RecordTag::start);
+    write_value<int64_t>(*out, relative(time).count());
+    write_value<uint32_t>(*out, handle);
+    write_definition(*out, definition);
+    write_rectangle(*out, from);
+    write_rectangle(*out, to);
+    write_rectangle(*out, current);
+}
+
+void AnimationRecorder::record_step(std::chrono::steady_clock::time_point time, float delta_seconds)
+{
+    std::lock_guard lock(mutex);
+    write_value(*out, RecordTag::step);
+    write_value<int64_t>(*out, relative(time).count());
+    write_value<float>(*out, delta_seconds);
+}
+
+void AnimationRecorder::record_finish(std::chrono::steady_clock::time_point time)
+{
+    std::lock_guard lock(mutex);
+    write_value(*out, RecordTag::finish);
+    write_value<int64_t>(*out, relative(time).count());
+}
+
+void AnimationRecorder::record_result(AnimationStepResult const& result)
+{
+    std::lock_guard lock(mutex);
+    uint8_t flags = 0;
+    if (result.is_complete)
+        flags |= result_complete;
+    if (result.position)
+        flags |= result_position;
+    if (result.size)
+        flags |= result_size;
+    if (result.transform)
+        flags |= result_transform;
+    if (result.alpha)
+        flags |= result_alpha;
+
+    write_value(*out, RecordTag::result);
+    write_value<uint32_t>(*out, result.handle);
+    write_value<uint8_t>(*out, flags);
+    if (result.position)
+        write_value(*out, result.position.value());
+    if (result.size)
+        write_value(*out, result.size.value());
+    if (result.transform)
+        write_value(*out, result.transform.value());
+    if (result.alpha)
+        write_value<float>(*out, result.alpha.value());
+}
+
+AnimationTrace AnimationTrace::read(std::istream& in)
+{
+    char header[sizeof(magic)];
+    if (!in.read(header, sizeof(header)) || std::memcmp(header, magic, sizeof(magic)) != 0)
+        BOOST_THROW_EXCEPTION(std::runtime_error("Not an animation trace"));
+
+    auto const trace_version = read_value<uint32_t>(in);
+    if (trace_version != version)
+        BOOST_THROW_EXCEPTION(std::runtime_error("Unsupported animation trace version: " + std::to_string(trace_version)));
+
+    AnimationTrace trace;
+    uint8_t tag;
+    while (in.read(reinterpret_cast<char*>(&tag), sizeof(tag)))
+    {
+        switch (static_cast<RecordTag>(tag))
+        {
+        case RecordTag::start:
+        {
+            AnimationTraceStart start;
+            start.time = std::chrono::nanoseconds(read_value<int64_t>(in));
+            start.handle = read_value<uint32_t>(in);
+            start.definition = read_definition(in);
+            start.from = read_rectangle(in);
+            start.to = read_rectangle(in);
+            start.current = read_rectangle(in);
+            trace.records.push_back(start);
+            break;
+        }
+        case RecordTag::step:
+        {
+            AnimationTraceStep step;
+            step.time = std::chrono::nanoseconds(read_value<int64_t>(in));
+            step.delta_seconds = read_value<float>(in);
+            trace.records.push_back(step);
+            break;
+        }
+        case RecordTag::finish:
+            trace.records.push_back(AnimationTraceFinish { std::chrono::nanoseconds(read_value<int64_t>(in)) });
+            break;
+        case RecordTag::result:
+        {
+            AnimationStepResult result;
+            result.handle = read_value<uint32_t>(in);
+            auto const flags = read_value<uint8_t>(in);
+            result.is_complete = flags & result_complete;
+            if (flags & result_position)
+                result.position = read_value<glm::vec2>(in);
+            if (flags & result_size)
+                result.size = read_value<glm::vec2>(in);
+            if (flags & result_transform)
+                result.transform = read_value<glm::mat4>(in);
+            if (flags & result_alpha)
+                result.alpha = read_value<float>(in);
+            trace.records.push_back(AnimationTraceResult { result });
+            break;
+        }
+        default:
+            BOOST_THROW_EXCEPTION(std::runtime_error("Unknown animation trace record: " + std::to_string(tag)));
+        }
+    }
+
+    return trace;
+}
+
+AnimationReplayReport AnimationTrace::replay(float tolerance) const
+{
+    AnimationReplayReport report;
+    AnimationStore store;
+    std::vector<AnimationStepResult> replayed;
+    std::vector<AnimationStepResult> expected;
+    std::vector<AnimationStore::Update> updates;
+
+    auto const start_time = std::chrono::steady_clock::now();
+    for (auto const& record : records)
+    {
+        updates.clear();
+        if (auto const* start = std::get_if<AnimationTraceStart>(&record))
+        {
+            report.num_starts++;
+            replayed.push_back(store.insert(Animation(
+                start->handle,
+                start->definition,
+                start->from,
+                start->to,
+                start->current,
+                [](AnimationStepResult const&) { })));
+        }
+        else if (auto const* step = std::get_if<AnimationTraceStep>(&record))
+        {
+            report.num_steps++;
+            store.step(step->delta_seconds, updates);
+        }
+        else if (std::holds_alternative<AnimationTraceFinish>(record))
+        {
+            store.finish(updates);
+        }
+        else if (auto const* result = std::get_if<AnimationTraceResult>(&record))
+        {
+            expected.push_back(result->result);
+        }
+
+        for (auto const& update : updates)
+            replayed.push_back(update.result);
+    }
+    report.replay_time = std::chrono::steady_clock::now() - start_time;
+
+    report.expected_results = expected.size();
+    report.replayed_results = replayed.size();
+    for (size_t i = 0; i < std::min(expected.size(), replayed.size()); i++)
+    {
+        if (nearly_equal(expected[i], replayed[i], tolerance))
+            continue;
+
+        report.mismatches++;
+        if (!report.first_mismatch)
+            report.first_mismatch = i;
+    }
+
+    if (!report.first_mismatch && expected.size() != replayed.size())
+        report.first_mismatch = std::min(expected.size(), replayed.size());
+
+    return report;
+}
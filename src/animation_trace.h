@@ -0,0 +1,131 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_ANIMATION_TRACE_H
+#define MIRACLEWM_ANIMATION_TRACE_H
+
+#include "animator.h"
+
+#include <chrono>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <variant>
+#include <vector>
+
+namespace miracle
+{
+
+/// An animation that was started, with everything that is needed to start it again.
+struct AnimationTraceStart
+{
+    std::chrono::nanoseconds time;
+    AnimationHandle handle;
+    AnimationDefinition definition;
+    std::optional<mir::geometry::Rectangle> from;
+    std::optional<mir::geometry::Rectangle> to;
+    std::optional<mir::geometry::Rectangle> current;
+};
+
+/// Every animation was advanced by [delta_seconds].
+struct AnimationTraceStep
+{
+    std::chrono::nanoseconds time;
+    float delta_seconds;
+};
+
+/// Every animation was completed immediately (see [AnimationStore::finish]).
+struct AnimationTraceFinish
+{
+    std::chrono::nanoseconds time;
+};
+
+/// A result that was produced by the record before it.
+struct AnimationTraceResult
+{
+    AnimationStepResult result;
+};
+
+using AnimationTraceRecord = std::variant<AnimationTraceStart, AnimationTraceStep, AnimationTraceFinish, AnimationTraceResult>;
+
+/// Writes everything that the [Animator] does to a compact binary trace: the animations that
+/// are started, each step, and every [AnimationStepResult] that they produce. Times are
+/// relative to the first record. Values are written in native byte order, so traces are
+/// meant to be replayed on the machine (or at least the architecture) that recorded them.
+class AnimationRecorder
+{
+public:
+    explicit AnimationRecorder(std::shared_ptr<std::ostream> const& out);
+    ~AnimationRecorder();
+
+    void record_start(
+        std::chrono::steady_clock::time_point time,
+        AnimationHandle handle,
+        AnimationDefinition const& definition,
+        std::optional<mir::geometry::Rectangle> const& from,
+        std::optional<mir::geometry::Rectangle> const& to,
+        std::optional<mir::geometry::Rectangle> const& current);
+    void record_step(std::chrono::steady_clock::time_point time, float delta_seconds);
+    void record_finish(std::chrono::steady_clock::time_point time);
+    void record_result(AnimationStepResult const& result);
+
+private:
+    std::chrono::nanoseconds relative(std::chrono::steady_clock::time_point time);
+
+    std::mutex mutex;
+    std::shared_ptr<std::ostream> out;
+    std::optional<std::chrono::steady_clock::time_point> start_time;
+};
+
+/// The outcome of replaying a trace.
+struct AnimationReplayReport
+{
+    size_t num_starts = 0;
+    size_t num_steps = 0;
+    size_t expected_results = 0;
+    size_t replayed_results = 0;
+    size_t mismatches = 0;
+    /// The index of the first result that did not match, if any
+    std::optional<size_t> first_mismatch;
+    /// The time that the replay spent in the [AnimationStore]
+    std::chrono::nanoseconds replay_time { 0 };
+
+    [[nodiscard]] bool matches() const { return mismatches == 0 && expected_results == replayed_results; }
+};
+
+/// A trace that was written by an [AnimationRecorder].
+class AnimationTrace
+{
+public:
+    /// Reads a trace from [in]. Throws if [in] does not hold a trace.
+    static AnimationTrace read(std::istream& in);
+
+    /// Runs the recorded animations through a fresh [AnimationStore] and compares what it
+    /// produces with the recorded results. Values may differ by at most [tolerance].
+    [[nodiscard]] AnimationReplayReport replay(float tolerance = 0.f) const;
+
+    [[nodiscard]] std::vector<AnimationTraceRecord> const& get_records() const { return records; }
+
+private:
+    std::vector<AnimationTraceRecord> records;
+};
+
+}
+
+#endif // MIRACLEWM_ANIMATION_TRACE_H
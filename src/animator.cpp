@@ -16,8 +16,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 **/
 
 #include "animator.h"
+#include "animation_trace.h"
 #include "config.h"
+#include "easing.h"
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <mir/server_action_queue.h>
 #define MIR_LOG_COMPONENT "animator"
 #include <mir/log.h>
@@ -26,7 +30,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <utility>
 
 using namespace miracle;
-using namespace std::chrono_literals;
 
 namespace
 {
@@ -35,6 +38,35 @@ inline glm::vec2 to_glm_vec2(mir::geometry::Point const& p)
     return { p.x.as_int(), p.y.as_int() };
 }
 
+inline glm::vec2 to_glm_vec2(mir::geometry::Size const& s)
+{
+    return { s.width.as_int(), s.height.as_int() };
+}
+
+AnimationEndpoints to_endpoints(
+    std::optional<mir::geometry::Rectangle> const& from,
+    std::optional<mir::geometry::Rectangle> const& to)
+{
+    AnimationEndpoints endpoints;
+    if (from)
+    {
+        endpoints.from_position = to_glm_vec2(from->top_left);
+        endpoints.from_size = to_glm_vec2(from->size);
+    }
+
+    if (to)
+    {
+        endpoints.to_position = to_glm_vec2(to->top_left);
+        endpoints.to_size = to_glm_vec2(to->size);
+        endpoints.has_target = true;
+    }
+
+    return endpoints;
+}
+
+/// How long an animation of [definition] takes to move between [endpoints], when it starts with [velocity].
+float settle_duration_seconds(AnimationDefinition const& definition, AnimationEndpoints const& endpoints, glm::vec4 const& velocity);
+
 inline float get_percent_complete(float target, float real)
 {
     if (target == 0)
@@ -59,8 +91,7 @@ Animation::Animation(
     std::function<void(AnimationStepResult const&)> const& callback) :
     handle { handle },
     definition { std::move(definition) },
-    to { to },
-    from { current },
+    endpoints { to_endpoints(current, to) },
     callback { callback },
     runtime_seconds { 0.f }
 {
@@ -96,227 +127,230 @@ Animation::Animation(
     default:
         break;
     }
+
+    duration_seconds = settle_duration_seconds(definition, endpoints, glm::vec4(0.f));
 }
 
 Animation& Animation::operator=(miracle::Animation const& other)
 {
     handle = other.handle;
     definition = other.definition;
-    from = other.from;
-    to = other.to;
+    endpoints = other.endpoints;
     callback = other.callback;
     runtime_seconds = other.runtime_seconds;
+    duration_seconds = other.duration_seconds;
     return *this;
 }
 
 namespace
 {
-float ease_out_bounce(AnimationDefinition const& defintion, float x)
+/// Evaluates the ease function of [definition] for [count] values of [t] and writes them to [out].
+/// Definitions from the configuration carry a lookup table, which avoids the transcendental
+/// functions of the exact curves.
+void ease(AnimationDefinition const& definition, float const* t, float* out, size_t count)
 {
-    if (x < 1 / defintion.d1)
-    {
-        return defintion.n1 * x * x;
-    }
-    else if (x < 2 / defintion.d1)
-    {
-        return defintion.n1 * (x -= 1.5f / defintion.d1) * x + 0.75f;
-    }
-    else if (x < 2.5 / defintion.d1)
-    {
-        return defintion.n1 * (x -= 2.25f / defintion.d1) * x + 0.9375f;
-    }
+    if (definition.ease_table)
+        definition.ease_table->evaluate(t, out, count);
     else
-    {
-        return defintion.n1 * (x -= 2.625f / defintion.d1) * x + 0.984375f;
-    }
+        ease_exact(definition, t, out, count);
 }
 
 inline float ease(AnimationDefinition const& defintion, float t)
 {
-    // https://easings.net/
-    switch (defintion.function)
-    {
-    case EaseFunction::linear:
-        return t;
-    case EaseFunction::ease_in_sine:
-        return 1 - cosf((t * M_PI) / 2.f);
-    case EaseFunction::ease_in_out_sine:
-        return -(cosf(M_PI * t) - 1) / 2;
-    case EaseFunction::ease_out_sine:
-        return sinf((t * M_PI) / 2.f);
-    case EaseFunction::ease_in_quad:
-        return t * t;
-    case EaseFunction::ease_out_quad:
-        return 1 - (1 - t) * (1 - t);
-    case EaseFunction::ease_in_out_quad:
-        return t < 0.5 ? 2 * t * t : 1 - powf(-2 * t + 2, 2) / 2;
-    case EaseFunction::ease_in_cubic:
-        return t * t * t;
-    case EaseFunction::ease_out_cubic:
-        return 1 - powf(1 - t, 3);
-    case EaseFunction::ease_in_out_cubic:
-        return t < 0.5 ? 4 * t * t * t : 1 - powf(-2 * t + 2, 3) / 2;
-    case EaseFunction::ease_in_quart:
-        return t * t * t * t;
-    case EaseFunction::ease_out_quart:
-        return 1 - powf(1 - t, 4);
-    case EaseFunction::ease_in_out_quart:
-        return t < 0.5 ? 8 * t * t * t * t : 1 - powf(-2 * t + 2, 4) / 2;
-    case EaseFunction::ease_in_quint:
-        return t * t * t * t * t;
-    case EaseFunction::ease_out_quint:
-        return 1 - powf(1 - t, 5);
-    case EaseFunction::ease_in_out_quint:
-        return t < 0.5 ? 16 * t * t * t * t * t : 1 - powf(-2 * t + 2, 5) / 2;
-    case EaseFunction::ease_in_expo:
-        return t == 0 ? 0 : powf(2, 10 * t - 10);
-    case EaseFunction::ease_out_expo:
-        return t == 1 ? 1 : 1 - powf(2, -10 * t);
-    case EaseFunction::ease_in_out_expo:
-        return t == 0
-            ? 0
-            : t == 1
-            ? 1
-            : t < 0.5 ? powf(2, 20 * t - 10) / 2
-                      : (2 - powf(2, -20 * t + 10)) / 2;
-    case EaseFunction::ease_in_circ:
-        return 1 - sqrtf(1 - powf(t, 2));
-    case EaseFunction::ease_out_circ:
-        return sqrtf(1 - powf(t - 1, 2));
-    case EaseFunction::ease_in_out_circ:
-        return t < 0.5f
-            ? (1 - sqrtf(1 - powf(2 * t, 2))) / 2
-            : (sqrtf(1 - powf(-2 * t + 2, 2)) + 1) / 2;
-    case EaseFunction::ease_in_back:
-        return defintion.c3 * t * t * t - defintion.c1 * t * t;
-    case EaseFunction::ease_out_back:
-    {
-        return 1 + defintion.c3 * powf(t - 1, 3) + defintion.c1 * powf(t - 1, 2);
-    }
-    case EaseFunction::ease_in_out_back:
-        return t < 0.5
-            ? (powf(2 * t, 2) * ((defintion.c2 + 1) * 2 * t - defintion.c2)) / 2
-            : (powf(2 * t - 2, 2) * ((defintion.c2 + 1) * (t * 2 - 2) + defintion.c2) + 2) / 2;
-    case EaseFunction::ease_in_elastic:
-        return t == 0
-            ? 0
-            : t == 1
-            ? 1
-            : -powf(2, 10 * t - 10) * sinf((t * 10 - 10.75f) * defintion.c4);
-    case EaseFunction::ease_out_elastic:
-        return t == 0
-            ? 0
-            : t == 1
-            ? 1
-            : powf(2, -10 * t) * sinf((t * 10 - 0.75f) * defintion.c4) + 1;
-    case EaseFunction::ease_in_out_elastic:
-        return t == 0
-            ? 0
-            : t == 1
-            ? 1
-            : t < 0.5
-            ? -(powf(2, 20 * t - 10) * sinf((20 * t - 11.125f) * defintion.c5)) / 2
-            : (powf(2, -20 * t + 10) * sinf((20 * t - 11.125f) * defintion.c5)) / 2 + 1;
-    case EaseFunction::ease_in_bounce:
-        return 1 - ease_out_bounce(defintion, 1 - t);
-    case EaseFunction::ease_out_bounce:
-        return ease_out_bounce(defintion, t);
-    case EaseFunction::ease_in_out_bounce:
-        return t < 0.5
-            ? (1 - ease_out_bounce(defintion, 1 - 2 * t)) / 2
-            : (1 + ease_out_bounce(defintion, 2 * t - 1)) / 2;
-    default:
-        return 1.f;
-    }
+    float result;
+    ease(defintion, &t, &result, 1);
+    return result;
+}
+
 }
 
-inline float interpolate_scale(float p, float start, float end)
+namespace
+{
+AnimationStepResult complete(AnimationHandle handle, AnimationEndpoints const& endpoints)
 {
-    float diff = end - start;
-    float current = start + diff * p;
-    float percent_traveled = current / end;
-    if (percent_traveled < 0)
-        percent_traveled *= -1;
-    return percent_traveled;
+    return {
+        handle,
+        true,
+        !endpoints.has_target ? std::nullopt : std::optional<glm::vec2>(endpoints.to_position),
+        !endpoints.has_target ? std::nullopt : std::optional<glm::vec2>(endpoints.to_size),
+        glm::mat4(1.f),
+    };
 }
 
+/// Maps the final rectangle of [endpoints] onto the rectangle at [position] with [size]. The
+/// transform is applied around the centre of the window.
+glm::mat4 transform_from_target(AnimationEndpoints const& endpoints, glm::vec2 position, glm::vec2 size)
+{
+    glm::vec2 const scale(
+        endpoints.to_size.x == 0 ? 1.f : size.x / endpoints.to_size.x,
+        endpoints.to_size.y == 0 ? 1.f : size.y / endpoints.to_size.y);
+    glm::vec2 const offset = position - endpoints.to_position + (scale - glm::vec2(1.f, 1.f)) * endpoints.to_size / 2.f;
+    return glm::scale(
+        glm::translate(glm::vec3(offset.x, offset.y, 0.f)),
+        glm::vec3(scale.x, scale.y, 1.f));
 }
 
-AnimationStepResult Animation::init()
+/// The result of a window that is drawn at [position] with [size] on its way to the target of [endpoints].
+AnimationStepResult moving_result(
+    AnimationHandle handle,
+    AnimationDefinition const& definition,
+    glm::vec2 position,
+    glm::vec2 size,
+    AnimationEndpoints const& endpoints)
 {
-    switch (definition.type)
+    if (definition.transform_only)
     {
-    case AnimationType::grow:
-        return { handle, false, {}, {}, glm::mat4(0.f) };
-    case AnimationType::shrink:
-        return { handle, false, {}, {}, glm::mat4(1.f) };
-    case AnimationType::disabled:
-        return {
-            handle,
-            true,
-            !to.has_value() ? std::nullopt : std::optional<glm::vec2>(glm::vec2(to.value().top_left.x.as_int(), to.value().top_left.y.as_int())),
-            !to.has_value() ? std::nullopt : std::optional<glm::vec2>(glm::vec2(to.value().size.width.as_int(), to.value().size.height.as_int())),
-            glm::mat4(1.f),
-        };
-    default:
-        return { handle, false, {}, {}, {} };
+        // The window already has its final rectangle, so only the transform changes
+        return { handle, false, std::nullopt, std::nullopt, transform_from_target(endpoints, position, size) };
     }
+
+    float x_scale = std::abs(size.x / endpoints.to_size.x);
+    float y_scale = std::abs(size.y / endpoints.to_size.y);
+
+    glm::vec3 translate(
+        -endpoints.to_size.x / 2.f,
+        -endpoints.to_size.y / 2.f,
+        0);
+    auto inverse_translate = -translate;
+    glm::mat4 scale_matrix = glm::translate(
+        glm::scale(
+            glm::translate(translate),
+            glm::vec3(x_scale, y_scale, 1.f)),
+        inverse_translate);
+
+    return {
+        handle,
+        false,
+        position,
+        endpoints.to_size,
+        scale_matrix
+    };
+}
+
+/// The position and size of [endpoints] packed as (x, y, width, height), so that springs
+/// can treat them as four independent channels.
+inline glm::vec4 from_channels(AnimationEndpoints const& endpoints)
+{
+    return { endpoints.from_position.x, endpoints.from_position.y, endpoints.from_size.x, endpoints.from_size.y };
+}
+
+inline glm::vec4 to_channels(AnimationEndpoints const& endpoints)
+{
+    return { endpoints.to_position.x, endpoints.to_position.y, endpoints.to_size.x, endpoints.to_size.y };
+}
+
+struct SpringState
+{
+    glm::vec4 displacement;
+    glm::vec4 velocity;
+};
+
+inline float spring_frequency(AnimationDefinition const& definition)
+{
+    return std::sqrt(std::max(definition.stiffness, 1.f));
+}
+
+/// Evaluates a critically damped spring with unit mass at [t] seconds after it was
+/// [displacement] away from its target and moving at [velocity]:
+///   x(t) = (x0 + (v0 + w * x0) * t) * e^(-w * t)
+SpringState evaluate_spring(float frequency, float t, glm::vec4 const& displacement, glm::vec4 const& velocity)
+{
+    float const decay = std::exp(-frequency * t);
+    glm::vec4 const b = velocity + displacement * frequency;
+    return {
+        (displacement + b * t) * decay,
+        (velocity - b * (frequency * t)) * decay
+    };
 }
 
-AnimationStepResult Animation::step()
+/// A spring is considered to be at rest once it is closer than this to its target, in pixels.
+constexpr float spring_rest_distance = 0.5f;
+constexpr float max_spring_seconds = 10.f;
+
+/// The lower branch of the Lambert W function, which solves w * e^w = x for w <= -1,
+/// defined for x in [-1/e, 0). Starts from a series near the branch point or the
+/// asymptotic expansion near 0, and refines it with a fixed two Halley steps.
+float lambert_w_lower(float x)
 {
-    runtime_seconds += Animator::timestep_seconds;
-    if (runtime_seconds >= definition.duration_seconds)
+    double w;
+    if (x < -0.25f)
     {
-        return {
-            handle,
-            true,
-            !to.has_value() ? std::nullopt : std::optional<glm::vec2>(glm::vec2(to.value().top_left.x.as_int(), to.value().top_left.y.as_int())),
-            !to.has_value() ? std::nullopt : std::optional<glm::vec2>(glm::vec2(to.value().size.width.as_int(), to.value().size.height.as_int())),
-            glm::mat4(1.f),
-        };
+        double const p = -std::sqrt(2.0 * (1.0 + M_E * x));
+        w = -1.0 + p - p * p / 3.0 + 11.0 / 72.0 * p * p * p;
+    }
+    else
+    {
+        double const l1 = std::log(-x);
+        double const l2 = std::log(-l1);
+        w = l1 - l2 + l2 / l1;
     }
 
-    float t = (runtime_seconds / definition.duration_seconds);
-    switch (definition.type)
+    for (int i = 0; i < 2; i++)
     {
-    case AnimationType::slide:
+        double const ew = std::exp(w);
+        double const f = w * ew - x;
+        w -= f / (ew * (w + 1.0) - (w + 2.0) * f / (2.0 * w + 2.0));
+    }
+
+    return (float)w;
+}
+
+/// The time it takes for a spring to come to rest. Every channel is bounded by the
+/// envelope (a + b * t) * e^(-w * t) of the channel with the largest displacement and
+/// speed, which reaches the rest distance at t = -W(-k) / w - a / b, where W is the lower
+/// branch of the Lambert W function and k = (rest distance) * w / b * e^(-w * a / b).
+float spring_settle_seconds(float frequency, glm::vec4 const& displacement, glm::vec4 const& velocity)
+{
+    float a = 0.f;
+    float speed = 0.f;
+    for (int i = 0; i < 4; i++)
     {
-        auto p = ease(definition, t);
-        auto distance = to.value().top_left - from.value().top_left;
-        float x = (float)distance.dx.as_int() * p;
-        float y = (float)distance.dy.as_int() * p;
+        a = std::max(a, std::abs(displacement[i]));
+        speed = std::max(speed, std::abs(velocity[i]));
+    }
 
-        glm::vec2 position = {
-            (float)from.value().top_left.x.as_int() + x,
-            (float)from.value().top_left.y.as_int() + y
-        };
+    float const b = speed + frequency * a;
+    if (b <= 0.f)
+        return 0.f;
 
-        float x_scale = interpolate_scale(p, static_cast<float>(from->size.width.as_value()), static_cast<float>(to->size.width.as_value()));
-        float y_scale = interpolate_scale(p, static_cast<float>(from->size.height.as_value()), static_cast<float>(to->size.height.as_value()));
+    // The envelope peaks at (b / w) * e^(a * w / b - 1), and k >= 1 / e exactly when that peak
+    // is within the rest distance. A large k thus means that the spring is already at rest.
+    double const k = spring_rest_distance * frequency / b * std::exp(-frequency * a / b);
+    if (k >= 1.0 / M_E)
+        return 0.f;
 
-        glm::vec3 translate(
-            (float)-to->size.width.as_value() / 2.f,
-            (float)-to->size.height.as_value() / 2.f,
-            0);
-        auto inverse_translate = -translate;
-        glm::mat4 scale_matrix = glm::translate(
-            glm::scale(
-                glm::translate(translate),
-                glm::vec3(x_scale, y_scale, 1.f)),
-            inverse_translate);
+    float const t = -lambert_w_lower((float)-k) / frequency - a / b;
+    return std::clamp(t, 0.f, max_spring_seconds);
+}
 
-        return {
-            handle,
-            false,
-            position,
-            glm::vec2(to.value().size.width.as_int(), to.value().size.height.as_int()),
-            scale_matrix
-        };
+/// Produces the result of an animation of [definition]. Eased animations are [p] of the way
+/// through their curve. Springs have been running for [runtime_seconds] since they started
+/// at the start of [endpoints] with [velocity].
+AnimationStepResult evaluate(
+    AnimationHandle handle,
+    AnimationDefinition const& definition,
+    float p,
+    float runtime_seconds,
+    glm::vec4 const& velocity,
+    AnimationEndpoints const& endpoints)
+{
+    switch (definition.type)
+    {
+    case AnimationType::slide:
+    {
+        glm::vec2 position = endpoints.from_position + (endpoints.to_position - endpoints.from_position) * p;
+        glm::vec2 size = endpoints.from_size + (endpoints.to_size - endpoints.from_size) * p;
+        return moving_result(handle, definition, position, size, endpoints);
+    }
+    case AnimationType::spring:
+    {
+        auto const target = to_channels(endpoints);
+        auto const state = evaluate_spring(spring_frequency(definition), runtime_seconds, from_channels(endpoints) - target, velocity);
+        auto const current = target + state.displacement;
+        return moving_result(handle, definition, { current.x, current.y }, { current.z, current.w }, endpoints);
     }
     case AnimationType::grow:
     {
-        auto p = ease(definition, t);
         glm::mat4 transform(
             p, 0, 0, 0,
             0, p, 0, 0,
@@ -326,7 +360,7 @@ AnimationStepResult Animation::step()
     }
     case AnimationType::shrink:
     {
-        auto p = 1.f - ease(definition, t);
+        p = 1.f - p;
         glm::mat4 transform(
             p, 0, 0, 0,
             0, p, 0, 0,
@@ -334,6 +368,8 @@ AnimationStepResult Animation::step()
             0, 0, 0, 1);
         return { handle, false, std::nullopt, std::nullopt, transform };
     }
+    case AnimationType::fade:
+        return { handle, false, std::nullopt, std::nullopt, std::nullopt, std::clamp(1.f - p, 0.f, 1.f) };
     case AnimationType::disabled:
     default:
         return {
@@ -346,16 +382,287 @@ AnimationStepResult Animation::step()
     }
 }
 
+AnimationStepResult initial_result(
+    AnimationHandle handle,
+    AnimationDefinition const& definition,
+    float runtime_seconds,
+    float duration_seconds,
+    glm::vec4 const& velocity,
+    AnimationEndpoints const& endpoints)
+{
+    switch (definition.type)
+    {
+    case AnimationType::grow:
+        return { handle, false, {}, {}, glm::mat4(0.f) };
+    case AnimationType::shrink:
+        return { handle, false, {}, {}, glm::mat4(1.f) };
+    case AnimationType::fade:
+        return { handle, false, {}, {}, {}, 1.f };
+    case AnimationType::disabled:
+        return complete(handle, endpoints);
+    case AnimationType::slide:
+    case AnimationType::spring:
+    {
+        if (!definition.transform_only || duration_seconds <= 0)
+            return { handle, false, {}, {}, {} };
+
+        // Move the window to where it is going once, and draw it where it currently is
+        auto const p = ease(definition, runtime_seconds / duration_seconds);
+        auto result = evaluate(handle, definition, p, runtime_seconds, velocity, endpoints);
+        result.position = endpoints.to_position;
+        result.size = endpoints.to_size;
+        return result;
+    }
+    default:
+        return { handle, false, {}, {}, {} };
+    }
+}
+
+float settle_duration_seconds(AnimationDefinition const& definition, AnimationEndpoints const& endpoints, glm::vec4 const& velocity)
+{
+    if (definition.type != AnimationType::spring)
+        return definition.duration_seconds;
+
+    return spring_settle_seconds(
+        spring_frequency(definition),
+        from_channels(endpoints) - to_channels(endpoints),
+        velocity);
+}
+
+/// Where a moving window is drawn and how fast it is moving, as (x, y, width, height) channels.
+struct Motion
+{
+    glm::vec4 channels;
+    glm::vec4 velocity;
+};
+
+/// Returns the motion of a slide or spring that has been running for [runtime_seconds].
+std::optional<Motion> get_motion(
+    AnimationDefinition const& definition,
+    AnimationEndpoints const& endpoints,
+    float runtime_seconds,
+    float duration_seconds,
+    glm::vec4 const& velocity)
+{
+    auto const from = from_channels(endpoints);
+    auto const to = to_channels(endpoints);
+    switch (definition.type)
+    {
+    case AnimationType::slide:
+    {
+        if (duration_seconds <= 0)
+            return Motion { to, glm::vec4(0.f) };
+
+        // The speed of an eased curve is estimated from the slope of the curve
+        constexpr float h = 0.001f;
+        float const t = std::clamp(runtime_seconds / duration_seconds, 0.f, 1.f);
+        float const p = ease(definition, t);
+        float const slope = (ease(definition, std::min(t + h, 1.f)) - ease(definition, std::max(t - h, 0.f)))
+            / (std::min(t + h, 1.f) - std::max(t - h, 0.f));
+        return Motion { from + (to - from) * p, (to - from) * (slope / duration_seconds) };
+    }
+    case AnimationType::spring:
+    {
+        auto const state = evaluate_spring(spring_frequency(definition), runtime_seconds, from - to, velocity);
+        return Motion { to + state.displacement, state.velocity };
+    }
+    default:
+        return std::nullopt;
+    }
+}
+
+/// True if [a] and [b] can be eased in the same batch.
+bool has_same_curve(AnimationDefinition const& a, AnimationDefinition const& b)
+{
+    return a.function == b.function
+        && a.c1 == b.c1 && a.c2 == b.c2 && a.c3 == b.c3 && a.c4 == b.c4 && a.c5 == b.c5
+        && a.n1 == b.n1 && a.d1 == b.d1
+        && a.ease_table == b.ease_table;
+}
+}
+
+AnimationStepResult Animation::init() const
+{
+    return initial_result(handle, definition, runtime_seconds, duration_seconds, glm::vec4(0.f), endpoints);
+}
+
+AnimationStepResult Animation::step(float delta_seconds)
+{
+    runtime_seconds += delta_seconds;
+    if (runtime_seconds >= duration_seconds)
+        return complete(handle, endpoints);
+
+    float t = (runtime_seconds / duration_seconds);
+    return evaluate(handle, definition, ease(definition, t), runtime_seconds, glm::vec4(0.f), endpoints);
+}
+
+AnimationStepResult AnimationStore::insert(Animation const& animation)
+{
+    auto const handle = animation.get_handle();
+    if (handle >= slot_by_handle.size())
+        slot_by_handle.resize(handle + 1, no_slot);
+
+    auto const slot = slot_by_handle[handle];
+    if (slot != no_slot)
+    {
+        assign(slot, animation);
+        return initial_result(handle, definitions[slot], runtime_seconds[slot], duration_seconds[slot], velocities[slot], endpoints[slot]);
+    }
+
+    slot_by_handle[handle] = handles.size();
+    handles.push_back(handle);
+    runtime_seconds.push_back(0.f);
+    duration_seconds.push_back(0.f);
+    progress.push_back(0.f);
+    types.push_back(AnimationType::disabled);
+    definitions.push_back({});
+    endpoints.push_back({});
+    velocities.push_back(glm::vec4(0.f));
+    callbacks.push_back(nullptr);
+    assign(handles.size() - 1, animation);
+    in_flight = true;
+    return animation.init();
+}
+
+void AnimationStore::assign(size_t slot, Animation const& animation)
+{
+    auto const& definition = animation.get_definition();
+    auto next_endpoints = animation.get_endpoints();
+
+    // A move that interrupts a move continues from where the window is drawn right now.
+    // The window's own rectangle has the previous target size, with the interpolated size
+    // only applied as a transform, so we use the interpolated geometry instead. Springs
+    // also keep the velocity of the previous move so that the motion stays smooth.
+    float runtime = animation.get_runtime_seconds();
+    glm::vec4 velocity(0.f);
+    bool const is_move = definition.type == AnimationType::slide || definition.type == AnimationType::spring;
+    if (auto const motion = get_motion(definitions[slot], endpoints[slot], runtime_seconds[slot], duration_seconds[slot], velocities[slot]);
+        motion && is_move)
+    {
+        next_endpoints.from_position = { motion->channels.x, motion->channels.y };
+        next_endpoints.from_size = { motion->channels.z, motion->channels.w };
+        if (definition.type == AnimationType::spring)
+        {
+            velocity = motion->velocity;
+            runtime = 0.f;
+        }
+    }
+
+    runtime_seconds[slot] = runtime;
+    duration_seconds[slot] = settle_duration_seconds(definition, next_endpoints, velocity);
+    progress[slot] = 0.f;
+    types[slot] = definition.type;
+    definitions[slot] = definition;
+    endpoints[slot] = next_endpoints;
+    velocities[slot] = velocity;
+    callbacks[slot] = std::make_shared<Callback const>(animation.get_callback());
+}
+
+void AnimationStore::step(float delta_seconds, std::vector<Update>& out)
+{
+    auto const count = handles.size();
+    for (size_t slot = 0; slot < count; slot++)
+        runtime_seconds[slot] += delta_seconds;
+
+    for (size_t slot = 0; slot < count; slot++)
+        progress[slot] = runtime_seconds[slot] / duration_seconds[slot];
+
+    // Animations for the same event share a curve, so slots are eased in runs of equal curves.
+    for (size_t begin = 0; begin < count;)
+    {
+        auto end = begin + 1;
+        while (end < count && has_same_curve(definitions[begin], definitions[end]))
+            end++;
+
+        ease(definitions[begin], progress.data() + begin, progress.data() + begin, end - begin);
+        begin = end;
+    }
+
+    auto const first = out.size();
+    for (size_t slot = 0; slot < count; slot++)
+    {
+        if (runtime_seconds[slot] >= duration_seconds[slot])
+            out.push_back({ complete(handles[slot], endpoints[slot]), callbacks[slot] });
+        else
+        {
+            auto result = evaluate(
+                handles[slot], definitions[slot], progress[slot], runtime_seconds[slot], velocities[slot], endpoints[slot]);
+            out.push_back({ result, callbacks[slot] });
+        }
+    }
+
+    // Walk backwards so that the slot moved into a removed slot has already been visited
+    for (size_t slot = count; slot-- > 0;)
+    {
+        if (out[first + slot].result.is_complete)
+            remove(slot);
+    }
+}
+
+void AnimationStore::finish(std::vector<Update>& out)
+{
+    for (size_t slot = 0; slot < handles.size(); slot++)
+    {
+        out.push_back({ complete(handles[slot], endpoints[slot]), callbacks[slot] });
+        slot_by_handle[handles[slot]] = no_slot;
+    }
+
+    handles.clear();
+    runtime_seconds.clear();
+    duration_seconds.clear();
+    progress.clear();
+    types.clear();
+    definitions.clear();
+    endpoints.clear();
+    velocities.clear();
+    callbacks.clear();
+    in_flight = false;
+}
+
+void AnimationStore::remove(size_t slot)
+{
+    auto const last = handles.size() - 1;
+    slot_by_handle[handles[slot]] = no_slot;
+    if (slot != last)
+    {
+        slot_by_handle[handles[last]] = slot;
+        handles[slot] = handles[last];
+        runtime_seconds[slot] = runtime_seconds[last];
+        duration_seconds[slot] = duration_seconds[last];
+        progress[slot] = progress[last];
+        types[slot] = types[last];
+        definitions[slot] = definitions[last];
+        endpoints[slot] = endpoints[last];
+        velocities[slot] = velocities[last];
+        callbacks[slot] = std::move(callbacks[last]);
+    }
+
+    handles.pop_back();
+    runtime_seconds.pop_back();
+    duration_seconds.pop_back();
+    progress.pop_back();
+    types.pop_back();
+    definitions.pop_back();
+    endpoints.pop_back();
+    velocities.pop_back();
+    callbacks.pop_back();
+    if (handles.empty())
+        in_flight = false;
+}
+
 Animator::Animator(
     std::shared_ptr<mir::ServerActionQueue> const& server_action_queue,
-    std::shared_ptr<Config> const& config) :
+    std::shared_ptr<Config> const& config,
+    std::shared_ptr<AnimationClock> const& time_source) :
     server_action_queue { server_action_queue },
-    config { config }
+    config { config },
+    time_source { time_source }
 {
 }
 
 void Animator::start()
 {
+    running = true;
     run_thread = std::thread([&]()
     { run(); });
 }
@@ -370,21 +677,32 @@ AnimationHandle Animator::register_animateable()
     return next_handle++;
 }
 
-void Animator::append(miracle::Animation&& animation)
+void Animator::append(
+    AnimationHandle handle,
+    AnimationDefinition const& definition,
+    std::optional<mir::geometry::Rectangle> const& from,
+    std::optional<mir::geometry::Rectangle> const& to,
+    std::optional<mir::geometry::Rectangle> const& current,
+    std::function<void(AnimationStepResult const&)> const& callback)
 {
     std::lock_guard<std::mutex> lock(processing_lock);
-    for (auto it = queued_animations.begin(); it != queued_animations.end();)
+    auto const now = time_source->now();
+    if (store.empty())
     {
-        if (it->get_handle() == animation.get_handle())
-        {
-            it = queued_animations.erase(it);
-        }
-        else
-            it++;
+        last_step_time = now;
+        budget.set_budget_ms(config->get_animation_budget_ms());
+        if (auto const event = budget.resume(last_step_time))
+            mir::log_info("Animations recovered from '%s' to '%s'", to_string(event->from), to_string(event->to));
+    }
+
+    auto const result = store.insert(Animation(handle, definition, from, to, current, callback));
+    if (recorder)
+    {
+        recorder->record_start(now, handle, definition, from, to, current);
+        recorder->record_result(result);
     }
 
-    animation.get_callback()(animation.init());
-    queued_animations.push_back(animation);
+    callback(result);
     cv.notify_one();
 }
 
@@ -395,9 +713,9 @@ void Animator::window_move(
     mir::geometry::Rectangle const& current,
     std::function<void(AnimationStepResult const&)> const& callback)
 {
-    // If animations aren't enabled, let's give them the position that
-    // they want to go to immediately and don't bother animating anything.
-    if (!config->are_animations_enabled())
+    // If animations aren't enabled (or are too expensive right now), let's give them the
+    // position that they want to go to immediately and don't bother animating anything.
+    if (should_snap())
     {
         callback(
             { handle,
@@ -408,34 +726,58 @@ void Animator::window_move(
         return;
     }
 
-    append(Animation(
+    // Under load, windows are only moved once rather than on every step
+    auto definition = config->get_animation_definitions()[(int)AnimateableEvent::window_move];
+    if (budget.get_level() >= AnimationDegradation::transform_only)
+        definition.transform_only = true;
+
+    append(
         handle,
-        config->get_animation_definitions()[(int)AnimateableEvent::window_move],
+        definition,
         from,
         to,
         current,
-        callback));
+        callback);
 }
 
 void Animator::window_open(
     AnimationHandle handle,
     std::function<void(AnimationStepResult const&)> const& callback)
 {
-    // If animations aren't enabled, let's give them the position that
-    // they want to go to immediately and don't bother animating anything.
-    if (!config->are_animations_enabled())
+    // If animations aren't enabled (or are too expensive right now), let's give them the
+    // position that they want to go to immediately and don't bother animating anything.
+    if (should_snap())
     {
         callback({ handle, true });
         return;
     }
 
-    append(Animation(
+    append(
         handle,
         config->get_animation_definitions()[(int)AnimateableEvent::window_open],
         std::nullopt,
         std::nullopt,
         std::nullopt,
-        callback));
+        callback);
+}
+
+void Animator::window_close(
+    AnimationHandle handle,
+    std::function<void(AnimationStepResult const&)> const& callback)
+{
+    if (should_snap())
+    {
+        callback({ handle, true });
+        return;
+    }
+
+    append(
+        handle,
+        config->get_animation_definitions()[(int)AnimateableEvent::window_close],
+        std::nullopt,
+        std::nullopt,
+        std::nullopt,
+        callback);
 }
 
 void Animator::workspace_switch(
@@ -445,7 +787,7 @@ void Animator::workspace_switch(
     mir::geometry::Rectangle const& current,
     std::function<void(AnimationStepResult const&)> const& callback)
 {
-    if (!config->are_animations_enabled())
+    if (should_snap())
     {
         callback(
             { handle,
@@ -456,81 +798,241 @@ void Animator::workspace_switch(
         return;
     }
 
-    append(Animation(
+    // The output itself is moved during a switch, so there is no window to transform
+    auto definition = config->get_animation_definitions()[(int)AnimateableEvent::workspace_switch];
+    definition.transform_only = false;
+    append(
         handle,
-        config->get_animation_definitions()[(int)AnimateableEvent::workspace_switch],
+        definition,
         from,
         to,
         current,
-        callback));
+        callback);
 }
 
 namespace
 {
-struct PendingUpdateData
-{
-    AnimationStepResult result;
-    std::function<void(miracle::AnimationStepResult const&)> callback;
-};
+/// Frames further apart than this are not considered to be part of the same stream of frames.
+constexpr std::chrono::milliseconds max_frame_interval(100);
+
+/// Outputs that have not drawn a frame for this long are forgotten.
+constexpr std::chrono::seconds stale_stream_period(10);
+
+/// A single step never advances animations by more than this, so that an animation that
+/// was stalled (e.g. because the output was off) does not skip ahead unexpectedly.
+constexpr float max_step_seconds = 0.1f;
 }
 
 void Animator::run()
 {
-    using clock = std::chrono::high_resolution_clock;
-    constexpr std::chrono::nanoseconds timestep(16ms);
-    std::chrono::nanoseconds lag(0ns);
-    auto time_start = clock::now();
-    running = true;
-
+    std::unique_lock lock(processing_lock);
     while (running)
     {
+        if (store.empty())
         {
-            std::unique_lock lock(processing_lock);
-            if (queued_animations.empty())
-            {
-                cv.wait(lock);
-                time_start = clock::now();
-            }
+            cv.wait(lock, [&]
+            { return !running || !store.empty(); });
+            continue;
+        }
+
+        // Frames normally advance the animations. We only step here if they have stopped arriving,
+        // which also covers the start of an animation, before anything on screen has changed.
+        auto const deadline = last_step_time + get_fallback_interval();
+        if (time_source->now() < deadline)
+        {
+            cv.wait_for(lock, deadline - time_source->now());
+            continue;
         }
 
-        auto delta_time = clock::now() - time_start;
-        time_start = clock::now();
-        lag += std::chrono::duration_cast<std::chrono::nanoseconds>(delta_time);
+        auto const now = time_source->now();
+        auto const delta = std::chrono::duration<float>(now - last_step_time).count();
+        last_step_time = now;
+        advance_locked(std::min(delta, max_step_seconds), std::nullopt);
+        lock.unlock();
+        dispatch();
+        lock.lock();
+    }
+}
 
-        while (lag >= timestep)
+void Animator::on_frame(
+    clock::time_point frame_time,
+    void const* source,
+    std::optional<clock::duration> refresh_period)
+{
+    {
+        std::lock_guard lock(processing_lock);
+        std::optional<AnimationBudget::FrameTiming> timing;
+        auto const [it, is_new_stream] = frame_streams.try_emplace(source);
+        auto& stream = it->second;
+        if (!is_new_stream && frame_time > stream.last_frame_time)
         {
-            lag -= timestep;
-            step();
+            auto const interval = frame_time - stream.last_frame_time;
+            if (interval < max_frame_interval)
+            {
+                stream.frame_interval = stream.frame_interval == clock::duration::zero()
+                    ? interval
+                    : (stream.frame_interval * 7 + interval) / 8;
+
+                // An estimated refresh period drifts towards slower intervals so that a change of display mode is picked up
+                if (refresh_period)
+                    stream.refresh_period = refresh_period;
+                else if (!stream.refresh_period || interval < stream.refresh_period.value())
+                    stream.refresh_period = interval;
+                else
+                    stream.refresh_period = stream.refresh_period.value() + (interval - stream.refresh_period.value()) / 64;
+
+                timing = AnimationBudget::FrameTiming { interval, stream.refresh_period.value() };
+            }
         }
+        stream.last_frame_time = frame_time;
+
+        // Forget outputs that have stopped drawing
+        std::erase_if(frame_streams, [&](auto const& entry)
+        { return frame_time - entry.second.last_frame_time > stale_stream_period; });
+
+        if (store.empty() || frame_time <= last_step_time)
+            return;
+
+        auto const delta = std::chrono::duration<float>(frame_time - last_step_time).count();
+        last_step_time = frame_time;
+        advance_locked(std::min(delta, max_step_seconds), timing);
+    }
+
+    dispatch();
+}
+
+Animator::clock::duration Animator::get_fallback_interval() const
+{
+    auto const timestep = std::chrono::duration_cast<clock::duration>(std::chrono::duration<float>(timestep_seconds));
+    auto const now = time_source->now();
+    std::optional<clock::duration> frame_interval;
+    for (auto const& [source, stream] : frame_streams)
+    {
+        if (now - stream.last_frame_time >= max_frame_interval || stream.frame_interval == clock::duration::zero())
+            continue;
+
+        if (!frame_interval || stream.frame_interval < frame_interval.value())
+            frame_interval = stream.frame_interval;
     }
+
+    if (!frame_interval)
+        return timestep;
+
+    // Leave plenty of room for the next frame so that we do not step in between frames
+    return std::max(timestep, frame_interval.value() * 3 / 2);
+}
+
+bool Animator::is_animating() const
+{
+    return store.has_animations_in_flight();
 }
 
 void Animator::step()
 {
-    std::vector<PendingUpdateData> update_data;
     {
-        std::lock_guard<std::mutex> lock(processing_lock);
-        for (auto it = queued_animations.begin(); it != queued_animations.end();)
+        std::lock_guard lock(processing_lock);
+        last_step_time = time_source->now();
+        advance_locked(timestep_seconds, std::nullopt);
+    }
+
+    dispatch();
+}
+
+void Animator::advance_locked(float delta_seconds, std::optional<AnimationBudget::FrameTiming> const& frame)
+{
+    auto const start = time_source->now();
+    auto const first_update = pending_updates.size();
+    store.step(delta_seconds, pending_updates);
+    auto const end = time_source->now();
+    budget.add_cost(end - start);
+    if (recorder)
+    {
+        recorder->record_step(last_step_time, delta_seconds);
+        for (size_t i = first_update; i < pending_updates.size(); i++)
+            recorder->record_result(pending_updates[i].result);
+    }
+
+    auto const event = budget.end_frame(frame, end);
+    if (!event)
+        return;
+
+    mir::log_info(
+        "Animations degraded from '%s' to '%s': %.2fms spent on animations in the last frame (budget %.2fms), %.2fms between frames",
+        to_string(event->from),
+        to_string(event->to),
+        event->frame_cost_ms,
+        config->get_animation_budget_ms(),
+        event->frame_interval_ms);
+    if (event->to == AnimationDegradation::snap)
+    {
+        auto const first_update = pending_updates.size();
+        store.finish(pending_updates);
+        if (recorder)
         {
-            auto& item = *it;
-            auto result = item.step();
-
-            update_data.push_back({ result, item.get_callback() });
-            if (result.is_complete)
-                it = queued_animations.erase(it);
-            else
-                it++;
+            recorder->record_finish(end);
+            for (size_t i = first_update; i < pending_updates.size(); i++)
+                recorder->record_result(pending_updates[i].result);
         }
     }
+}
 
-    server_action_queue->enqueue(this, [&, update_data]()
+void Animator::set_recorder(std::shared_ptr<AnimationRecorder> const& next)
+{
+    std::lock_guard lock(processing_lock);
+    recorder = next;
+}
+
+bool Animator::should_snap() const
+{
+    return !config->are_animations_enabled() || budget.get_level() == AnimationDegradation::snap;
+}
+
+void Animator::dispatch()
+{
     {
-        if (!running)
+        std::lock_guard lock(processing_lock);
+        if (pending_updates.empty() || is_delivery_scheduled)
             return;
 
-        for (auto const& update_item : update_data)
-            update_item.callback(update_item.result);
-    });
+        is_delivery_scheduled = true;
+    }
+
+    // Only [this] is captured so that enqueuing the action does not allocate
+    server_action_queue->enqueue(this, [this]()
+    { deliver(); });
+}
+
+void Animator::deliver()
+{
+    std::lock_guard delivery(delivery_lock);
+    {
+        std::lock_guard lock(processing_lock);
+        is_delivery_scheduled = false;
+        std::swap(pending_updates, delivering_updates);
+    }
+
+    if (running)
+    {
+        // Applying the results is usually the most expensive part of an animation, so it counts towards the budget
+        auto const start = time_source->now();
+        if (batch_listener)
+            batch_listener->begin_batch();
+
+        for (auto const& update : delivering_updates)
+            (*update.callback)(update.result);
+
+        if (batch_listener)
+            batch_listener->end_batch();
+        budget.add_cost(time_source->now() - start);
+    }
+
+    delivering_updates.clear();
+}
+
+void Animator::set_batch_listener(AnimationBatchListener* listener)
+{
+    std::lock_guard lock(delivery_lock);
+    batch_listener = listener;
 }
 
 void Animator::stop()
@@ -538,7 +1040,10 @@ void Animator::stop()
     if (!running)
         return;
 
-    running = false;
+    {
+        std::lock_guard lock(processing_lock);
+        running = false;
+    }
     cv.notify_one();
     run_thread.join();
 }
@@ -18,7 +18,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIRACLEWM_ANIMATOR_H
 #define MIRACLEWM_ANIMATOR_H
 
+#include "animation_budget.h"
+#include "animation_clock.h"
 #include "animation_defintion.h"
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <glm/glm.hpp>
@@ -26,6 +30,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <mutex>
 #include <optional>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace mir
 {
@@ -35,6 +41,7 @@ class ServerActionQueue;
 namespace miracle
 {
 class Config;
+class AnimationRecorder;
 
 /// Unique handle provided to track animators
 typedef uint32_t AnimationHandle;
@@ -50,6 +57,19 @@ struct AnimationStepResult
     std::optional<glm::vec2> position;
     std::optional<glm::vec2> size;
     std::optional<glm::mat4> transform;
+    std::optional<float> alpha;
+};
+
+/// The geometry that an animation moves between.
+struct AnimationEndpoints
+{
+    glm::vec2 from_position { 0.f, 0.f };
+    glm::vec2 from_size { 0.f, 0.f };
+    glm::vec2 to_position { 0.f, 0.f };
+    glm::vec2 to_size { 0.f, 0.f };
+
+    /// False for animations that do not move the window, such as [AnimationType::grow]
+    bool has_target = false;
 };
 
 class Animation
@@ -65,29 +85,106 @@ public:
 
     Animation& operator=(Animation const& other);
 
-    AnimationStepResult init();
-    AnimationStepResult step();
+    AnimationStepResult init() const;
+    /// Advances the animation by [delta_seconds] of real time.
+    AnimationStepResult step(float delta_seconds);
     [[nodiscard]] std::function<void(AnimationStepResult const&)> const& get_callback() const { return callback; }
     [[nodiscard]] AnimationHandle get_handle() const { return handle; }
+    [[nodiscard]] AnimationDefinition const& get_definition() const { return definition; }
+    [[nodiscard]] AnimationEndpoints const& get_endpoints() const { return endpoints; }
     float get_runtime_seconds() const { return runtime_seconds; }
+    float get_duration_seconds() const { return duration_seconds; }
 
 private:
     AnimationHandle handle;
     AnimationDefinition definition;
-    std::optional<mir::geometry::Rectangle> from;
-    std::optional<mir::geometry::Rectangle> to;
+    AnimationEndpoints endpoints;
     std::function<void(AnimationStepResult const&)> callback;
     float runtime_seconds = 0.f;
+    /// Springs run until they come to rest, rather than for the duration of their definition
+    float duration_seconds = 0.f;
+};
+
+/// Holds the animations that are in flight as parallel arrays indexed by slot, so that each
+/// step can be evaluated over contiguous memory. Completed animations are removed by moving
+/// the last slot into their place.
+class AnimationStore
+{
+public:
+    using Callback = std::function<void(AnimationStepResult const&)>;
+
+    struct Update
+    {
+        AnimationStepResult result;
+        std::shared_ptr<Callback const> callback;
+    };
+
+    /// Adds [animation]. If an animation is already in flight for its handle, its slot is
+    /// retargeted in place and the new animation starts from its current interpolated geometry.
+    /// Returns the initial result of the animation.
+    AnimationStepResult insert(Animation const& animation);
+
+    /// Advances every animation by [delta_seconds] and appends the results to [out].
+    /// Completed animations are removed from the store.
+    void step(float delta_seconds, std::vector<Update>& out);
+
+    /// Completes every animation immediately and appends their final results to [out].
+    void finish(std::vector<Update>& out);
+
+    [[nodiscard]] bool empty() const { return handles.empty(); }
+    [[nodiscard]] size_t size() const { return handles.size(); }
+
+    /// Like [empty], but safe to call from other threads while the store is being modified.
+    [[nodiscard]] bool has_animations_in_flight() const { return in_flight; }
+
+private:
+    static constexpr uint32_t no_slot = UINT32_MAX;
+
+    void assign(size_t slot, Animation const& animation);
+    void remove(size_t slot);
+
+    /// The slot of each handle, or [no_slot] if the handle is not being animated
+    std::vector<uint32_t> slot_by_handle;
+    std::vector<AnimationHandle> handles;
+    std::vector<float> runtime_seconds;
+    std::vector<float> duration_seconds;
+    /// The eased progress of each slot, rewritten on every step
+    std::vector<float> progress;
+    std::vector<AnimationType> types;
+    std::vector<AnimationDefinition> definitions;
+    std::vector<AnimationEndpoints> endpoints;
+    /// The velocity that each spring started with, as (x, y, width, height)
+    std::vector<glm::vec4> velocities;
+    std::vector<std::shared_ptr<Callback const>> callbacks;
+    /// Set whenever the store holds an animation
+    std::atomic<bool> in_flight = false;
+};
+
+/// Notified on the server thread around the delivery of each step's results, so that
+/// the results of a frame can be applied together.
+class AnimationBatchListener
+{
+public:
+    virtual ~AnimationBatchListener() = default;
+    virtual void begin_batch() = 0;
+    virtual void end_batch() = 0;
 };
 
 /// Manages the animation queue. If multiple animations are queued for a window,
 /// then the latest animation may override values from previous animations.
+///
+/// Animations are advanced by the real time that elapses between frames, as reported
+/// through [on_frame]. If no frames arrive (e.g. because nothing on screen has changed
+/// yet), a sleeping fallback thread advances them instead.
 class Animator
 {
 public:
+    /// Animations are timed by [time_source]. Pass a [ManualAnimationClock] and drive the
+    /// animator with [on_frame] to run animations deterministically.
     explicit Animator(
         std::shared_ptr<mir::ServerActionQueue> const&,
-        std::shared_ptr<Config> const&);
+        std::shared_ptr<Config> const&,
+        std::shared_ptr<AnimationClock> const& time_source = std::make_shared<SteadyAnimationClock>());
     ~Animator();
 
     /// Animateable components must register with the Animator before being
@@ -105,6 +202,12 @@ public:
         AnimationHandle handle,
         std::function<void(AnimationStepResult const&)> const& callback);
 
+    /// Animates a window that has been closed. The callback is expected to draw the
+    /// window's last frame until the animation completes.
+    void window_close(
+        AnimationHandle handle,
+        std::function<void(AnimationStepResult const&)> const& callback);
+
     void workspace_switch(
         AnimationHandle handle,
         mir::geometry::Rectangle const& from,
@@ -114,22 +217,87 @@ public:
 
     void start();
     void stop();
+
+    /// Sets the listener that is notified around each batch of results. Pass nullptr to clear it.
+    void set_batch_listener(AnimationBatchListener* listener);
+
+    /// Records every animation that is started along with the results of every step from now on.
+    /// Pass nullptr to stop recording.
+    void set_recorder(std::shared_ptr<AnimationRecorder> const& recorder);
+
+    /// Advances every animation by [timestep_seconds].
     void step();
 
+    /// True while any animation is running. This does not wait on the animation thread,
+    /// so it is cheap enough to ask on every input event.
+    [[nodiscard]] bool is_animating() const;
+
+    /// Advances every animation by the time that has passed since they were last advanced.
+    /// Called by the renderers at the start of each frame. Each output is identified by
+    /// [source], so that the frames of several outputs are not mistaken for a single stream.
+    /// [refresh_period] is the refresh period of the output, if it is known.
+    void on_frame(
+        std::chrono::steady_clock::time_point frame_time,
+        void const* source = nullptr,
+        std::optional<std::chrono::steady_clock::duration> refresh_period = std::nullopt);
+
+    /// The interval at which the fallback thread advances animations when no frames arrive.
     static constexpr float timestep_seconds = 0.016;
 
+    [[nodiscard]] AnimationBudget const& get_budget() const { return budget; }
+
 private:
+    using clock = std::chrono::steady_clock;
+
     void run();
+    /// Advances every animation by [delta_seconds] into [pending_updates]. [frame] is set
+    /// when the step is driven by a frame. Must be called with [processing_lock] held.
+    void advance_locked(float delta_seconds, std::optional<AnimationBudget::FrameTiming> const& frame);
+    /// True if animations should complete immediately rather than being animated.
+    [[nodiscard]] bool should_snap() const;
+    /// Schedules delivery of [pending_updates] on the server thread.
+    void dispatch();
+    /// Calls back with every pending update. Runs on the server thread.
+    void deliver();
+    [[nodiscard]] clock::duration get_fallback_interval() const;
 
-    void append(Animation&&);
-    bool running = false;
+    void append(
+        AnimationHandle handle,
+        AnimationDefinition const& definition,
+        std::optional<mir::geometry::Rectangle> const& from,
+        std::optional<mir::geometry::Rectangle> const& to,
+        std::optional<mir::geometry::Rectangle> const& current,
+        std::function<void(AnimationStepResult const&)> const& callback);
+    std::atomic<bool> running = false;
     std::shared_ptr<mir::ServerActionQueue> server_action_queue;
     std::shared_ptr<Config> config;
-    std::vector<Animation> queued_animations;
+    std::shared_ptr<AnimationClock> time_source;
+    std::shared_ptr<AnimationRecorder> recorder;
+    AnimationStore store;
+    AnimationBudget budget;
+    /// Results of the steps that have not been delivered yet. The buffers are swapped
+    /// rather than reallocated, so steady-state animation does not allocate per frame.
+    std::vector<AnimationStore::Update> pending_updates;
+    std::vector<AnimationStore::Update> delivering_updates;
+    bool is_delivery_scheduled = false;
+    std::mutex delivery_lock;
+    AnimationBatchListener* batch_listener = nullptr;
     std::thread run_thread;
     std::mutex processing_lock;
     std::condition_variable cv;
     AnimationHandle next_handle = 1;
+    clock::time_point last_step_time;
+
+    /// The frames arriving from a single output
+    struct FrameStream
+    {
+        clock::time_point last_frame_time;
+        /// A running estimate of the time between frames, which is used to decide when frames have stopped
+        clock::duration frame_interval = clock::duration::zero();
+        /// The reported refresh period or, failing that, the shortest recent interval between frames
+        std::optional<clock::duration> refresh_period;
+    };
+    std::unordered_map<void const*, FrameStream> frame_streams;
 };
 
 } // miracle
@@ -0,0 +1,228 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "auto_layout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <tuple>
+
+using namespace miracle;
+
+namespace
+{
+/// Keeps a window from being squeezed to nothing when its weight is tiny or huge
+constexpr double min_split_ratio = 0.1;
+constexpr double max_split_ratio = 0.9;
+
+double split_ratio(double weight, double even_share)
+{
+    if (even_share <= 0)
+        return 0.5;
+    return std::clamp(0.5 * weight / even_share, min_split_ratio, max_split_ratio);
+}
+
+/// Splits [area] along one axis, giving [ratio] of it to the first rectangle
+std::pair<geom::Rectangle, geom::Rectangle> split(geom::Rectangle const& area, double ratio, bool along_x)
+{
+    auto first = area;
+    auto second = area;
+    if (along_x)
+    {
+        auto const spans = apportion(area.size.width.as_int(), { ratio, 1.0 - ratio });
+        first.size.width = geom::Width { spans[0] };
+        second.top_left.x = geom::X { area.top_left.x.as_int() + spans[0] };
+        second.size.width = geom::Width { spans[1] };
+    }
+    else
+    {
+        auto const spans = apportion(area.size.height.as_int(), { ratio, 1.0 - ratio });
+        first.size.height = geom::Height { spans[0] };
+        second.top_left.y = geom::Y { area.top_left.y.as_int() + spans[0] };
+        second.size.height = geom::Height { spans[1] };
+    }
+
+    return { first, second };
+}
+
+void master_stack(geom::Rectangle const& area, std::vector<double> const& weights, double total, std::vector<geom::Rectangle>& out)
+{
+    auto const [master, stack] = split(area, split_ratio(weights[0], total / (double)weights.size()), true);
+    out[0] = master;
+
+    double const stack_total = total - weights[0];
+    std::vector<double> stack_weights(weights.begin() + 1, weights.end());
+    for (auto& weight : stack_weights)
+        weight = stack_total > 0 ? weight / stack_total : 1.0 / (double)stack_weights.size();
+
+    auto const spans = apportion(stack.size.height.as_int(), stack_weights);
+    int y = stack.top_left.y.as_int();
+    for (size_t i = 0; i < spans.size(); i++)
+    {
+        out[i + 1] = geom::Rectangle(
+            geom::Point(stack.top_left.x, geom::Y { y }),
+            geom::Size(stack.size.width, geom::Height { spans[i] }));
+        y += spans[i];
+    }
+}
+
+void spiral(geom::Rectangle const& area, std::vector<double> const& weights, std::vector<geom::Rectangle>& out)
+{
+    // The weight left for each child and everyone after it, so that a child's share is
+    // judged against an even split of the space that remains
+    std::vector<double> remaining_weight(weights.size() + 1, 0.0);
+    for (size_t i = weights.size(); i-- > 0;)
+        remaining_weight[i] = remaining_weight[i + 1] + weights[i];
+
+    auto remaining = area;
+    for (size_t i = 0; i + 1 < weights.size(); i++)
+    {
+        double const even_share = remaining_weight[i] / (double)(weights.size() - i);
+        double const ratio = split_ratio(weights[i], even_share);
+
+        // Left, top, right, bottom, and around again
+        switch (i % 4)
+        {
+        case 0:
+            std::tie(out[i], remaining) = split(remaining, ratio, true);
+            break;
+        case 1:
+            std::tie(out[i], remaining) = split(remaining, ratio, false);
+            break;
+        case 2:
+            std::tie(remaining, out[i]) = split(remaining, 1.0 - ratio, true);
+            break;
+        default:
+            std::tie(remaining, out[i]) = split(remaining, 1.0 - ratio, false);
+            break;
+        }
+    }
+
+    out.back() = remaining;
+}
+
+void grid(geom::Rectangle const& area, std::vector<geom::Rectangle>& out)
+{
+    size_t const count = out.size();
+    size_t const columns = (size_t)std::ceil(std::sqrt((double)count));
+    size_t const rows = (count + columns - 1) / columns;
+
+    auto const row_spans = apportion(area.size.height.as_int(), std::vector<double>(rows, 1.0 / (double)rows));
+    int y = area.top_left.y.as_int();
+    size_t index = 0;
+    for (size_t row = 0; row < rows; row++)
+    {
+        // The last row may be short, in which case its cells are stretched to fill it
+        size_t const cells = std::min(columns, count - index);
+        auto const column_spans = apportion(area.size.width.as_int(), std::vector<double>(cells, 1.0 / (double)cells));
+        int x = area.top_left.x.as_int();
+        for (size_t column = 0; column < cells; column++, index++)
+        {
+            out[index] = geom::Rectangle(
+                geom::Point(geom::X { x }, geom::Y { y }),
+                geom::Size(geom::Width { column_spans[column] }, geom::Height { row_spans[row] }));
+            x += column_spans[column];
+        }
+        y += row_spans[row];
+    }
+}
+}
+
+std::optional<AutoLayout> miracle::auto_layout_from_string(std::string const& str)
+{
+    if (str == "none")
+        return AutoLayout::none;
+    else if (str == "master_stack")
+        return AutoLayout::master_stack;
+    else if (str == "spiral")
+        return AutoLayout::spiral;
+    else if (str == "grid")
+        return AutoLayout::grid;
+    else
+        return std::nullopt;
+}
+
+const char* miracle::to_string(AutoLayout layout)
+{
+    switch (layout)
+    {
+    case AutoLayout::master_stack:
+        return "master_stack";
+    case AutoLayout::spiral:
+        return "spiral";
+    case AutoLayout::grid:
+        return "grid";
+    default:
+        return "none";
+    }
+}
+
+std::vector<int> miracle::apportion(int length, std::vector<double> const& weights)
+{
+    std::vector<int> spans(weights.size());
+    std::vector<double> remainders(weights.size());
+    int assigned = 0;
+    for (size_t i = 0; i < weights.size(); i++)
+    {
+        double const exact = (double)length * weights[i];
+        spans[i] = (int)floor(exact);
+        remainders[i] = exact - spans[i];
+        assigned += spans[i];
+    }
+
+    std::vector<size_t> order(weights.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t left, size_t right)
+    {
+        return remainders[left] > remainders[right];
+    });
+
+    int leftover = length - assigned;
+    for (size_t i = 0; leftover > 0 && !order.empty(); i = (i + 1) % order.size(), leftover--)
+        spans[order[i]]++;
+
+    return spans;
+}
+
+std::vector<geom::Rectangle> miracle::compute_auto_layout(
+    AutoLayout layout,
+    geom::Rectangle const& area,
+    std::vector<double> const& weights)
+{
+    std::vector<geom::Rectangle> areas(weights.size(), area);
+    if (weights.size() < 2)
+        return areas;
+
+    double const total = std::accumulate(weights.begin(), weights.end(), 0.0);
+    switch (layout)
+    {
+    case AutoLayout::master_stack:
+        master_stack(area, weights, total, areas);
+        break;
+    case AutoLayout::spiral:
+        spiral(area, weights, areas);
+        break;
+    case AutoLayout::grid:
+        grid(area, areas);
+        break;
+    default:
+        break;
+    }
+
+    return areas;
+}
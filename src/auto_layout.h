@@ -0,0 +1,65 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_AUTO_LAYOUT_H
+#define MIRACLE_WM_AUTO_LAYOUT_H
+
+#include <mir/geometry/rectangle.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace geom = mir::geometry;
+
+namespace miracle
+{
+
+/// Arrangements that place every child of a lane at once, as opposed to the manual
+/// splits described by [LayoutScheme].
+enum class AutoLayout
+{
+    none,
+
+    /// The first child fills a master column and the rest are stacked beside it
+    master_stack,
+
+    /// Each child takes part of the space left over by the previous one, turning
+    /// clockwise around the area
+    spiral,
+
+    /// Children fill a balanced grid of equally sized cells
+    grid
+};
+
+std::optional<AutoLayout> auto_layout_from_string(std::string const&);
+const char* to_string(AutoLayout);
+
+/// Splits [length] into integer spans proportional to [weights]. Each span starts as the
+/// floor of its exact share and the leftover pixels go to the largest remainders, with
+/// earlier children winning ties, so the spans always sum to exactly [length].
+std::vector<int> apportion(int length, std::vector<double> const& weights);
+
+/// Computes the area of every child in a single pass. A child whose weight equals an even
+/// share gets the default geometry of [layout], and a larger weight grows it. The returned
+/// rectangles never overlap and cover all of [area].
+std::vector<geom::Rectangle> compute_auto_layout(
+    AutoLayout layout,
+    geom::Rectangle const& area,
+    std::vector<double> const& weights);
+}
+
+#endif // MIRACLE_WM_AUTO_LAYOUT_H
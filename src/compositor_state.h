@@ -18,8 +18,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIRACLE_WM_COMPOSITOR_STATE_H
 #define MIRACLE_WM_COMPOSITOR_STATE_H
 
+#include "layout_transaction.h"
+
 #include <memory>
 #include <mir/geometry/point.h>
+#include <vector>
 
 namespace miracle
 {
@@ -48,6 +51,12 @@ struct CompositorState
     mir::geometry::Point cursor_position;
     uint32_t modifiers = 0;
     bool has_clicked_floating_window = false;
+
+    /// Batches the layout changes of an operation so that each window is modified once.
+    std::shared_ptr<LayoutTransaction> layout_transaction = std::make_shared<LayoutTransaction>();
+
+    /// Panels, menus, popups and the like, which may be stacked above the tiled windows of any output.
+    std::vector<std::weak_ptr<Container>> shell_components;
 };
 }
 
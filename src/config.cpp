@@ -18,6 +18,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define MIR_LOG_COMPONENT "config"
 
 #include "config.h"
+#include "easing.h"
 #include "yaml-cpp/node/node.h"
 #include <cstdlib>
 #include <filesystem>
@@ -236,6 +237,8 @@ void FilesystemConfiguration::_reload()
         read_animation_definitions(config["animations"]);
     if (config["enable_animations"])
         read_enable_animations(config["enable_animations"]);
+    if (config["animation_budget_ms"])
+        read_animation_budget(config["animation_budget_ms"]);
 
     error_handler.on_complete();
 }
@@ -543,7 +546,12 @@ void FilesystemConfiguration::read_workspaces(YAML::Node const& workspaces)
         if (!try_parse_value(workspace, "name", name, true))
             continue;
 
-        options.workspace_configs.push_back({ num, type, name });
+        // An invalid automatic layout is reported, but the rest of the workspace still applies
+        std::optional<AutoLayout> auto_layout;
+        if (workspace["auto_layout"])
+            auto_layout = try_parse_string_to_optional_value<std::optional<AutoLayout>>(workspace, "auto_layout", auto_layout_from_string);
+
+        options.workspace_configs.push_back({ num, type, name, auto_layout });
     }
 }
 
@@ -743,12 +751,15 @@ void FilesystemConfiguration::read_animation_definitions(YAML::Node const& anima
         options.animation_definitions[event_as_int].type = type.value();
         options.animation_definitions[event_as_int].function = function.value();
         try_parse_value(node, "duration", options.animation_definitions[event_as_int].duration_seconds, true);
+        try_parse_value(node, "transform_only", options.animation_definitions[event_as_int].transform_only, true);
+        try_parse_value(node, "stiffness", options.animation_definitions[event_as_int].stiffness, true);
         try_parse_value(node, "c1", options.animation_definitions[event_as_int].c1, true);
         try_parse_value(node, "c2", options.animation_definitions[event_as_int].c2, true);
         try_parse_value(node, "c3", options.animation_definitions[event_as_int].c3, true);
         try_parse_value(node, "c4", options.animation_definitions[event_as_int].c4, true);
         try_parse_value(node, "n1", options.animation_definitions[event_as_int].n1, true);
         try_parse_value(node, "d1", options.animation_definitions[event_as_int].d1, true);
+        options.animation_definitions[event_as_int].ease_table = make_ease_table(options.animation_definitions[event_as_int]);
     }
 }
 
@@ -757,6 +768,11 @@ void FilesystemConfiguration::read_enable_animations(YAML::Node const& node)
     try_parse_value(node, options.animations_enabled);
 }
 
+void FilesystemConfiguration::read_animation_budget(YAML::Node const& node)
+{
+    try_parse_value(node, options.animation_budget_ms);
+}
+
 void FilesystemConfiguration::_watch(miral::MirRunner& runner)
 {
     if (no_config)
@@ -998,6 +1014,11 @@ bool FilesystemConfiguration::are_animations_enabled() const
     return options.animations_enabled;
 }
 
+float FilesystemConfiguration::get_animation_budget_ms() const
+{
+    return options.animation_budget_ms;
+}
+
 WorkspaceConfig FilesystemConfiguration::get_workspace_config(std::optional<int> const& num, std::optional<std::string> const& name) const
 {
     for (auto const& config : options.workspace_configs)
@@ -1176,4 +1197,6 @@ FilesystemConfiguration::ConfigDetails::ConfigDetails()
          0.175f }
     });
     animation_definitions = parsed;
+    for (auto& definition : animation_definitions)
+        definition.ease_table = make_ease_table(definition);
 }
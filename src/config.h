@@ -19,6 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define MIRACLEWM_CONFIG_H
 
 #include "animation_defintion.h"
+#include "auto_layout.h"
 #include "config_error_handler.h"
 #include "container.h"
 
@@ -142,6 +143,7 @@ struct WorkspaceConfig
     std::optional<int> num;
     std::optional<ContainerType> layout;
     std::optional<std::string> name;
+    std::optional<AutoLayout> auto_layout;
 };
 
 enum class RenderFilter : int
@@ -173,6 +175,8 @@ public:
     [[nodiscard]] virtual BorderConfig const& get_border_config() const = 0;
     [[nodiscard]] virtual std::array<AnimationDefinition, static_cast<int>(AnimateableEvent::max)> const& get_animation_definitions() const = 0;
     [[nodiscard]] virtual bool are_animations_enabled() const = 0;
+    /// The time that animations may take in each frame before they are degraded. Zero or less never degrades them.
+    [[nodiscard]] virtual float get_animation_budget_ms() const = 0;
     [[nodiscard]] virtual WorkspaceConfig get_workspace_config(std::optional<int> const& num, std::optional<std::string> const& name) const = 0;
     [[nodiscard]] virtual LayoutScheme get_default_layout_scheme() const = 0;
 
@@ -210,6 +214,7 @@ public:
     [[nodiscard]] BorderConfig const& get_border_config() const override;
     [[nodiscard]] std::array<AnimationDefinition, static_cast<int>(AnimateableEvent::max)> const& get_animation_definitions() const override;
     [[nodiscard]] bool are_animations_enabled() const override;
+    [[nodiscard]] float get_animation_budget_ms() const override;
     [[nodiscard]] WorkspaceConfig get_workspace_config(std::optional<int> const& num, std::optional<std::string> const& name) const override;
     [[nodiscard]] LayoutScheme get_default_layout_scheme() const override;
     int register_listener(std::function<void(miracle::Config&)> const&) override;
@@ -235,6 +240,7 @@ private:
         std::vector<EnvironmentVariable> environment_variables;
         BorderConfig border_config;
         bool animations_enabled = true;
+        float animation_budget_ms = 8.f;
         std::array<AnimationDefinition, static_cast<int>(AnimateableEvent::max)> animation_definitions;
         std::vector<WorkspaceConfig> workspace_configs;
     };
@@ -263,6 +269,7 @@ private:
     void read_workspaces(YAML::Node const&);
     void read_animation_definitions(YAML::Node const&);
     void read_enable_animations(YAML::Node const&);
+    void read_animation_budget(YAML::Node const&);
 
     static std::optional<uint> try_parse_modifier(std::string const& stringified_action_key);
 
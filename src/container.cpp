@@ -130,64 +130,54 @@ float Container::get_percent_of_parent() const
 
 namespace
 {
-bool has_neighbor(Container const* container, LayoutScheme direction, size_t cannot_be_index)
+bool has_neighbor(Container const* container, Direction direction, size_t cannot_be_index)
 {
-    auto parent = container->get_parent().lock();
-    if (!parent)
-        return false;
-
-    auto parent_container = Container::as_parent(parent);
+    auto parent_container = container->get_parent_link();
     if (!parent_container)
         return false;
 
-    if (parent_container->get_direction() != direction)
-        return has_neighbor(parent_container.get(), direction, cannot_be_index);
+    // Automatic layouts have no single axis, so we look at whether the area reaches the edge of the lane
+    if (parent_container->get_auto_layout() != AutoLayout::none)
+        return !parent_container->reaches_edge(*container, direction)
+            || has_neighbor(parent_container, direction, cannot_be_index);
+
+    auto const scheme = direction == Direction::left || direction == Direction::right
+        ? LayoutScheme::horizontal
+        : LayoutScheme::vertical;
+    if (parent_container->get_direction() != scheme)
+        return has_neighbor(parent_container, direction, cannot_be_index);
 
-    auto index = parent_container->get_index_of_node(container);
+    auto index = container->get_index_in_parent();
     return (parent_container->num_nodes() > 1 && index != cannot_be_index)
-        || has_neighbor(parent_container.get(), direction, cannot_be_index);
+        || has_neighbor(parent_container, direction, cannot_be_index);
 }
 
 bool has_right_neighbor(Container const* container)
 {
-    auto shared_parent = container->get_parent().lock();
-    if (!shared_parent)
-        return false;
-
-    auto parent_container = Container::as_parent(shared_parent);
+    auto parent_container = container->get_parent_link();
     if (!parent_container)
         return false;
 
-    return has_neighbor(container, LayoutScheme::horizontal, parent_container->num_nodes() - 1);
+    return has_neighbor(container, Direction::right, parent_container->num_nodes() - 1);
 }
 
 bool has_bottom_neighbor(Container const* container)
 {
-    auto shared_parent = container->get_parent().lock();
-    if (!shared_parent)
-        return false;
-
-    auto parent_container = Container::as_parent(shared_parent);
+    auto parent_container = container->get_parent_link();
     if (!parent_container)
         return false;
 
-    return has_neighbor(container, LayoutScheme::vertical, parent_container->num_nodes() - 1);
+    return has_neighbor(container, Direction::down, parent_container->num_nodes() - 1);
 }
 
 bool has_left_neighbor(Container const* container)
 {
-    auto shared_parent = container->get_parent().lock();
-    if (!shared_parent)
-        return false;
-    return has_neighbor(container, LayoutScheme::horizontal, 0);
+    return has_neighbor(container, Direction::left, 0);
 }
 
 bool has_top_neighbor(Container const* container)
 {
-    auto shared_parent = container->get_parent().lock();
-    if (!shared_parent)
-        return false;
-    return has_neighbor(container, LayoutScheme::vertical, 0);
+    return has_neighbor(container, Direction::up, 0);
 }
 }
 
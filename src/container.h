@@ -128,6 +128,14 @@ public:
     bool is_lane();
     [[nodiscard]] float get_percent_of_parent() const;
 
+    /// The position of this container among the children of its parent, or -1 if it
+    /// has none. Kept up to date by the [ParentContainer].
+    [[nodiscard]] int get_index_in_parent() const { return index_in_parent; }
+
+    /// The [ParentContainer] that currently holds this container, or nullptr. Unlike
+    /// [get_parent], this does not take a reference, so it is cheap to follow up the tree.
+    [[nodiscard]] ParentContainer* get_parent_link() const { return parent_link; }
+
     static std::shared_ptr<LeafContainer> as_leaf(std::shared_ptr<Container> const&);
     static std::shared_ptr<ParentContainer> as_parent(std::shared_ptr<Container> const&);
     static std::shared_ptr<FloatingWindowContainer> as_floating(std::shared_ptr<Container> const&);
@@ -135,6 +143,11 @@ public:
 
 protected:
     [[nodiscard]] std::array<bool, (size_t)Direction::MAX> get_neighbors() const;
+
+private:
+    friend class ParentContainer;
+    int index_in_parent = -1;
+    ParentContainer* parent_link = nullptr;
 };
 }
 
@@ -0,0 +1,96 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_CONTAINER_POOL_H
+#define MIRACLE_WM_CONTAINER_POOL_H
+
+#include <memory>
+#include <memory_resource>
+
+namespace miracle
+{
+
+/// Allocates from a shared pool resource. Every allocator shares ownership of the
+/// resource, so memory stays valid for as long as anything allocated from it is alive.
+template <typename T>
+class ContainerPoolAllocator
+{
+public:
+    using value_type = T;
+
+    explicit ContainerPoolAllocator(std::shared_ptr<std::pmr::memory_resource> resource) :
+        resource { std::move(resource) }
+    {
+    }
+
+    template <typename U>
+    ContainerPoolAllocator(ContainerPoolAllocator<U> const& other) :
+        resource { other.resource }
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(resource->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        resource->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    template <typename U>
+    bool operator==(ContainerPoolAllocator<U> const& other) const
+    {
+        return resource == other.resource;
+    }
+
+private:
+    template <typename U>
+    friend class ContainerPoolAllocator;
+
+    std::shared_ptr<std::pmr::memory_resource> resource;
+};
+
+/// Allocates the containers of a tiling tree, together with their reference counts, from
+/// one pool so that the nodes of a tree sit close together in memory. Containers that
+/// move to another tree keep their memory alive after this pool is destroyed.
+///
+/// Trees are mutated under the window manager lock, but the last reference to a container
+/// may be dropped on any thread (e.g. by the renderer or an animation callback), so the pool
+/// must be synchronized.
+class ContainerPool
+{
+public:
+    ContainerPool() :
+        resource { std::make_shared<std::pmr::synchronized_pool_resource>() }
+    {
+    }
+
+    template <typename T, typename... Args>
+    std::shared_ptr<T> make(Args&&... args) const
+    {
+        return std::allocate_shared<T>(ContainerPoolAllocator<T>(resource), std::forward<Args>(args)...);
+    }
+
+private:
+    std::shared_ptr<std::pmr::memory_resource> resource;
+};
+
+}
+
+#endif // MIRACLE_WM_CONTAINER_POOL_H
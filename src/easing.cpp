@@ -0,0 +1,237 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "easing.h"
+#include "animation_defintion.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace miracle;
+
+namespace
+{
+float ease_out_bounce(AnimationDefinition const& defintion, float x)
+{
+    if (x < 1 / defintion.d1)
+    {
+        return defintion.n1 * x * x;
+    }
+    else if (x < 2 / defintion.d1)
+    {
+        return defintion.n1 * (x -= 1.5f / defintion.d1) * x + 0.75f;
+    }
+    else if (x < 2.5 / defintion.d1)
+    {
+        return defintion.n1 * (x -= 2.25f / defintion.d1) * x + 0.9375f;
+    }
+    else
+    {
+        return defintion.n1 * (x -= 2.625f / defintion.d1) * x + 0.984375f;
+    }
+}
+}
+
+void miracle::ease_exact(AnimationDefinition const& defintion, float const* t, float* out, size_t count)
+{
+    auto const apply = [&](auto const& fn)
+    {
+        for (size_t i = 0; i < count; i++)
+            out[i] = fn(t[i]);
+    };
+
+    // https://easings.net/
+    switch (defintion.function)
+    {
+    case EaseFunction::linear:
+        return apply([](float t)
+        { return t; });
+    case EaseFunction::ease_in_sine:
+        return apply([](float t)
+        { return 1 - cosf((t * M_PI) / 2.f); });
+    case EaseFunction::ease_in_out_sine:
+        return apply([](float t)
+        { return -(cosf(M_PI * t) - 1) / 2; });
+    case EaseFunction::ease_out_sine:
+        return apply([](float t)
+        { return sinf((t * M_PI) / 2.f); });
+    case EaseFunction::ease_in_quad:
+        return apply([](float t)
+        { return t * t; });
+    case EaseFunction::ease_out_quad:
+        return apply([](float t)
+        { return 1 - (1 - t) * (1 - t); });
+    case EaseFunction::ease_in_out_quad:
+        return apply([](float t)
+        { return t < 0.5 ? 2 * t * t : 1 - powf(-2 * t + 2, 2) / 2; });
+    case EaseFunction::ease_in_cubic:
+        return apply([](float t)
+        { return t * t * t; });
+    case EaseFunction::ease_out_cubic:
+        return apply([](float t)
+        { return 1 - powf(1 - t, 3); });
+    case EaseFunction::ease_in_out_cubic:
+        return apply([](float t)
+        { return t < 0.5 ? 4 * t * t * t : 1 - powf(-2 * t + 2, 3) / 2; });
+    case EaseFunction::ease_in_quart:
+        return apply([](float t)
+        { return t * t * t * t; });
+    case EaseFunction::ease_out_quart:
+        return apply([](float t)
+        { return 1 - powf(1 - t, 4); });
+    case EaseFunction::ease_in_out_quart:
+        return apply([](float t)
+        { return t < 0.5 ? 8 * t * t * t * t : 1 - powf(-2 * t + 2, 4) / 2; });
+    case EaseFunction::ease_in_quint:
+        return apply([](float t)
+        { return t * t * t * t * t; });
+    case EaseFunction::ease_out_quint:
+        return apply([](float t)
+        { return 1 - powf(1 - t, 5); });
+    case EaseFunction::ease_in_out_quint:
+        return apply([](float t)
+        { return t < 0.5 ? 16 * t * t * t * t * t : 1 - powf(-2 * t + 2, 5) / 2; });
+    case EaseFunction::ease_in_expo:
+        return apply([](float t)
+        { return t == 0 ? 0 : powf(2, 10 * t - 10); });
+    case EaseFunction::ease_out_expo:
+        return apply([](float t)
+        { return t == 1 ? 1 : 1 - powf(2, -10 * t); });
+    case EaseFunction::ease_in_out_expo:
+        return apply([](float t)
+        { return t == 0
+                ? 0
+                : t == 1
+                ? 1
+                : t < 0.5 ? powf(2, 20 * t - 10) / 2
+                          : (2 - powf(2, -20 * t + 10)) / 2; });
+    case EaseFunction::ease_in_circ:
+        return apply([](float t)
+        { return 1 - sqrtf(1 - powf(t, 2)); });
+    case EaseFunction::ease_out_circ:
+        return apply([](float t)
+        { return sqrtf(1 - powf(t - 1, 2)); });
+    case EaseFunction::ease_in_out_circ:
+        return apply([](float t)
+        { return t < 0.5f
+                ? (1 - sqrtf(1 - powf(2 * t, 2))) / 2
+                : (sqrtf(1 - powf(-2 * t + 2, 2)) + 1) / 2; });
+    case EaseFunction::ease_in_back:
+        return apply([&](float t)
+        { return defintion.c3 * t * t * t - defintion.c1 * t * t; });
+    case EaseFunction::ease_out_back:
+        return apply([&](float t)
+        { return 1 + defintion.c3 * powf(t - 1, 3) + defintion.c1 * powf(t - 1, 2); });
+    case EaseFunction::ease_in_out_back:
+        return apply([&](float t)
+        { return t < 0.5
+                ? (powf(2 * t, 2) * ((defintion.c2 + 1) * 2 * t - defintion.c2)) / 2
+                : (powf(2 * t - 2, 2) * ((defintion.c2 + 1) * (t * 2 - 2) + defintion.c2) + 2) / 2; });
+    case EaseFunction::ease_in_elastic:
+        return apply([&](float t)
+        { return t == 0
+                ? 0
+                : t == 1
+                ? 1
+                : -powf(2, 10 * t - 10) * sinf((t * 10 - 10.75f) * defintion.c4); });
+    case EaseFunction::ease_out_elastic:
+        return apply([&](float t)
+        { return t == 0
+                ? 0
+                : t == 1
+                ? 1
+                : powf(2, -10 * t) * sinf((t * 10 - 0.75f) * defintion.c4) + 1; });
+    case EaseFunction::ease_in_out_elastic:
+        return apply([&](float t)
+        { return t == 0
+                ? 0
+                : t == 1
+                ? 1
+                : t < 0.5
+                ? -(powf(2, 20 * t - 10) * sinf((20 * t - 11.125f) * defintion.c5)) / 2
+                : (powf(2, -20 * t + 10) * sinf((20 * t - 11.125f) * defintion.c5)) / 2 + 1; });
+    case EaseFunction::ease_in_bounce:
+        return apply([&](float t)
+        { return 1 - ease_out_bounce(defintion, 1 - t); });
+    case EaseFunction::ease_out_bounce:
+        return apply([&](float t)
+        { return ease_out_bounce(defintion, t); });
+    case EaseFunction::ease_in_out_bounce:
+        return apply([&](float t)
+        { return t < 0.5
+                ? (1 - ease_out_bounce(defintion, 1 - 2 * t)) / 2
+                : (1 + ease_out_bounce(defintion, 2 * t - 1)) / 2; });
+    default:
+        return apply([](float) { return 1.f; });
+    }
+}
+
+float miracle::ease_exact(AnimationDefinition const& definition, float t)
+{
+    float result;
+    ease_exact(definition, &t, &result, 1);
+    return result;
+}
+
+EaseTable::EaseTable(AnimationDefinition const& definition)
+{
+    std::array<float, num_intervals + 1> points;
+    for (size_t i = 0; i <= num_intervals; i++)
+        points[i] = static_cast<float>(i) / num_intervals;
+
+    ease_exact(definition, points.data(), samples.data(), points.size());
+    samples[num_intervals + 1] = samples[num_intervals];
+}
+
+void EaseTable::evaluate(float const* t, float* out, size_t count) const
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float const position = std::clamp(t[i], 0.f, 1.f) * num_intervals;
+        auto const index = static_cast<size_t>(position);
+        float const fraction = position - static_cast<float>(index);
+        out[i] = samples[index] + (samples[index + 1] - samples[index]) * fraction;
+    }
+}
+
+float EaseTable::evaluate(float t) const
+{
+    float result;
+    evaluate(&t, &result, 1);
+    return result;
+}
+
+std::shared_ptr<EaseTable const> miracle::make_ease_table(AnimationDefinition const& definition)
+{
+    switch (definition.function)
+    {
+    case EaseFunction::linear:
+    case EaseFunction::ease_in_quad:
+    case EaseFunction::ease_out_quad:
+    case EaseFunction::ease_in_out_quad:
+    case EaseFunction::ease_in_cubic:
+    case EaseFunction::ease_in_quart:
+    case EaseFunction::ease_in_quint:
+    case EaseFunction::ease_in_circ:
+    case EaseFunction::ease_out_circ:
+    case EaseFunction::ease_in_out_circ:
+    case EaseFunction::ease_in_back:
+    case EaseFunction::ease_in_out_back:
+        return nullptr;
+    default:
+        return std::make_shared<EaseTable const>(definition);
+    }
+}
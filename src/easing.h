@@ -0,0 +1,64 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_EASING_H
+#define MIRACLEWM_EASING_H
+
+#include <array>
+#include <cstddef>
+#include <memory>
+
+namespace miracle
+{
+struct AnimationDefinition;
+
+/// Evaluates the ease function of [definition] exactly for [count] values of [t] and writes them
+/// to [out]. The switch happens once per batch so that the inner loop can be vectorized.
+void ease_exact(AnimationDefinition const& definition, float const* t, float* out, size_t count);
+float ease_exact(AnimationDefinition const& definition, float t);
+
+/// An ease function sampled at evenly spaced points and evaluated with linear interpolation.
+/// Evaluation is free of branches and transcendental functions, so a batch vectorizes well.
+///
+/// The tables are built once when the configuration is loaded.
+class EaseTable
+{
+public:
+    /// The number of intervals that [0, 1] is divided into.
+    static constexpr size_t num_intervals = 512;
+
+    explicit EaseTable(AnimationDefinition const& definition);
+
+    /// Evaluates the table for [count] values of [t] and writes them to [out]. Values of [t]
+    /// outside of [0, 1] are clamped.
+    void evaluate(float const* t, float* out, size_t count) const;
+    [[nodiscard]] float evaluate(float t) const;
+
+private:
+    /// One sample per interval boundary, plus a copy of the last sample so that t = 1 can
+    /// interpolate with its neighbour like every other value.
+    std::array<float, num_intervals + 2> samples;
+};
+
+/// Builds the lookup table of [definition], or returns nullptr if the exact function is
+/// cheaper. Functions that are plain arithmetic already vectorize better than a table lookup.
+/// The circ functions are also left exact because linear interpolation cannot follow their
+/// vertical tangents.
+std::shared_ptr<EaseTable const> make_ease_table(AnimationDefinition const& definition);
+}
+
+#endif // MIRACLEWM_EASING_H
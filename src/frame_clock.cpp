@@ -0,0 +1,114 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "frame_clock.h"
+
+#include <algorithm>
+
+using namespace miracle;
+
+void FrameClock::set_listener(Listener const& in_listener)
+{
+    std::lock_guard lock(mutex);
+    listener = in_listener;
+}
+
+void FrameClock::clear_listener()
+{
+    std::unique_lock lock(mutex);
+    listener = nullptr;
+    listener_returned.wait(lock, [&]
+    { return calls_in_progress == 0; });
+}
+
+void FrameClock::set_refresh_rate(mir::geometry::Rectangle const& area, double hz)
+{
+    std::lock_guard lock(mutex);
+    std::erase_if(outputs, [&](auto const& output) { return output.area == area; });
+    if (hz > 0)
+        outputs.push_back({ area, std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / hz)) });
+}
+
+void FrameClock::remove_output(mir::geometry::Rectangle const& area)
+{
+    std::lock_guard lock(mutex);
+    std::erase_if(outputs, [&](auto const& output) { return output.area == area; });
+}
+
+void FrameClock::remove_source(void const* source)
+{
+    std::lock_guard lock(mutex);
+    last_vblanks.erase(source);
+}
+
+std::optional<FrameClock::clock::duration> FrameClock::get_refresh_period_locked(mir::geometry::Rectangle const& viewport) const
+{
+    for (auto const& output : outputs)
+    {
+        if (output.area == viewport)
+            return output.period;
+    }
+
+    // The viewport may be letterboxed within the output
+    for (auto const& output : outputs)
+    {
+        if (output.area.contains(viewport.top_left))
+            return output.period;
+    }
+
+    return std::nullopt;
+}
+
+FrameClock::Frame FrameClock::advise_frame(void const* source, mir::geometry::Rectangle const& viewport, clock::time_point render_start)
+{
+    Listener to_call;
+    Frame frame { source, render_start, std::nullopt };
+    {
+        std::lock_guard lock(mutex);
+        frame.refresh_period = get_refresh_period_locked(viewport);
+
+        // Rendering starts some time after the vblank, depending on how busy the compositor is. We place
+        // the frame on the output's vblank grid instead, resynchronizing from the render time whenever
+        // it falls before the grid or too far after it.
+        auto const last = last_vblanks.find(source);
+        if (frame.refresh_period && last != last_vblanks.end() && render_start > last->second)
+        {
+            auto const period = frame.refresh_period.value();
+            auto const periods = std::max<clock::rep>(1, (render_start - last->second) / period);
+            auto const predicted = last->second + periods * period;
+            if (predicted <= render_start && render_start - predicted < period / 2)
+                frame.time = predicted;
+        }
+        last_vblanks[source] = frame.time;
+
+        if (!listener)
+            return frame;
+
+        to_call = listener;
+        calls_in_progress++;
+    }
+
+    // The listener is called without the lock so that renderers on other outputs are not held up by it
+    to_call(frame);
+
+    {
+        std::lock_guard lock(mutex);
+        calls_in_progress--;
+    }
+    listener_returned.notify_all();
+    return frame;
+}
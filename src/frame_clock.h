@@ -0,0 +1,92 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_FRAME_CLOCK_H
+#define MIRACLEWM_FRAME_CLOCK_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mir/geometry/rectangle.h>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace miracle
+{
+/// Lets the renderers tell the rest of the compositor when a frame is being drawn,
+/// so that animations advance in step with the display rather than on a timer.
+///
+/// Each renderer draws for a single output, so frames are reported per renderer
+/// along with the refresh period of its output, when that is known.
+class FrameClock
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct Frame
+    {
+        /// The renderer that is drawing the frame
+        void const* source;
+        /// The estimated time of the vblank that the frame is being drawn after
+        clock::time_point time;
+        /// The refresh period of the output, if it is known
+        std::optional<clock::duration> refresh_period;
+    };
+
+    using Listener = std::function<void(Frame const&)>;
+
+    FrameClock() = default;
+    FrameClock(FrameClock const&) = delete;
+    FrameClock& operator=(FrameClock const&) = delete;
+
+    void set_listener(Listener const& listener);
+
+    /// Clears the listener, waiting for any call to it that is in progress to return.
+    void clear_listener();
+
+    /// Sets the refresh rate of the output covering [area], as reported by the display configuration.
+    void set_refresh_rate(mir::geometry::Rectangle const& area, double hz);
+    void remove_output(mir::geometry::Rectangle const& area);
+
+    /// Called by each renderer at the start of each frame. This may be called
+    /// from multiple compositor threads at once. Returns the frame that was reported.
+    Frame advise_frame(void const* source, mir::geometry::Rectangle const& viewport, clock::time_point render_start);
+
+    /// Called when a renderer is destroyed.
+    void remove_source(void const* source);
+
+private:
+    std::optional<clock::duration> get_refresh_period_locked(mir::geometry::Rectangle const& viewport) const;
+
+    std::mutex mutex;
+    std::condition_variable listener_returned;
+    Listener listener;
+    int calls_in_progress = 0;
+    struct OutputRefresh
+    {
+        mir::geometry::Rectangle area;
+        clock::duration period;
+    };
+    std::vector<OutputRefresh> outputs;
+    /// The last estimated vblank of each renderer
+    std::map<void const*, clock::time_point> last_vblanks;
+};
+}
+
+#endif // MIRACLEWM_FRAME_CLOCK_H
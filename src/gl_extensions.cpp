@@ -0,0 +1,40 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "gl_extensions.h"
+
+#include <GLES2/gl2.h>
+#include <cstring>
+
+bool miracle::has_gl_extension(char const* name)
+{
+    auto extensions = reinterpret_cast<char const*>(glGetString(GL_EXTENSIONS));
+    if (!extensions)
+        return false;
+
+    // The extension string is a space-separated list, so we must match whole words only
+    auto const length = strlen(name);
+    for (auto it = strstr(extensions, name); it; it = strstr(it + length, name))
+    {
+        bool const starts = it == extensions || it[-1] == ' ';
+        bool const ends = it[length] == ' ' || it[length] == '\0';
+        if (starts && ends)
+            return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,123 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#define MIR_LOG_COMPONENT "gpu_frame_timer"
+
+#include "gpu_frame_timer.h"
+#include "gl_extensions.h"
+
+#include <EGL/egl.h>
+#include <mir/log.h>
+
+using namespace miracle;
+
+namespace
+{
+template <typename T>
+T load(char const* name)
+{
+    return reinterpret_cast<T>(eglGetProcAddress(name));
+}
+}
+
+GpuFrameTimer::GpuFrameTimer()
+{
+    if (!has_gl_extension("GL_EXT_disjoint_timer_query"))
+    {
+        mir::log_info("GL_EXT_disjoint_timer_query is not supported, GPU frame times will not be reported");
+        return;
+    }
+
+    gen_queries = load<PFNGLGENQUERIESEXTPROC>("glGenQueriesEXT");
+    delete_queries = load<PFNGLDELETEQUERIESEXTPROC>("glDeleteQueriesEXT");
+    begin_query = load<PFNGLBEGINQUERYEXTPROC>("glBeginQueryEXT");
+    end_query = load<PFNGLENDQUERYEXTPROC>("glEndQueryEXT");
+    get_query_object_uiv = load<PFNGLGETQUERYOBJECTUIVEXTPROC>("glGetQueryObjectuivEXT");
+    get_query_object_ui64v = load<PFNGLGETQUERYOBJECTUI64VEXTPROC>("glGetQueryObjectui64vEXT");
+
+    if (!gen_queries || !delete_queries || !begin_query || !end_query || !get_query_object_uiv || !get_query_object_ui64v)
+    {
+        mir::log_warning("GL_EXT_disjoint_timer_query is advertised but its entry points could not be loaded");
+        return;
+    }
+
+    gen_queries(num_queries, queries.data());
+    supported = true;
+}
+
+GpuFrameTimer::~GpuFrameTimer()
+{
+    if (supported)
+        delete_queries(num_queries, queries.data());
+}
+
+void GpuFrameTimer::begin_frame()
+{
+    // If every query is still in flight, then we skip timing this frame rather than waiting
+    if (!supported || pending == num_queries)
+        return;
+
+    begin_query(GL_TIME_ELAPSED_EXT, queries[next_query]);
+    in_frame = true;
+}
+
+void GpuFrameTimer::end_frame()
+{
+    if (!in_frame)
+        return;
+
+    end_query(GL_TIME_ELAPSED_EXT);
+    next_query = (next_query + 1) % num_queries;
+    pending++;
+    in_frame = false;
+}
+
+std::optional<std::chrono::nanoseconds> GpuFrameTimer::poll()
+{
+    if (!supported)
+        return std::nullopt;
+
+    // A disjoint event (e.g. a GPU frequency change) invalidates every result that is in flight
+    GLint disjoint = GL_FALSE;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    if (disjoint)
+        num_invalid = pending;
+
+    while (pending > 0)
+    {
+        auto const oldest = (next_query + num_queries - pending) % num_queries;
+        GLuint available = GL_FALSE;
+        get_query_object_uiv(queries[oldest], GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+        if (!available)
+            return std::nullopt;
+
+        GLuint64 elapsed = 0;
+        get_query_object_ui64v(queries[oldest], GL_QUERY_RESULT_EXT, &elapsed);
+        pending--;
+
+        // Invalid results are skipped so that the results behind them are still collected
+        if (num_invalid > 0)
+        {
+            num_invalid--;
+            continue;
+        }
+
+        return std::chrono::nanoseconds(elapsed);
+    }
+
+    return std::nullopt;
+}
@@ -0,0 +1,70 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_GPU_FRAME_TIMER_H
+#define MIRACLEWM_GPU_FRAME_TIMER_H
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <array>
+#include <chrono>
+#include <optional>
+
+namespace miracle
+{
+
+/// Measures how long the GPU spends on each frame using GL_EXT_disjoint_timer_query.
+/// Queries are kept in a small ring so that reading a result never stalls the pipeline:
+/// we only ever collect results from frames that were submitted a few frames ago.
+///
+/// Must be constructed, used, and destroyed with the renderer's GL context current.
+class GpuFrameTimer
+{
+public:
+    GpuFrameTimer();
+    ~GpuFrameTimer();
+
+    [[nodiscard]] bool is_supported() const { return supported; }
+
+    void begin_frame();
+    void end_frame();
+
+    /// Returns the GPU time of the oldest frame whose result has become available, if any.
+    std::optional<std::chrono::nanoseconds> poll();
+
+private:
+    static constexpr size_t num_queries = 4;
+
+    bool supported = false;
+    PFNGLGENQUERIESEXTPROC gen_queries = nullptr;
+    PFNGLDELETEQUERIESEXTPROC delete_queries = nullptr;
+    PFNGLBEGINQUERYEXTPROC begin_query = nullptr;
+    PFNGLENDQUERYEXTPROC end_query = nullptr;
+    PFNGLGETQUERYOBJECTUIVEXTPROC get_query_object_uiv = nullptr;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC get_query_object_ui64v = nullptr;
+
+    std::array<GLuint, num_queries> queries {};
+    size_t next_query = 0;
+    size_t pending = 0;
+    /// The number of the oldest pending results that were invalidated by a disjoint event
+    size_t num_invalid = 0;
+    bool in_frame = false;
+};
+
+}
+
+#endif // MIRACLEWM_GPU_FRAME_TIMER_H
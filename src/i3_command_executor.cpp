@@ -48,6 +48,8 @@ I3CommandExecutor::I3CommandExecutor(
 
 void I3CommandExecutor::process(miracle::I3ScopedCommandList const& command_list)
 {
+    // Every command in the batch shares one transaction, so windows are only modified once
+    LayoutTransactionScope transaction(*policy.get_state().layout_transaction);
     for (auto const& command : command_list.commands)
     {
         switch (command.type)
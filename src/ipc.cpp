@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "i3_command_executor.h"
 #include "output.h"
 #include "policy.h"
+#include "render_statistics.h"
 #include "version.h"
 #include "workspace.h"
 
@@ -227,12 +228,14 @@ Ipc::Ipc(miral::MirRunner& runner,
     Policy& policy,
     std::shared_ptr<mir::ServerActionQueue> const& queue,
     I3CommandExecutor& executor,
-    std::shared_ptr<Config> const& config) :
+    std::shared_ptr<Config> const& config,
+    std::shared_ptr<RenderStatistics> const& render_statistics) :
     workspace_manager { workspace_manager },
     policy { policy },
     queue { queue },
     executor { executor },
-    config { config }
+    config { config },
+    render_statistics { render_statistics }
 {
     auto ipc_socket_raw = socket(AF_UNIX, SOCK_STREAM, 0);
     if (ipc_socket_raw == -1)
@@ -663,6 +666,32 @@ void Ipc::handle_command(miracle::Ipc::IpcClient& client, uint32_t payload_lengt
         }
         break;
     }
+    case IPC_GET_RENDER_STATISTICS:
+    {
+        // The renderer only knows the rectangle that it draws, so we use it to find the output's name
+        json response = json::array();
+        for (auto const& stats : render_statistics->get_outputs())
+        {
+            auto stats_json = stats->to_json();
+            auto const viewport = stats->get_viewport();
+            for (auto const& output : policy.get_output_list())
+            {
+                if (output->get_area() == viewport)
+                {
+                    stats_json["name"] = output->get_output().name();
+                    break;
+                }
+            }
+            response.push_back(stats_json);
+        }
+        send_reply(client, payload_type, to_string(response));
+        break;
+    }
+    case IPC_GET_ANIMATION_BUDGET:
+    {
+        send_reply(client, payload_type, to_string(policy.get_animation_budget().to_json()));
+        break;
+    }
     default:
         mir::log_warning("Unknown payload type: %d", payload_type);
         disconnect(client);
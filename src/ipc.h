@@ -36,6 +36,7 @@ namespace miracle
 
 class Policy;
 class Config;
+class RenderStatistics;
 
 /// This it taken directly from SWAY
 enum IpcCommandType
@@ -59,6 +60,10 @@ enum IpcCommandType
     IPC_GET_INPUTS = 100,
     IPC_GET_SEATS = 101,
 
+    // miracle-specific command types
+    IPC_GET_RENDER_STATISTICS = 200,
+    IPC_GET_ANIMATION_BUDGET = 201,
+
     // Events sent from sway to clients. Events have the highest bits set.
     IPC_EVENT_WORKSPACE = ((1 << 31) | 0),
     IPC_EVENT_OUTPUT = ((1 << 31) | 1),
@@ -86,7 +91,8 @@ public:
         Policy& policy,
         std::shared_ptr<mir::ServerActionQueue> const&,
         I3CommandExecutor&,
-        std::shared_ptr<Config> const&);
+        std::shared_ptr<Config> const&,
+        std::shared_ptr<RenderStatistics> const&);
     ~Ipc();
 
     void on_created(uint32_t id) override;
@@ -118,6 +124,7 @@ private:
     std::shared_ptr<mir::ServerActionQueue> queue;
     I3CommandExecutor& executor;
     std::shared_ptr<Config> config;
+    std::shared_ptr<RenderStatistics> render_statistics;
 
     void disconnect(IpcClient& client);
     IpcClient& get_client(int fd);
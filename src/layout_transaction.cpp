@@ -0,0 +1,96 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#define MIR_LOG_COMPONENT "layout_transaction"
+
+#include "layout_transaction.h"
+#include "container.h"
+
+#include <mir/log.h>
+
+using namespace miracle;
+
+void LayoutTransaction::begin()
+{
+    depth++;
+}
+
+void LayoutTransaction::end()
+{
+    if (depth == 0)
+    {
+        mir::log_error("LayoutTransaction::end: no transaction is open");
+        return;
+    }
+
+    if (--depth == 0)
+        flush();
+}
+
+void LayoutTransaction::commit(std::shared_ptr<Container> const& container)
+{
+    if (!container)
+        return;
+
+    begin();
+    auto const [it, inserted] = pending_indices.try_emplace(container.get(), pending.size());
+    if (inserted)
+        pending.push_back(container);
+    else if (pending[it->second].expired())
+    {
+        // A pending container went away and a new one was allocated in its place
+        pending[it->second] = container;
+    }
+    end();
+}
+
+void LayoutTransaction::record_window_modification()
+{
+    current_modifications++;
+}
+
+void LayoutTransaction::flush()
+{
+    // Committing may queue more containers, so we keep going until nothing is left
+    while (!pending.empty())
+    {
+        auto to_commit = std::move(pending);
+        pending.clear();
+        pending_indices.clear();
+        for (auto const& weak_container : to_commit)
+        {
+            if (auto container = weak_container.lock())
+                container->commit_changes();
+        }
+    }
+
+    statistics.operations++;
+    statistics.window_modifications += current_modifications;
+    statistics.last_operation_modifications = current_modifications;
+    current_modifications = 0;
+}
+
+LayoutTransactionScope::LayoutTransactionScope(LayoutTransaction& transaction) :
+    transaction { transaction }
+{
+    transaction.begin();
+}
+
+LayoutTransactionScope::~LayoutTransactionScope()
+{
+    transaction.end();
+}
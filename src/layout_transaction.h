@@ -0,0 +1,88 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_LAYOUT_TRANSACTION_H
+#define MIRACLE_WM_LAYOUT_TRANSACTION_H
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace miracle
+{
+class Container;
+
+struct LayoutStatistics
+{
+    /// Number of flushes, each of which ends one operation.
+    uint64_t operations = 0;
+
+    /// Number of window modifications issued across every operation.
+    uint64_t window_modifications = 0;
+
+    /// Number of window modifications issued by the most recent operation.
+    uint32_t last_operation_modifications = 0;
+};
+
+/// Defers the commit of containers until the outermost transaction is closed, so that an
+/// operation made up of several layout mutations modifies each window at most once.
+class LayoutTransaction
+{
+public:
+    /// Opens a transaction. Transactions nest and only the outermost one flushes.
+    void begin();
+
+    /// Closes a transaction, flushing the pending containers if it was the outermost one.
+    void end();
+
+    /// Commits [container] when the outermost transaction is closed, or right away as an
+    /// operation of its own if no transaction is open.
+    void commit(std::shared_ptr<Container> const& container);
+
+    /// Called by containers each time they modify a window.
+    void record_window_modification();
+
+    [[nodiscard]] bool is_open() const { return depth > 0; }
+    [[nodiscard]] LayoutStatistics const& get_statistics() const { return statistics; }
+
+private:
+    int depth = 0;
+    std::vector<std::weak_ptr<Container>> pending;
+    /// The index of each container in [pending], so that queueing a container twice is cheap
+    std::unordered_map<Container const*, size_t> pending_indices;
+    uint32_t current_modifications = 0;
+    LayoutStatistics statistics;
+
+    void flush();
+};
+
+/// Holds a [LayoutTransaction] open for the lifetime of the scope.
+class LayoutTransactionScope
+{
+public:
+    explicit LayoutTransactionScope(LayoutTransaction& transaction);
+    ~LayoutTransactionScope();
+    LayoutTransactionScope(LayoutTransactionScope const&) = delete;
+    LayoutTransactionScope& operator=(LayoutTransactionScope const&) = delete;
+
+private:
+    LayoutTransaction& transaction;
+};
+}
+
+#endif // MIRACLE_WM_LAYOUT_TRANSACTION_H
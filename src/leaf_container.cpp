@@ -247,19 +247,29 @@ void LeafContainer::commit_changes()
     {
         window_controller.change_state(window_, next_state.value());
         constrain();
+
+        // A fullscreen window no longer occupies the rectangle that it was given
+        if (window_helpers::is_window_fullscreen(next_state.value()))
+            applied_area.reset();
         next_state.reset();
     }
 
+    auto const previous = applied_area.value_or(get_visible_area());
     if (next_logical_area)
     {
-        auto previous = get_visible_area();
         logical_area = next_logical_area.value();
         next_logical_area.reset();
-        if (!window_controller.is_fullscreen(window_))
-        {
-            window_controller.set_rectangle(window_, previous, get_visible_area());
-            constrain();
-        }
+    }
+
+    // We compare against what the window was given rather than against the previous logical area,
+    // as the visible area also changes with the gaps and borders in the config
+    auto const visible_area = get_visible_area();
+    if (!window_controller.is_fullscreen(window_) && applied_area != visible_area)
+    {
+        window_controller.set_rectangle(window_, previous, visible_area);
+        applied_area = visible_area;
+        state.layout_transaction->record_window_modification();
+        constrain();
     }
 }
 
@@ -104,6 +104,8 @@ private:
     WindowController& window_controller;
     geom::Rectangle logical_area;
     std::optional<geom::Rectangle> next_logical_area;
+    /// The rectangle that the window was last given, if it has not been fullscreened since
+    std::optional<geom::Rectangle> applied_area;
     std::shared_ptr<Config> config;
     TilingWindowTree* tree;
     miral::Window window_;
@@ -20,8 +20,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "auto_restarting_launcher.h"
 #include "compositor_state.h"
 #include "config.h"
+#include "frame_clock.h"
+#include "window_ghost.h"
 #include "miracle_gl_config.h"
 #include "policy.h"
+#include "render_statistics.h"
 #include "renderer.h"
 #include "surface_tracker.h"
 #include "version.h"
@@ -83,6 +86,9 @@ int main(int argc, char const* argv[])
 
     WindowManagerOptions* options;
     std::shared_ptr<miracle::WindowToolsAccessor> accessor = std::make_shared<miracle::WindowToolsAccessor>();
+    auto render_statistics = std::make_shared<miracle::RenderStatistics>();
+    auto frame_clock = std::make_shared<miracle::FrameClock>();
+    auto window_ghosts = std::make_shared<miracle::WindowGhosts>();
     ;
     auto window_managers = ServerMiddleman(
         [&](mir::Server& server)
@@ -90,7 +96,7 @@ int main(int argc, char const* argv[])
         config->load(server);
         options = new WindowManagerOptions {
             add_window_manager_policy<miracle::Policy>(
-                "tiling", auto_restarting_launcher, runner, config, surface_tracker, server, compositor_state, accessor)
+                "tiling", auto_restarting_launcher, runner, config, surface_tracker, server, compositor_state, accessor, render_statistics, frame_clock, window_ghosts)
         };
         (*options)(server);
     });
@@ -124,7 +130,7 @@ int main(int argc, char const* argv[])
     }),
             CustomRenderer([&](std::unique_ptr<mir::graphics::gl::OutputSurface> x, std::shared_ptr<mir::graphics::GLRenderingProvider> y)
     {
-        return std::make_unique<miracle::Renderer>(std::move(y), std::move(x), config, surface_tracker, compositor_state, accessor);
+        return std::make_unique<miracle::Renderer>(std::move(y), std::move(x), config, surface_tracker, compositor_state, accessor, render_statistics, frame_clock, window_ghosts);
     }),
             miroil::OpenGLContext(new miracle::GLConfig()) });
 }
@@ -28,6 +28,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "workspace.h"
 #include "workspace_manager.h"
+#include <algorithm>
 #include <glm/gtx/transform.hpp>
 #include <memory>
 #include <mir/log.h>
@@ -78,12 +79,89 @@ std::shared_ptr<Container> Output::intersect(const MirPointerEvent* event)
 
     auto x = miral::toolkit::mir_pointer_event_axis_value(event, MirPointerAxis::mir_pointer_axis_x);
     auto y = miral::toolkit::mir_pointer_event_axis_value(event, MirPointerAxis::mir_pointer_axis_y);
+
+    // Tiles never overlap one another, so the index answers unless something may be stacked
+    // above them or windows are not where their tiles are. In that case, only the window
+    // manager knows what is on top.
+    auto const workspace = active_workspace.lock();
+    geom::Point const point { static_cast<int>(x), static_cast<int>(y) };
+    if (!switching_workspaces
+        && !workspace->get_tree()->has_fullscreen_window()
+        && !workspace->has_floating_content_at(point)
+        && !has_shell_component_at(point)
+        && !animator.is_animating())
+    {
+        if (auto container = tiled_container_at(*workspace, point))
+            return container;
+    }
+
     if (auto const window = tools.window_at({ x, y }))
         return window_controller.get_container(window);
 
     return nullptr;
 }
 
+void Output::trigger_rerender()
+{
+    for (auto const& workspace : workspaces)
+        workspace->trigger_rerender();
+
+    // Shell components are shown whichever workspace is active
+    for (auto const& component : state.shell_components)
+    {
+        auto const locked = component.lock();
+        if (!locked || !locked->get_visible_area().overlaps(area))
+            continue;
+
+        if (auto const window = locked->window())
+        {
+            if (auto const surface = window->operator std::shared_ptr<mir::scene::Surface>())
+                surface->set_transformation(locked->get_transform());
+        }
+    }
+}
+
+bool Output::can_trigger_rerender(Container const* ignored) const
+{
+    bool has_window = false;
+    if (auto const workspace = active())
+    {
+        workspace->for_each_window([&](std::shared_ptr<Container> const& container)
+        {
+            if (container.get() != ignored && container->window())
+                has_window = true;
+        });
+    }
+
+    return has_window || std::ranges::any_of(state.shell_components, [&](auto const& component)
+    {
+        auto const locked = component.lock();
+        return locked && locked->get_visible_area().overlaps(area);
+    });
+}
+
+bool Output::has_shell_component_at(geom::Point const& point) const
+{
+    return std::ranges::any_of(state.shell_components, [&](auto const& component)
+    {
+        auto const locked = component.lock();
+        return locked && locked->get_visible_area().contains(point);
+    });
+}
+
+std::shared_ptr<Container> Output::tiled_container_at(Workspace const& workspace, geom::Point const& point)
+{
+    auto const generation = workspace.get_tree()->get_layout_generation();
+    if (tiled_index_workspace != &workspace || tiled_index_generation != generation)
+    {
+        workspace.build_tiled_index(tiled_index, area);
+        tiled_index_workspace = &workspace;
+        tiled_index_generation = generation;
+    }
+
+    return tiled_index.at(point);
+}
+
 AllocationHint Output::allocate_position(
     miral::ApplicationInfo const& app_info,
     miral::WindowSpecification& requested_specification,
@@ -213,6 +291,8 @@ bool Output::advise_workspace_active(uint32_t id)
     if (from->is_empty())
         workspace_manager.delete_workspace(from->id());
 
+    workspace_switch_id++;
+    switching_workspaces = true;
     animator.workspace_switch(
         handle,
         src,
@@ -233,6 +313,7 @@ bool Output::advise_workspace_active(uint32_t id)
                     workspace->hide();
             }
 
+            switching_workspaces = false;
             to->trigger_rerender();
             return;
         }
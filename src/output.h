@@ -24,7 +24,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "tiling_window_tree.h"
 
 #include "minimal_window_manager.h"
+#include "spatial_index.h"
 #include "workspace.h"
+#include <atomic>
 #include <memory>
 #include <miral/output.h>
 #include <nlohmann/json.hpp>
@@ -91,6 +93,13 @@ public:
     void set_transform(glm::mat4 const& in);
     void set_position(glm::vec2 const&);
 
+    /// The compositor only draws when the scene changes, so this touches every surface that
+    /// is shown on the output, including shell components, to make it draw again.
+    void trigger_rerender();
+
+    /// True if [trigger_rerender] has a surface to touch other than the window of [ignored].
+    [[nodiscard]] bool can_trigger_rerender(Container const* ignored = nullptr) const;
+
     // Getters
 
     [[nodiscard]] std::vector<miral::Window> collect_all_windows() const;
@@ -107,6 +116,14 @@ public:
     [[nodiscard]] Workspace const* workspace(uint32_t id) const;
     [[nodiscard]] nlohmann::json to_json() const;
 
+    /// True while the workspace switch animation is running. The renderer uses this to
+    /// draw snapshots of the workspaces instead of every one of their windows.
+    [[nodiscard]] bool is_switching_workspaces() const { return switching_workspaces; }
+
+    /// Identifies the most recent workspace switch so that the renderer knows when its
+    /// snapshots are out of date.
+    [[nodiscard]] uint32_t get_workspace_switch_id() const { return workspace_switch_id; }
+
 private:
     miral::Output output;
     WorkspaceManager& workspace_manager;
@@ -123,6 +140,15 @@ private:
     bool is_active_ = false;
     AnimationHandle handle;
 
+    /// Tiled windows of the active workspace, rebuilt when the layout of its tree changes
+    SpatialIndex tiled_index;
+    Workspace const* tiled_index_workspace = nullptr;
+    std::optional<uint64_t> tiled_index_generation;
+
+    std::shared_ptr<Container> tiled_container_at(Workspace const& workspace, geom::Point const& point);
+    /// True if a shell component, such as a menu or a panel, covers [point].
+    [[nodiscard]] bool has_shell_component_at(geom::Point const& point) const;
+
     /// The position of the output for scrolling across workspaces
     glm::vec2 position_offset = glm::vec2(0.f);
 
@@ -131,6 +157,10 @@ private:
 
     /// A matrix resulting from combining position + transform
     glm::mat4 final_transform = glm::mat4(1.f);
+
+    /// Read by the renderer thread
+    std::atomic<bool> switching_workspaces = false;
+    std::atomic<uint32_t> workspace_switch_id = 0;
 };
 
 }
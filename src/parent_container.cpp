@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #define MIR_LOG_COMPONENT "parent_container"
 #include "parent_container.h"
+#include "auto_layout.h"
 #include "compositor_state.h"
 #include "config.h"
 #include "container.h"
@@ -24,67 +25,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "output.h"
 #include "tiling_window_tree.h"
 #include "workspace.h"
+#include <algorithm>
 #include <cmath>
 #include <mir/log.h>
+#include <numeric>
 
 using namespace miracle;
 
-namespace
-{
-struct InsertNodeInternalResult
-{
-    int size;
-    int position;
-};
-
-InsertNodeInternalResult insert_node_internal(
-    int lane_size,
-    int lane_pos,
-    int index,
-    size_t node_count,
-    std::function<int(int)> const& get_node_size,
-    std::function<void(int, int, int)> const& set_node_size_position)
-{
-    int new_item_size = floor((double)lane_size / (double)(node_count + 1));
-    int new_item_position = lane_pos + index * new_item_size;
-
-    int size_lost = 0;
-    int prev_pos = lane_pos;
-    int prev_size = 0;
-    for (int i = 0; i < node_count; i++)
-    {
-        int node_size = get_node_size(i);
-
-        // Each node will lose a percentage of its width that corresponds to what it can give
-        // (meaning that larger nodes give more width, and lesser nodes give less width)
-        double percent_size_lost = ((double)node_size / (double)lane_size);
-        int width_to_lose = (int)floor(percent_size_lost * new_item_size);
-        size_lost += width_to_lose;
-
-        if (i == index)
-        {
-            prev_size = new_item_size;
-            prev_pos = new_item_position;
-        }
-
-        int changed_node_size = node_size - width_to_lose;
-        int changed_node_pos = prev_pos + prev_size;
-        set_node_size_position(i, changed_node_size, changed_node_pos);
-
-        prev_pos = changed_node_pos;
-        prev_size = changed_node_size;
-    }
-
-    if (node_count)
-    {
-        new_item_size += size_lost - new_item_size;
-        new_item_position -= size_lost - new_item_size;
-    }
-
-    return { new_item_size, new_item_position };
-}
-}
-
 ParentContainer::ParentContainer(
     WindowController& node_interface,
     geom::Rectangle area,
@@ -102,6 +49,20 @@ ParentContainer::ParentContainer(
 {
 }
 
+ParentContainer::~ParentContainer()
+{
+    // Children that outlive us, or that were adopted by another parent, must not
+    // follow a link back to freed memory
+    for (auto const& node : sub_nodes)
+    {
+        if (node->parent_link == this)
+        {
+            node->parent_link = nullptr;
+            node->index_in_parent = -1;
+        }
+    }
+}
+
 geom::Rectangle ParentContainer::get_logical_area() const
 {
     if (parent.lock() == nullptr)
@@ -129,91 +90,84 @@ size_t ParentContainer::num_nodes() const
     return sub_nodes.size();
 }
 
-geom::Rectangle ParentContainer::create_space(int pending_index)
+std::vector<geom::Rectangle> ParentContainer::get_child_areas() const
 {
-    // TODO: When making space, we should ask the currently
-    //  selected window if it wants to be a lane. If it does, we
-    //  will grant its request and create a new lane.
+    auto const placement_area = get_logical_area();
+    if (auto_layout != AutoLayout::none)
+        return compute_auto_layout(auto_layout, placement_area, weights);
 
-    auto placement_area = get_logical_area();
-    geom::Rectangle pending_logical_rect;
+    std::vector<geom::Rectangle> areas(weights.size(), placement_area);
     if (scheme == LayoutScheme::horizontal)
     {
-        auto result = insert_node_internal(
-            placement_area.size.width.as_int(),
-            placement_area.top_left.x.as_int(),
-            pending_index,
-            sub_nodes.size(),
-            [&](int index)
-        { return sub_nodes[index]->get_logical_area().size.width.as_int(); },
-            [&](int index, int size, int pos)
+        auto const spans = apportion(placement_area.size.width.as_int(), weights);
+        int x = placement_area.top_left.x.as_int();
+        for (size_t i = 0; i < areas.size(); i++)
         {
-            sub_nodes[index]->set_logical_area({
-                geom::Point {
-                             pos,
-                             placement_area.top_left.y.as_int()  },
-                geom::Size {
-                             size,
-                             placement_area.size.height.as_int() }
-            });
-        });
-        geom::Rectangle new_node_logical_rect = {
-            geom::Point {
-                         result.position,
-                         placement_area.top_left.y.as_int()  },
-            geom::Size {
-                         result.size,
-                         placement_area.size.height.as_int() }
-        };
-        pending_logical_rect = new_node_logical_rect;
+            areas[i].top_left.x = geom::X { x };
+            areas[i].size.width = geom::Width { spans[i] };
+            x += spans[i];
+        }
     }
     else if (scheme == LayoutScheme::vertical)
     {
-        auto result = insert_node_internal(
-            placement_area.size.height.as_int(),
-            placement_area.top_left.y.as_int(),
-            pending_index,
-            sub_nodes.size(),
-            [&](int index)
-        { return sub_nodes[index]->get_logical_area().size.height.as_int(); },
-            [&](int index, int size, int pos)
+        auto const spans = apportion(placement_area.size.height.as_int(), weights);
+        int y = placement_area.top_left.y.as_int();
+        for (size_t i = 0; i < areas.size(); i++)
         {
-            sub_nodes[index]->set_logical_area({
-                geom::Point {
-                             placement_area.top_left.x.as_int(),
-                             pos  },
-                geom::Size {
-                             placement_area.size.width.as_int(),
-                             size }
-            });
-        });
-        geom::Rectangle new_node_logical_rect = {
-            geom::Point {
-                         placement_area.top_left.x.as_int(),
-                         result.position },
-            geom::Size {
-                         placement_area.size.width.as_int(),
-                         result.size     }
-        };
-        pending_logical_rect = new_node_logical_rect;
+            areas[i].top_left.y = geom::Y { y };
+            areas[i].size.height = geom::Height { spans[i] };
+            y += spans[i];
+        }
     }
-    else if (scheme == LayoutScheme::tabbing || scheme == LayoutScheme::stacking)
+    else if (scheme != LayoutScheme::tabbing && scheme != LayoutScheme::stacking)
     {
-        pending_logical_rect = placement_area;
+        mir::log_error("Cannot get_child_areas with invalid scheme");
     }
-    else
+
+    return areas;
+}
+
+void ParentContainer::normalize_weights()
+{
+    double total = 0;
+    for (auto const weight : weights)
+        total += weight;
+
+    if (total <= 0)
     {
-        mir::fatal_error("Invalid scheme during create_space");
+        std::fill(weights.begin(), weights.end(), 1.0 / (double)weights.size());
+        return;
     }
 
-    return pending_logical_rect;
+    for (auto& weight : weights)
+        weight /= total;
+}
+
+geom::Rectangle ParentContainer::create_space(int pending_index)
+{
+    // TODO: When making space, we should ask the currently
+    //  selected window if it wants to be a lane. If it does, we
+    //  will grant its request and create a new lane.
+
+    // The new node takes an equal share, and everyone else gives up space in proportion
+    // to what they currently own.
+    double const new_weight = 1.0 / (double)(weights.size() + 1);
+    for (auto& weight : weights)
+        weight *= 1.0 - new_weight;
+    weights.insert(weights.begin() + pending_index, new_weight);
+
+    auto const areas = get_child_areas();
+    for (size_t i = 0; i < sub_nodes.size(); i++)
+        sub_nodes[i]->set_logical_area(areas[(int)i < pending_index ? i : i + 1]);
+
+    return areas[pending_index];
 }
 
 std::shared_ptr<LeafContainer> ParentContainer::create_space_for_window(int pending_index)
 {
     if (pending_index < 0)
         pending_index = num_nodes();
-    pending_node = std::make_shared<LeafContainer>(
+    pending_node = tree->get_pool().make<LeafContainer>(
         node_interface,
         create_space(pending_index),
         config,
@@ -221,6 +175,8 @@ std::shared_ptr<LeafContainer> ParentContainer::create_space_for_window(int pend
         as_parent(shared_from_this()),
         state);
     sub_nodes.insert(sub_nodes.begin() + pending_index, pending_node);
+    reindex(pending_index);
+    invalidate_min_size();
     return pending_node;
 }
 
@@ -236,7 +192,7 @@ std::shared_ptr<LeafContainer> ParentContainer::confirm_window(miral::Window con
     pending_node->associate_to_window(window);
     pending_node->set_parent(Container::as_parent(shared_from_this()));
     pending_node = nullptr;
-    commit_changes();
+    state.layout_transaction->commit(shared_from_this());
     return retval;
 }
 
@@ -246,7 +202,8 @@ void ParentContainer::graft_existing(std::shared_ptr<Container> const& node, int
     node->set_parent(as_parent(shared_from_this()));
     node->set_logical_area(rectangle);
     sub_nodes.insert(sub_nodes.begin() + index, node);
-    relayout();
+    reindex(index);
+    invalidate_min_size();
     constrain();
 }
 
@@ -259,7 +216,7 @@ std::shared_ptr<ParentContainer> ParentContainer::convert_to_parent(std::shared_
         return nullptr;
     }
 
-    auto new_parent_node = std::make_shared<ParentContainer>(
+    auto new_parent_node = tree->get_pool().make<ParentContainer>(
         node_interface,
         container->get_logical_area(),
         config,
@@ -267,125 +224,29 @@ std::shared_ptr<ParentContainer> ParentContainer::convert_to_parent(std::shared_
         Container::as_parent(shared_from_this()),
         state);
     new_parent_node->sub_nodes.push_back(container);
+    new_parent_node->weights.push_back(1.0);
+    new_parent_node->reindex();
     container->set_parent(new_parent_node);
     sub_nodes[index] = new_parent_node;
+    new_parent_node->index_in_parent = index;
+    new_parent_node->parent_link = this;
+    invalidate_min_size();
     return new_parent_node;
 }
 
 void ParentContainer::set_logical_area(const geom::Rectangle& target_rect)
 {
-    // We are setting the size of the lane, but each window might have an idea of how
-    // its own height relates to the lane (e.g. I take up 300px of 900px lane while my
-    // neighbor takes up the remaining 600px, horizontally).
-    // We need to look at the target dimension and scale everyone relative to that.
-    // However, the "non-main-axis" dimension will be consistent across each node.
-    auto current_logical_area = get_logical_area();
+    // Children own a fraction of the lane rather than a pixel size, so the new
+    // rectangles are derived from the weights and never from the old rectangles.
     logical_area = target_rect;
-    auto target_placement_area = get_logical_area();
-    std::vector<geom::Rectangle> pending_size_updates;
-    pending_size_updates.reserve(sub_nodes.size());
-    if (scheme == LayoutScheme::horizontal)
-    {
-        int total_width = 0;
-        for (size_t idx = 0; idx < sub_nodes.size(); idx++)
-        {
-            auto item = sub_nodes[idx];
-            auto item_rect = item->get_logical_area();
-            double percent_width_taken = (double)item_rect.size.width.as_int() / (double)current_logical_area.size.width.as_int();
-            int new_width = (int)ceil((double)target_placement_area.size.width.as_int() * percent_width_taken);
-
-            geom::Rectangle new_item_rect;
-            new_item_rect.size = geom::Size {
-                geom::Width { new_width },
-                target_placement_area.size.height
-            };
-            if (idx == 0)
-            {
-                new_item_rect.top_left = geom::Point {
-                    target_placement_area.top_left.x,
-                    target_placement_area.top_left.y
-                };
-            }
-            else
-            {
-                auto const& prev_rect = pending_size_updates[idx - 1];
-                new_item_rect.top_left = geom::Point {
-                    geom::X { prev_rect.top_left.x.as_int() + prev_rect.size.width.as_int() },
-                    target_placement_area.top_left.y
-                };
-            }
-
-            pending_size_updates.push_back(new_item_rect);
-            total_width += new_width;
-        }
-
-        if (!pending_size_updates.empty())
-        {
-            int leftover_width = target_placement_area.size.width.as_int() - total_width;
-            pending_size_updates.back().size.width = geom::Width { pending_size_updates.back().size.width.as_int() + leftover_width };
-        }
-    }
-    else if (scheme == LayoutScheme::vertical)
-    {
-        int total_height = 0;
-        for (size_t idx = 0; idx < sub_nodes.size(); idx++)
-        {
-            auto item = sub_nodes[idx];
-            auto item_rect = item->get_logical_area();
-            double percent_height_taken = static_cast<double>(item_rect.size.height.as_int()) / current_logical_area.size.height.as_int();
-            int new_height = (int)floor((double)target_placement_area.size.height.as_int() * percent_height_taken);
-
-            geom::Rectangle new_item_rect;
-            new_item_rect.size = geom::Size {
-                target_placement_area.size.width,
-                geom::Height { new_height },
-            };
-            if (idx == 0)
-            {
-                new_item_rect.top_left = geom::Point {
-                    target_placement_area.top_left.x,
-                    target_placement_area.top_left.y
-                };
-            }
-            else
-            {
-                auto const& prev_rect = pending_size_updates[idx - 1];
-                new_item_rect.top_left = geom::Point {
-                    target_placement_area.top_left.x,
-                    geom::Y { prev_rect.top_left.y.as_int() + prev_rect.size.height.as_int() },
-                };
-            }
-
-            pending_size_updates.push_back(new_item_rect);
-            total_height += new_height;
-        }
-
-        if (!pending_size_updates.empty())
-        {
-            int leftover_height = target_placement_area.size.height.as_int() - total_height;
-            pending_size_updates.back().size.height = geom::Height { pending_size_updates.back().size.height.as_int() + leftover_height };
-        }
-    }
-    else if (scheme == LayoutScheme::tabbing || scheme == LayoutScheme::stacking)
-    {
-        for (size_t idx = 0; idx < sub_nodes.size(); idx++)
-        {
-            pending_size_updates.push_back(target_placement_area);
-        }
-    }
-    else
-    {
-        mir::log_error("Cannot set_logical_area with invalid scheme");
-    }
-
+    auto const areas = get_child_areas();
     for (size_t i = 0; i < sub_nodes.size(); i++)
-    {
-        sub_nodes[i]->set_logical_area(pending_size_updates[i]);
-    }
+        sub_nodes[i]->set_logical_area(areas[i]);
 }
 
 void ParentContainer::commit_changes()
 {
+    tree->advise_layout_changed();
     for (auto& node : sub_nodes)
         node->commit_changes();
 }
@@ -439,18 +300,25 @@ void ParentContainer::swap_nodes(std::shared_ptr<Container> const& first, std::s
     auto second_index = get_index_of_node(second);
     sub_nodes[second_index] = first;
     sub_nodes[first_index] = second;
+    first->index_in_parent = second_index;
+    second->index_in_parent = first_index;
+    std::swap(weights[first_index], weights[second_index]);
     relayout();
     constrain();
 }
 
 void ParentContainer::remove(const std::shared_ptr<Container>& node)
 {
-    sub_nodes.erase(
-        std::remove_if(sub_nodes.begin(), sub_nodes.end(), [&](std::shared_ptr<Container> const& content)
+    auto index = get_index_of_node(node);
+    if (index >= 0)
     {
-        return content == node;
-    }),
-        sub_nodes.end());
+        sub_nodes.erase(sub_nodes.begin() + index);
+        weights.erase(weights.begin() + index);
+        normalize_weights();
+        node->index_in_parent = -1;
+        node->parent_link = nullptr;
+        reindex(index);
+    }
 
     // If we have one child AND it is a lane, THEN we can absorb all of it's children
     if (sub_nodes.size() == 1 && sub_nodes[0]->is_lane())
@@ -462,19 +330,203 @@ void ParentContainer::remove(const std::shared_ptr<Container>& node)
             sub_nodes.push_back(sub_node);
             sub_node->set_parent(as_parent(shared_from_this()));
         }
+        weights = dying_lane->weights;
+        reindex();
         set_layout(dying_lane->get_direction());
     }
 
+    invalidate_min_size();
     relayout();
 }
 
+bool ParentContainer::resize_node(Container const& node, int amount)
+{
+    auto index = get_index_of_node(node);
+    if (index < 0 || sub_nodes.size() < 2)
+        return false;
+
+    if (auto_layout != AutoLayout::none)
+        return resize_auto_layout_node(index, amount);
+
+    if (scheme != LayoutScheme::horizontal && scheme != LayoutScheme::vertical)
+        return false;
+
+    bool const is_horizontal = scheme == LayoutScheme::horizontal;
+    auto const placement_area = get_logical_area();
+    int const length = is_horizontal ? placement_area.size.width.as_int() : placement_area.size.height.as_int();
+    if (length <= 0)
+        return false;
+
+    auto next_weights = get_resized_weights(index, amount, length);
+    auto const spans = apportion(length, next_weights);
+    for (size_t i = 0; i < sub_nodes.size(); i++)
+    {
+        auto const min_size = is_horizontal ? sub_nodes[i]->get_min_width() : sub_nodes[i]->get_min_height();
+        if (spans[i] <= 0 || spans[i] <= (int)min_size)
+        {
+            mir::log_warning("Unable to resize a rectangle that would cause another to be negative");
+            return false;
+        }
+    }
+
+    weights = std::move(next_weights);
+    normalize_weights();
+    relayout();
+    return true;
+}
+
+bool ParentContainer::resize_auto_layout_node(int index, int amount)
+{
+    // Every cell of a grid is the same size, so the weights have no effect
+    if (auto_layout == AutoLayout::grid)
+        return false;
+
+    // Automatic layouts have no single main axis, so the amount is measured against the width
+    auto const placement_area = get_logical_area();
+    int const length = placement_area.size.width.as_int();
+    if (length <= 0)
+        return false;
+
+    auto next_weights = get_resized_weights(index, amount, length);
+    auto const areas = compute_auto_layout(auto_layout, placement_area, next_weights);
+    for (size_t i = 0; i < sub_nodes.size(); i++)
+    {
+        if (areas[i].size.width.as_int() <= (int)sub_nodes[i]->get_min_width()
+            || areas[i].size.height.as_int() <= (int)sub_nodes[i]->get_min_height())
+        {
+            mir::log_warning("Unable to resize a rectangle that would cause another to be negative");
+            return false;
+        }
+    }
+
+    weights = std::move(next_weights);
+    normalize_weights();
+    relayout();
+    return true;
+}
+
+std::vector<double> ParentContainer::get_resized_weights(int index, int amount, int length) const
+{
+    // The node grows by [amount] and everyone else shrinks by an equal share of it
+    double const delta = (double)amount / (double)length;
+    double const delta_for_others = -delta / (double)(sub_nodes.size() - 1);
+    auto next_weights = weights;
+    for (size_t i = 0; i < next_weights.size(); i++)
+        next_weights[i] += (int)i == index ? delta : delta_for_others;
+    return next_weights;
+}
+
+void ParentContainer::set_auto_layout(AutoLayout layout)
+{
+    auto_layout = layout;
+    relayout();
+    state.layout_transaction->commit(shared_from_this());
+}
+
 int ParentContainer::get_index_of_node(miracle::Container const* node) const
 {
-    for (int i = 0; i < sub_nodes.size(); i++)
-        if (sub_nodes[i].get() == node)
-            return i;
+    // The stored index may belong to another parent, so we confirm that it points back here
+    if (node == nullptr)
+        return -1;
+
+    auto const index = node->index_in_parent;
+    if (index < 0 || index >= (int)sub_nodes.size() || sub_nodes[index].get() != node)
+        return -1;
 
-    return -1;
+    return index;
+}
+
+std::shared_ptr<Container> ParentContainer::get_sibling(Container const& node, int offset) const
+{
+    auto const index = get_index_of_node(&node);
+    if (index < 0 || index + offset < 0)
+        return nullptr;
+
+    return at(index + offset);
+}
+
+std::shared_ptr<Container> ParentContainer::get_auto_layout_neighbor(Container const& node, Direction direction) const
+{
+    auto const index = get_index_of_node(&node);
+    if (index < 0)
+        return nullptr;
+
+    auto const areas = get_child_areas();
+    auto const& from = areas[index];
+    std::shared_ptr<Container> best;
+    int best_distance = 0;
+    int best_overlap = 0;
+    for (size_t i = 0; i < areas.size(); i++)
+    {
+        auto const& to = areas[i];
+        int distance;
+        int overlap;
+        switch (direction)
+        {
+        case Direction::left:
+            distance = from.left().as_int() - to.right().as_int();
+            overlap = std::min(from.bottom().as_int(), to.bottom().as_int()) - std::max(from.top().as_int(), to.top().as_int());
+            break;
+        case Direction::right:
+            distance = to.left().as_int() - from.right().as_int();
+            overlap = std::min(from.bottom().as_int(), to.bottom().as_int()) - std::max(from.top().as_int(), to.top().as_int());
+            break;
+        case Direction::up:
+            distance = from.top().as_int() - to.bottom().as_int();
+            overlap = std::min(from.right().as_int(), to.right().as_int()) - std::max(from.left().as_int(), to.left().as_int());
+            break;
+        case Direction::down:
+            distance = to.top().as_int() - from.bottom().as_int();
+            overlap = std::min(from.right().as_int(), to.right().as_int()) - std::max(from.left().as_int(), to.left().as_int());
+            break;
+        default:
+            return nullptr;
+        }
+
+        if ((int)i == index || distance < 0 || overlap <= 0)
+            continue;
+
+        if (!best || distance < best_distance || (distance == best_distance && overlap > best_overlap))
+        {
+            best = sub_nodes[i];
+            best_distance = distance;
+            best_overlap = overlap;
+        }
+    }
+
+    return best;
+}
+
+bool ParentContainer::reaches_edge(Container const& node, Direction direction) const
+{
+    auto const index = get_index_of_node(&node);
+    if (index < 0)
+        return true;
+
+    auto const area = get_child_areas()[index];
+    auto const lane = get_logical_area();
+    switch (direction)
+    {
+    case Direction::left:
+        return area.left() <= lane.left();
+    case Direction::right:
+        return area.right() >= lane.right();
+    case Direction::up:
+        return area.top() <= lane.top();
+    case Direction::down:
+        return area.bottom() >= lane.bottom();
+    default:
+        return true;
+    }
+}
+
+void ParentContainer::reindex(size_t from)
+{
+    for (size_t i = from; i < sub_nodes.size(); i++)
+    {
+        sub_nodes[i]->index_in_parent = (int)i;
+        sub_nodes[i]->parent_link = this;
+    }
 }
 
 int ParentContainer::get_index_of_node(std::shared_ptr<Container> const& node) const
@@ -495,18 +547,36 @@ void ParentContainer::constrain()
 
 size_t ParentContainer::get_min_width() const
 {
-    size_t size = 0;
-    for (auto const& node : sub_nodes)
-        size += node->get_min_width();
-    return size;
+    if (!cached_min_width)
+    {
+        size_t size = 0;
+        for (auto const& node : sub_nodes)
+            size += node->get_min_width();
+        cached_min_width = size;
+    }
+
+    return cached_min_width.value();
 }
 
 size_t ParentContainer::get_min_height() const
 {
-    size_t size = 0;
-    for (auto const& node : sub_nodes)
-        size += node->get_min_height();
-    return size;
+    if (!cached_min_height)
+    {
+        size_t size = 0;
+        for (auto const& node : sub_nodes)
+            size += node->get_min_height();
+        cached_min_height = size;
+    }
+
+    return cached_min_height.value();
+}
+
+void ParentContainer::invalidate_min_size()
+{
+    cached_min_width.reset();
+    cached_min_height.reset();
+    if (auto const locked_parent = parent.lock())
+        locked_parent->invalidate_min_size();
 }
 
 std::weak_ptr<ParentContainer> ParentContainer::get_parent() const
@@ -521,53 +591,6 @@ void ParentContainer::set_parent(std::shared_ptr<ParentContainer> const& in_pare
 
 void ParentContainer::relayout()
 {
-    auto placement_area = get_logical_area();
-    if (scheme == LayoutScheme::horizontal)
-    {
-        int total_width = 0;
-        for (auto const& node : sub_nodes)
-        {
-            total_width += node->get_logical_area().size.width.as_int();
-        }
-
-        int diff_width = placement_area.size.width.as_value() - total_width;
-        int diff_per_node = floor((double)diff_width / (double)sub_nodes.size());
-        for (auto const& node : sub_nodes)
-        {
-            auto rectangle = node->get_logical_area();
-            rectangle.size.width = geom::Width { rectangle.size.width.as_int() + diff_per_node };
-            rectangle.size.height = geom::Height { placement_area.size.height };
-            node->set_logical_area(rectangle);
-        }
-    }
-    else if (scheme == LayoutScheme::vertical)
-    {
-        int total_height = 0;
-        for (auto const& node : sub_nodes)
-        {
-            total_height += node->get_logical_area().size.height.as_int();
-        }
-
-        int diff_width = placement_area.size.height.as_value() - total_height;
-        int diff_per_node = floor((double)diff_width / (double)sub_nodes.size());
-        for (auto const& node : sub_nodes)
-        {
-            auto rectangle = node->get_logical_area();
-            rectangle.size.width = geom::Width { placement_area.size.width };
-            rectangle.size.height = geom::Height { rectangle.size.height.as_int() + diff_per_node };
-            node->set_logical_area(rectangle);
-        }
-    }
-    else if (scheme == LayoutScheme::tabbing || scheme == LayoutScheme::stacking)
-    {
-        for (auto const& node : sub_nodes)
-            node->set_logical_area(placement_area);
-    }
-    else
-    {
-        mir::log_error("Invalid scheme during relayout");
-    }
-
     // Note that it is important to use the logical_area here instead of the placement area
     set_logical_area(logical_area);
 }
@@ -791,7 +814,7 @@ bool ParentContainer::set_layout(LayoutScheme new_scheme)
     scheme = new_scheme;
     relayout();
     constrain();
-    commit_changes();
+    state.layout_transaction->commit(shared_from_this());
     return true;
 }
 
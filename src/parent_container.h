@@ -18,10 +18,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIRACLEWM_PARENT_NODE_H
 #define MIRACLEWM_PARENT_NODE_H
 
+#include "auto_layout.h"
 #include "container.h"
 #include "layout_scheme.h"
 #include "window_controller.h"
 #include <mir/geometry/rectangle.h>
+#include <optional>
 
 namespace geom = mir::geometry;
 
@@ -44,6 +46,7 @@ public:
         TilingWindowTree* tree,
         std::shared_ptr<ParentContainer> const& parent,
         CompositorState const& state);
+    ~ParentContainer();
     geom::Rectangle get_logical_area() const override;
     geom::Rectangle get_visible_area() const override;
     size_t num_nodes() const;
@@ -54,6 +57,11 @@ public:
     void set_logical_area(geom::Rectangle const& target_rect) override;
     void swap_nodes(std::shared_ptr<Container> const& first, std::shared_ptr<Container> const& second);
     void remove(std::shared_ptr<Container> const& node);
+
+    /// Grows [node] by [amount] pixels along the main axis, taking the space evenly from
+    /// its siblings. Returns false, leaving the layout untouched, if a sibling would drop
+    /// to its minimum size.
+    bool resize_node(Container const& node, int amount);
     void commit_changes() override;
     std::shared_ptr<Container> at(size_t i) const;
     std::shared_ptr<LeafContainer> get_nth_window(size_t i) const;
@@ -63,9 +71,23 @@ public:
     [[nodiscard]] int get_index_of_node(Container const* node) const;
     [[nodiscard]] int get_index_of_node(std::shared_ptr<Container> const& node) const;
     [[nodiscard]] int get_index_of_node(Container const&) const;
+
+    /// Returns the child [offset] places away from [node], or nullptr if there is none.
+    [[nodiscard]] std::shared_ptr<Container> get_sibling(Container const& node, int offset) const;
+
+    /// Returns the child that lies next to [node] in [direction] under an automatic layout.
+    /// Of several candidates, the nearest one that shares the longest edge with [node] wins.
+    [[nodiscard]] std::shared_ptr<Container> get_auto_layout_neighbor(Container const& node, Direction direction) const;
+
+    /// True if the area of [node] reaches the edge of this lane in [direction].
+    [[nodiscard]] bool reaches_edge(Container const& node, Direction direction) const;
     void constrain() override;
     size_t get_min_width() const override;
     size_t get_min_height() const override;
+
+    /// Drops the cached minimum size of this container and of every ancestor. Must be
+    /// called whenever the children or their constraints change.
+    void invalidate_min_size();
     std::weak_ptr<ParentContainer> get_parent() const override;
     void set_parent(std::shared_ptr<ParentContainer> const&) override;
     void handle_ready() override;
@@ -112,6 +134,10 @@ public:
     nlohmann::json to_json() const override;
     [[nodiscard]] LayoutScheme get_scheme() const { return scheme; }
 
+    /// When set, the children are placed by [layout] instead of being split along [scheme].
+    void set_auto_layout(AutoLayout layout);
+    [[nodiscard]] AutoLayout get_auto_layout() const { return auto_layout; }
+
 private:
     WindowController& node_interface;
     geom::Rectangle logical_area;
@@ -121,10 +147,23 @@ private:
     CompositorState const& state;
 
     LayoutScheme scheme = LayoutScheme::horizontal;
+    AutoLayout auto_layout = AutoLayout::none;
     std::vector<std::shared_ptr<Container>> sub_nodes;
+
+    /// The fraction of the main axis owned by each entry in [sub_nodes]. Always sums to 1.
+    std::vector<double> weights;
     std::shared_ptr<LeafContainer> pending_node;
+    mutable std::optional<size_t> cached_min_width;
+    mutable std::optional<size_t> cached_min_height;
 
     geom::Rectangle create_space(int pending_index);
+    std::vector<geom::Rectangle> get_child_areas() const;
+    void normalize_weights();
+    bool resize_auto_layout_node(int index, int amount);
+    [[nodiscard]] std::vector<double> get_resized_weights(int index, int amount, int length) const;
+
+    /// Updates the stored index of every child from [from] onwards.
+    void reindex(size_t from = 0);
     void relayout();
 };
 
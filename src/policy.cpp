@@ -18,16 +18,23 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define MIR_LOG_COMPONENT "miracle"
 
 #include "policy.h"
+#include "animation_trace.h"
 #include "config.h"
 #include "container_group_container.h"
 #include "feature_flags.h"
+#include "frame_clock.h"
 #include "shell_component_container.h"
+#include "window_ghost.h"
 #include "window_tools_accessor.h"
+#include "workspace.h"
 #include "workspace_manager.h"
 
+#include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <mir/geometry/rectangle.h>
 #include <mir/log.h>
+#include <mir/scene/surface.h>
 #include <mir/server.h>
 #include <mir_toolkit/events/enums.h>
 #include <miral/application_info.h>
@@ -51,7 +58,10 @@ Policy::Policy(
     SurfaceTracker& surface_tracker,
     mir::Server const& server,
     CompositorState& compositor_state,
-    std::shared_ptr<WindowToolsAccessor> const& window_tools_accessor) :
+    std::shared_ptr<WindowToolsAccessor> const& window_tools_accessor,
+    std::shared_ptr<RenderStatistics> const& render_statistics,
+    std::shared_ptr<FrameClock> const& frame_clock,
+    std::shared_ptr<WindowGhosts> const& window_ghosts) :
     window_manager_tools { tools },
     state { compositor_state },
     floating_window_manager(std::make_shared<MinimalWindowManager>(tools, config)),
@@ -70,9 +80,26 @@ Policy::Policy(
     window_controller(tools, animator, state),
     i3_command_executor(*this, workspace_manager, tools, external_client_launcher, window_controller),
     surface_tracker { surface_tracker },
-    ipc { std::make_shared<Ipc>(runner, workspace_manager, *this, server.the_main_loop(), i3_command_executor, config) }
+    frame_clock { frame_clock },
+    window_ghosts { window_ghosts },
+    ipc { std::make_shared<Ipc>(runner, workspace_manager, *this, server.the_main_loop(), i3_command_executor, config, render_statistics) }
 {
     animator.start();
+    if (auto const trace_path = getenv("MIRACLE_WM_ANIMATION_TRACE"); trace_path && *trace_path)
+    {
+        // Used to capture animation bugs so that they can be replayed with miracle-wm-animation-replay
+        auto trace = std::make_shared<std::ofstream>(trace_path, std::ios::binary | std::ios::trunc);
+        if (*trace)
+        {
+            mir::log_info("Recording animations to %s", trace_path);
+            animator.set_recorder(std::make_shared<AnimationRecorder>(trace));
+        }
+        else
+            mir::log_error("Unable to open animation trace: %s", trace_path);
+    }
+
+    frame_clock->set_listener([this](FrameClock::Frame const& frame)
+    { animator.on_frame(frame.time, frame.source, frame.refresh_period); });
     workspace_observer_registrar.register_interest(ipc);
     mode_observer_registrar.register_interest(ipc);
     window_tools_accessor->set_tools(tools);
@@ -80,6 +107,7 @@ Policy::Policy(
 
 Policy::~Policy()
 {
+    frame_clock->clear_listener();
     workspace_observer_registrar.unregister_interest(ipc.get());
     mode_observer_registrar.unregister_interest(ipc.get());
 }
@@ -338,6 +366,8 @@ void Policy::advise_new_window(miral::WindowInfo const& window_info)
     }
 
     auto container = shared_output->create_container(window_info, pending_allocation);
+    if (container->get_type() == ContainerType::shell)
+        state.shell_components.push_back(container);
 
     container->animation_handle(animator.register_animateable());
     container->on_open();
@@ -437,15 +467,79 @@ void Policy::advise_delete_window(const miral::WindowInfo& window_info)
         return;
     }
 
+    start_close_animation(window_info, container);
     if (container->get_output())
         container->get_output()->delete_container(container);
 
+    if (container->get_type() == ContainerType::shell)
+    {
+        std::erase_if(state.shell_components, [&](auto const& component)
+        {
+            auto const locked = component.lock();
+            return !locked || locked == container;
+        });
+    }
+
     surface_tracker.remove(window_info.window());
 
     if (state.active == container)
         state.active = nullptr;
 }
 
+void Policy::start_close_animation(miral::WindowInfo const& window_info, std::shared_ptr<Container> const& container)
+{
+    if (!config->are_animations_enabled()
+        || config->get_animation_definitions()[(int)AnimateableEvent::window_close].type == AnimationType::disabled)
+        return;
+
+    if (window_info.parent() || container->window() != window_info.window())
+        return;
+
+    auto const output_it = std::ranges::find_if(output_list, [&](auto const& output)
+    { return output.get() == container->get_output(); });
+    if (output_it == output_list.end())
+        return;
+
+    // Each step of the animation makes the output draw again by touching the surfaces on it.
+    // Without any, the ghost would be left on screen mid-way.
+    if (!(*output_it)->can_trigger_rerender(container.get()))
+        return;
+
+    std::shared_ptr<mir::scene::Surface> surface = window_info.window();
+    if (!surface || !surface->visible())
+        return;
+
+    auto ghost = WindowGhost::capture(
+        *surface,
+        (*output_it)->get_area(),
+        container->get_output_transform() * container->get_workspace_transform());
+    if (!ghost)
+        return;
+
+    window_ghosts->add(ghost);
+
+    // The window's own handle is reused so that any animation still in flight for it is replaced
+    std::weak_ptr<Output> output = *output_it;
+    animator.window_close(
+        container->animation_handle(),
+        [this, ghost, output](AnimationStepResult const& result)
+    {
+        auto const locked = output.lock();
+        if (result.is_complete || !locked)
+            window_ghosts->remove(ghost);
+        else
+        {
+            if (result.transform)
+                ghost->set_transformation(result.transform.value());
+            if (result.alpha)
+                ghost->set_alpha(result.alpha.value());
+        }
+
+        if (locked)
+            locked->trigger_rerender();
+    });
+}
+
 void Policy::advise_move_to(miral::WindowInfo const& window_info, geom::Point top_left)
 {
     auto container = window_controller.get_container(window_info.window());
@@ -460,6 +554,7 @@ void Policy::advise_move_to(miral::WindowInfo const& window_info, geom::Point to
 
 void Policy::advise_output_create(miral::Output const& output)
 {
+    frame_clock->set_refresh_rate(output.extents(), output.refresh_rate());
     auto output_content = std::make_shared<Output>(
         output, workspace_manager, output.extents(), window_manager_tools,
         floating_window_manager, state, config, window_controller, animator);
@@ -485,6 +580,8 @@ void Policy::advise_output_create(miral::Output const& output)
 
 void Policy::advise_output_update(miral::Output const& updated, miral::Output const& original)
 {
+    frame_clock->remove_output(original.extents());
+    frame_clock->set_refresh_rate(updated.extents(), updated.refresh_rate());
     for (auto& output : output_list)
     {
         if (output->get_output().is_same_output(original))
@@ -497,6 +594,7 @@ void Policy::advise_output_update(miral::Output const& updated, miral::Output co
 
 void Policy::advise_output_delete(miral::Output const& output)
 {
+    frame_clock->remove_output(output.extents());
     for (auto it = output_list.begin(); it != output_list.end(); it++)
     {
         auto other_output = *it;
@@ -49,6 +49,9 @@ namespace miracle
 class Container;
 class ContainerGroupContainer;
 class WindowToolsAccessor;
+class RenderStatistics;
+class FrameClock;
+class WindowGhosts;
 
 class Policy : public miral::WindowManagementPolicy
 {
@@ -61,7 +64,10 @@ public:
         SurfaceTracker&,
         mir::Server const&,
         CompositorState&,
-        std::shared_ptr<WindowToolsAccessor> const&);
+        std::shared_ptr<WindowToolsAccessor> const&,
+        std::shared_ptr<RenderStatistics> const&,
+        std::shared_ptr<FrameClock> const&,
+        std::shared_ptr<WindowGhosts> const&);
     ~Policy() override;
 
     // Interactions with the engine
@@ -140,10 +146,13 @@ public:
     [[nodiscard]] std::vector<std::shared_ptr<Output>> const& get_output_list() const { return output_list; }
     [[nodiscard]] geom::Point const& get_cursor_position() const { return state.cursor_position; }
     [[nodiscard]] CompositorState const& get_state() const { return state; }
+    [[nodiscard]] AnimationBudget const& get_animation_budget() const { return animator.get_budget(); }
 
 private:
     bool can_move_container() const;
     bool can_set_layout() const;
+    /// Keeps drawing the last frame of a closed window while its close animation plays.
+    void start_close_animation(miral::WindowInfo const& window_info, std::shared_ptr<Container> const& container);
 
     bool is_starting_ = true;
     CompositorState& state;
@@ -164,6 +173,8 @@ private:
     WindowManagerToolsWindowController window_controller;
     I3CommandExecutor i3_command_executor;
     SurfaceTracker& surface_tracker;
+    std::shared_ptr<FrameClock> frame_clock;
+    std::shared_ptr<WindowGhosts> window_ghosts;
     std::shared_ptr<ContainerGroupContainer> group_selection;
 };
 }
@@ -0,0 +1,223 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#define MIR_LOG_COMPONENT "program_binary_cache"
+
+#include "program_binary_cache.h"
+#include "gl_extensions.h"
+
+#include <EGL/egl.h>
+#include <cstdint>
+#include <fstream>
+#include <mir/log.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace miracle;
+
+namespace
+{
+constexpr uint32_t cache_magic = 0x4d575042; // "MWPB"
+constexpr uint32_t cache_version = 1;
+
+struct CacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;
+    uint32_t length;
+};
+
+/// FNV-1a is used rather than std::hash so that the names of the cache
+/// entries are stable between builds of the compositor.
+uint64_t hash(std::string const& value, uint64_t seed = 0xcbf29ce484222325ull)
+{
+    uint64_t result = seed;
+    for (auto const c : value)
+    {
+        result ^= static_cast<unsigned char>(c);
+        result *= 0x100000001b3ull;
+    }
+    return result;
+}
+
+std::string to_hex(uint64_t value)
+{
+    char buffer[17];
+    snprintf(buffer, sizeof(buffer), "%016lx", static_cast<unsigned long>(value));
+    return buffer;
+}
+
+void discard(std::filesystem::path const& path)
+{
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
+
+std::string get_gl_string(GLenum name)
+{
+    auto value = reinterpret_cast<char const*>(glGetString(name));
+    return value ? value : "";
+}
+}
+
+ProgramBinaryCache::ProgramBinaryCache(std::filesystem::path const& cache_directory)
+{
+    if (!has_gl_extension("GL_OES_get_program_binary"))
+    {
+        mir::log_info("GL_OES_get_program_binary is not supported, shader programs will not be cached");
+        return;
+    }
+
+    GLint num_formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &num_formats);
+    if (num_formats <= 0)
+    {
+        mir::log_info("The driver does not provide any program binary formats, shader programs will not be cached");
+        return;
+    }
+
+    get_program_binary = reinterpret_cast<PFNGLGETPROGRAMBINARYOESPROC>(eglGetProcAddress("glGetProgramBinaryOES"));
+    program_binary = reinterpret_cast<PFNGLPROGRAMBINARYOESPROC>(eglGetProcAddress("glProgramBinaryOES"));
+    if (!get_program_binary || !program_binary)
+    {
+        mir::log_warning("GL_OES_get_program_binary is advertised but its entry points could not be loaded");
+        return;
+    }
+
+    // Each driver gets its own directory so that an update never loads stale binaries
+    auto const driver = get_gl_string(GL_VENDOR) + "|" + get_gl_string(GL_RENDERER) + "|" + get_gl_string(GL_VERSION);
+    directory = cache_directory / to_hex(hash(driver));
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec)
+    {
+        mir::log_warning("Unable to create the shader cache directory %s: %s", directory.c_str(), ec.message().c_str());
+        return;
+    }
+
+    supported = true;
+}
+
+std::optional<std::filesystem::path> ProgramBinaryCache::default_directory()
+{
+    if (auto const cache_home = getenv("XDG_CACHE_HOME"); cache_home && *cache_home)
+        return std::filesystem::path(cache_home) / "miracle-wm" / "shaders";
+
+    if (auto const home = getenv("HOME"); home && *home)
+        return std::filesystem::path(home) / ".cache" / "miracle-wm" / "shaders";
+
+    return std::nullopt;
+}
+
+std::filesystem::path ProgramBinaryCache::get_path(std::string const& vertex_src, std::string const& fragment_src) const
+{
+    return directory / (to_hex(hash(fragment_src, hash(vertex_src))) + ".bin");
+}
+
+bool ProgramBinaryCache::load(GLuint program, std::string const& vertex_src, std::string const& fragment_src) const
+{
+    if (!supported)
+        return false;
+
+    auto const path = get_path(vertex_src, fragment_src);
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    CacheHeader header {};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || header.magic != cache_magic
+        || header.version != cache_version
+        || header.length == 0)
+    {
+        mir::log_warning("Discarding malformed shader cache entry: %s", path.c_str());
+        discard(path);
+        return false;
+    }
+
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), binary.size()))
+    {
+        mir::log_warning("Discarding truncated shader cache entry: %s", path.c_str());
+        discard(path);
+        return false;
+    }
+
+    program_binary(program, header.format, binary.data(), static_cast<GLint>(binary.size()));
+    GLint ok = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok)
+    {
+        // The driver is allowed to reject any binary, so this is not an error
+        mir::log_info("Driver rejected shader cache entry, recompiling: %s", path.c_str());
+        discard(path);
+        return false;
+    }
+
+    return true;
+}
+
+void ProgramBinaryCache::store(GLuint program, std::string const& vertex_src, std::string const& fragment_src) const
+{
+    if (!supported)
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    get_program_binary(program, length, &written, &format, binary.data());
+    if (written <= 0)
+        return;
+
+    CacheHeader const header {
+        .magic = cache_magic,
+        .version = cache_version,
+        .format = format,
+        .length = static_cast<uint32_t>(written)
+    };
+
+    // Write to a temporary file first so that other outputs never observe a partial entry
+    auto const path = get_path(vertex_src, fragment_src);
+    auto tmp_path = path;
+    tmp_path += "." + std::to_string(getpid()) + "." + to_hex(reinterpret_cast<uintptr_t>(this)) + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        file.write(binary.data(), written);
+        if (!file)
+        {
+            mir::log_warning("Unable to write shader cache entry: %s", tmp_path.c_str());
+            discard(tmp_path);
+            return;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec)
+    {
+        mir::log_warning("Unable to write shader cache entry %s: %s", path.c_str(), ec.message().c_str());
+        discard(tmp_path);
+    }
+}
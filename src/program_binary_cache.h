@@ -0,0 +1,67 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_PROGRAM_BINARY_CACHE_H
+#define MIRACLEWM_PROGRAM_BINARY_CACHE_H
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+namespace miracle
+{
+
+/// Stores linked GL programs on disk using GL_OES_get_program_binary so that shaders
+/// do not have to be compiled again the next time that the compositor starts.
+///
+/// Binaries are only valid for the driver that produced them, so the cache is keyed
+/// by the GL vendor, renderer, and version strings in addition to the shader sources.
+/// Any binary that the driver rejects is discarded and the program is compiled as usual.
+///
+/// Must be constructed and used with a GL context current.
+class ProgramBinaryCache
+{
+public:
+    explicit ProgramBinaryCache(std::filesystem::path const& directory);
+
+    /// Returns the default cache directory (i.e. $XDG_CACHE_HOME/miracle-wm/shaders),
+    /// or std::nullopt if there is no suitable place to store the cache.
+    static std::optional<std::filesystem::path> default_directory();
+
+    [[nodiscard]] bool is_supported() const { return supported; }
+
+    /// Attempts to load the binary of the program built from [vertex_src] and
+    /// [fragment_src] into [program]. Returns true if [program] is now linked.
+    bool load(GLuint program, std::string const& vertex_src, std::string const& fragment_src) const;
+
+    /// Writes the binary of the linked [program] into the cache.
+    void store(GLuint program, std::string const& vertex_src, std::string const& fragment_src) const;
+
+private:
+    [[nodiscard]] std::filesystem::path get_path(std::string const& vertex_src, std::string const& fragment_src) const;
+
+    bool supported = false;
+    std::filesystem::path directory;
+    PFNGLGETPROGRAMBINARYOESPROC get_program_binary = nullptr;
+    PFNGLPROGRAMBINARYOESPROC program_binary = nullptr;
+};
+
+}
+
+#endif // MIRACLEWM_PROGRAM_BINARY_CACHE_H
@@ -18,10 +18,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define MIR_LOG_COMPONENT "program_factory"
 
 #include "program_factory.h"
+#include <algorithm>
 #include <boost/throw_exception.hpp>
+#include <cstdint>
+#include <fstream>
 #include <mir/graphics/egl_error.h>
 #include <mir/log.h>
 #include <sstream>
+#include <unistd.h>
 
 namespace
 {
@@ -59,6 +63,35 @@ vec4 resolve_color(vec4 v) {
 }
 )";
 
+/// The texture family of the textures that the compositor renders itself
+const GLchar* const rgba_texture_fragment = R"(uniform sampler2D tex;
+vec4 sample_to_rgba(in vec2 texcoord)
+{
+    return texture2D(tex, texcoord);
+}
+)";
+
+std::string make_family_key(char const* extension_fragment, char const* fragment_fragment)
+{
+    return std::string(extension_fragment) + '\0' + fragment_fragment;
+}
+
+/// Each family is stored as its length on a line of its own, followed by its key. The key
+/// holds newlines and a null separator, so it cannot be stored line by line.
+std::vector<std::string> read_families(std::filesystem::path const& path)
+{
+    std::vector<std::string> families;
+    std::ifstream file(path, std::ios::binary);
+    size_t length = 0;
+    while (file >> length && file.get() == '\n')
+    {
+        std::string key(length, '\0');
+        if (!file.read(key.data(), static_cast<std::streamsize>(length)) || key.find('\0') == std::string::npos)
+            break;
+        families.push_back(std::move(key));
+    }
+    return families;
+}
 }
 
 miracle::ProgramData::ProgramData(GLuint program_id)
@@ -122,9 +155,29 @@ miracle::Program::Program(
 {
 }
 
-miracle::ProgramFactory::ProgramFactory() :
+miracle::ProgramFactory::ProgramFactory(std::optional<std::filesystem::path> const& binary_cache_directory) :
     vertex_shader { compile_shader(GL_VERTEX_SHADER, vertex_shader_src) }
 {
+    if (binary_cache_directory)
+    {
+        binary_cache = std::make_unique<ProgramBinaryCache>(binary_cache_directory.value());
+        if (!binary_cache->is_supported())
+            binary_cache.reset();
+
+        // Families do not depend on the driver, so they are recorded even without binaries
+        families_path = binary_cache_directory.value() / "families";
+    }
+}
+
+miracle::ProgramFactory::~ProgramFactory()
+{
+    // A recorded family that Mir never asked for is only a wasted compile at startup, but it
+    // may also mean that Mir changed its sources and the family will never be used again
+    for (auto const& [key, program] : precompiled_programs)
+    {
+        if (std::ranges::find(recorded_families, key) != recorded_families.end())
+            mir::log_info("Precompiled shader family was not used in this session: %s", key.c_str() + key.find('\0') + 1);
+    }
 }
 
 mir::graphics::gl::Program& miracle::ProgramFactory::compile_fragment_shader(
@@ -144,6 +197,102 @@ mir::graphics::gl::Program& miracle::ProgramFactory::compile_fragment_shader(
         }
     }
 
+    auto it = precompiled_programs.find(make_family_key(extension_fragment, fragment_fragment));
+    if (it != precompiled_programs.end())
+    {
+        programs.emplace_back(id, std::move(it->second));
+        precompiled_programs.erase(it);
+        return *programs.back().second;
+    }
+
+    programs.emplace_back(id, build_programs(extension_fragment, fragment_fragment));
+    record_family(make_family_key(extension_fragment, fragment_fragment));
+    return *programs.back().second;
+}
+
+void miracle::ProgramFactory::precompile(char const* extension_fragment, char const* fragment_fragment)
+{
+    auto key = make_family_key(extension_fragment, fragment_fragment);
+    if (precompiled_programs.contains(key))
+        return;
+
+    try
+    {
+        precompiled_programs.emplace(std::move(key), build_programs(extension_fragment, fragment_fragment));
+    }
+    catch (std::exception const& e)
+    {
+        mir::log_warning("Unable to precompile shader program: %s", e.what());
+    }
+}
+
+void miracle::ProgramFactory::precompile_recorded_families()
+{
+    precompile("", rgba_texture_fragment);
+    if (!families_path)
+        return;
+
+    recorded_families = read_families(families_path.value());
+    for (auto const& key : recorded_families)
+    {
+        auto const separator = key.find('\0');
+        precompile(key.substr(0, separator).c_str(), key.substr(separator + 1).c_str());
+    }
+}
+
+void miracle::ProgramFactory::record_family(std::string const& key)
+{
+    if (!families_path || key == make_family_key("", rgba_texture_fragment))
+        return;
+
+    // Another output may have recorded families since we last read them
+    recorded_families = read_families(families_path.value());
+    if (std::ranges::find(recorded_families, key) != recorded_families.end())
+        return;
+
+    recorded_families.push_back(key);
+    write_recorded_families();
+}
+
+void miracle::ProgramFactory::write_recorded_families() const
+{
+    // Write to a temporary file first so that other outputs never read a partial record
+    auto const& path = families_path.value();
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    auto tmp_path = path;
+    tmp_path += "." + std::to_string(getpid()) + "." + std::to_string(reinterpret_cast<uintptr_t>(this)) + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        for (auto const& key : recorded_families)
+            file << key.size() << '\n'
+                 << key;
+        if (!file)
+        {
+            mir::log_warning("Unable to record shader families in %s", tmp_path.c_str());
+            std::filesystem::remove(tmp_path, ec);
+            return;
+        }
+    }
+
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec)
+    {
+        mir::log_warning("Unable to record shader families in %s: %s", path.c_str(), ec.message().c_str());
+        std::filesystem::remove(tmp_path, ec);
+    }
+}
+
+miracle::Program& miracle::ProgramFactory::get_rgba_texture_program()
+{
+    return dynamic_cast<Program&>(compile_fragment_shader(rgba_texture_fragment, "", rgba_texture_fragment));
+}
+
+std::unique_ptr<miracle::Program> miracle::ProgramFactory::build_programs(
+    char const* extension_fragment,
+    char const* fragment_fragment)
+{
     std::stringstream opaque_fragment;
     opaque_fragment
         << extension_fragment
@@ -194,22 +343,31 @@ mir::graphics::gl::Program& miracle::ProgramFactory::compile_fragment_shader(
     // GL shader compilation is *not* threadsafe, and requires external synchronisation
     std::lock_guard lock { compilation_mutex };
 
-    ShaderHandle const opaque_shader {
-        compile_shader(GL_FRAGMENT_SHADER, opaque_fragment.str().c_str())
-    };
-    ShaderHandle const alpha_shader {
-        compile_shader(GL_FRAGMENT_SHADER, alpha_fragment.str().c_str())
-    };
-    ShaderHandle const outline_shader {
-        compile_shader(GL_FRAGMENT_SHADER, outline_shader_src.str().c_str())
-    };
+    return std::make_unique<miracle::Program>(
+        build_program(opaque_fragment.str()),
+        build_program(alpha_fragment.str()),
+        build_program(outline_shader_src.str()));
+}
 
-    programs.emplace_back(id, std::make_unique<miracle::Program>(link_shader(vertex_shader, opaque_shader), link_shader(vertex_shader, alpha_shader), link_shader(vertex_shader, outline_shader)));
+miracle::ProgramHandle miracle::ProgramFactory::build_program(std::string const& fragment_src)
+{
+    if (binary_cache)
+    {
+        ProgramHandle program { glCreateProgram() };
+        if (binary_cache->load(program, vertex_shader_src, fragment_src))
+            return program;
+    }
 
-    return *programs.back().second;
+    ShaderHandle const fragment_shader {
+        compile_shader(GL_FRAGMENT_SHADER, fragment_src.c_str())
+    };
+    auto program = link_shader(vertex_shader, fragment_shader);
+    if (binary_cache)
+        binary_cache->store(program, vertex_shader_src, fragment_src);
+    return program;
 
-    // We delete opaque_shader and alpha_shader here. This is fine; it only marks them
-    // for deletion. GL will only delete them once the GL Program they're linked in is destroyed.
+    // We delete fragment_shader here. This is fine; it only marks it for deletion.
+    // GL will only delete it once the GL Program it's linked in is destroyed.
 }
 
 GLuint miracle::ProgramFactory::compile_shader(GLenum type, GLchar const* src)
@@ -18,11 +18,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIRACLE_WM_PROGRAM_FACTORY_H
 #define MIRACLE_WM_PROGRAM_FACTORY_H
 
+#include "program_binary_cache.h"
+
 #include <GLES2/gl2.h>
 #include <array>
+#include <filesystem>
 #include <mir/graphics/program.h>
 #include <mir/graphics/program_factory.h>
 #include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace miracle
@@ -83,7 +89,7 @@ struct ProgramData
     GLint alpha_uniform = -1;
     GLint mode_uniform = -1;
     GLint outline_color_uniform = -1;
-    mutable long long last_used_frameno = 0;
+    mutable long long last_used_pass = 0;
 
     ProgramData(GLuint program_id);
 };
@@ -99,20 +105,47 @@ public:
 class ProgramFactory : public mir::graphics::gl::ProgramFactory
 {
 public:
-    ProgramFactory();
+    /// If [binary_cache_directory] is provided, linked programs are cached on disk
+    /// in that directory when the driver supports it.
+    explicit ProgramFactory(std::optional<std::filesystem::path> const& binary_cache_directory = std::nullopt);
+    ~ProgramFactory() override;
     mir::graphics::gl::Program& compile_fragment_shader(
         void const* id,
         char const* extension_fragment,
         char const* fragment_fragment) override;
 
+    /// Compiles the programs of a texture family ahead of time so that the first frame
+    /// that draws a texture of this family does not have to wait for compilation.
+    void precompile(char const* extension_fragment, char const* fragment_fragment);
+
+    /// Precompiles the texture family of the compositor and every family that Mir asked
+    /// for in previous sessions. Families are recorded from the sources that Mir passes to
+    /// [compile_fragment_shader], so they follow whichever version of Mir is running.
+    void precompile_recorded_families();
+
+    /// Returns the programs that sample a plain GL_TEXTURE_2D, for textures that
+    /// the compositor renders itself.
+    Program& get_rgba_texture_program();
+
 private:
     static GLuint compile_shader(GLenum type, GLchar const* src);
     static ProgramHandle link_shader(
         ShaderHandle const& vertex_shader,
         ShaderHandle const& fragment_shader);
+    ProgramHandle build_program(std::string const& fragment_src);
+    std::unique_ptr<Program> build_programs(char const* extension_fragment, char const* fragment_fragment);
+    void record_family(std::string const& key);
+    void write_recorded_families() const;
 
     ShaderHandle const vertex_shader;
+    std::unique_ptr<ProgramBinaryCache> binary_cache;
     std::vector<std::pair<void const*, std::unique_ptr<Program>>> programs;
+    /// Programs that were compiled ahead of time, keyed by their fragment sources. These
+    /// are moved into [programs] once Mir asks for them by id.
+    std::unordered_map<std::string, std::unique_ptr<Program>> precompiled_programs;
+    /// Where the families that Mir asks for are recorded between sessions, if anywhere.
+    std::optional<std::filesystem::path> families_path;
+    std::vector<std::string> recorded_families;
     // GL requires us to synchronise multi-threaded access to the shader APIs.
     std::mutex compilation_mutex;
 };
@@ -0,0 +1,257 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "render_statistics.h"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace miracle;
+
+namespace
+{
+/// Histogram bounds for timings, in milliseconds. The 16.7ms and 33.3ms buckets line
+/// up with a 60Hz display so that missed deadlines are easy to spot.
+std::vector<float> const timing_bucket_bounds = { 1.f, 2.f, 4.f, 8.f, 16.7f, 33.3f, 50.f, 100.f };
+
+float to_milliseconds(std::chrono::nanoseconds ns)
+{
+    return std::chrono::duration<float, std::milli>(ns).count();
+}
+}
+
+RollingSamples::RollingSamples(size_t capacity) :
+    capacity { capacity }
+{
+    samples.reserve(capacity);
+}
+
+void RollingSamples::push(float value)
+{
+    if (samples.size() < capacity)
+        samples.push_back(value);
+    else
+        samples[next] = value;
+    next = (next + 1) % capacity;
+}
+
+size_t RollingSamples::size() const
+{
+    return samples.size();
+}
+
+float RollingSamples::min() const
+{
+    if (samples.empty())
+        return 0.f;
+    return *std::min_element(samples.begin(), samples.end());
+}
+
+float RollingSamples::max() const
+{
+    if (samples.empty())
+        return 0.f;
+    return *std::max_element(samples.begin(), samples.end());
+}
+
+float RollingSamples::mean() const
+{
+    if (samples.empty())
+        return 0.f;
+    return std::accumulate(samples.begin(), samples.end(), 0.f) / static_cast<float>(samples.size());
+}
+
+float RollingSamples::percentile(float p) const
+{
+    if (samples.empty())
+        return 0.f;
+
+    auto sorted = samples;
+    auto const index = static_cast<size_t>(std::clamp(p, 0.f, 1.f) * static_cast<float>(sorted.size() - 1));
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+nlohmann::json RollingSamples::to_json(std::vector<float> const& bucket_bounds) const
+{
+    nlohmann::json result = {
+        { "samples", samples.size()    },
+        { "min",     min()             },
+        { "mean",    mean()            },
+        { "p50",     percentile(0.5f)  },
+        { "p95",     percentile(0.95f) },
+        { "p99",     percentile(0.99f) },
+        { "max",     max()             }
+    };
+
+    if (!bucket_bounds.empty())
+    {
+        std::vector<size_t> counts(bucket_bounds.size() + 1, 0);
+        for (auto const sample : samples)
+        {
+            auto it = std::lower_bound(bucket_bounds.begin(), bucket_bounds.end(), sample);
+            counts[it - bucket_bounds.begin()]++;
+        }
+
+        nlohmann::json histogram = nlohmann::json::array();
+        for (size_t i = 0; i < bucket_bounds.size(); i++)
+            histogram.push_back({ { "le", bucket_bounds[i] }, { "count", counts[i] } });
+        histogram.push_back({ { "le", nullptr }, { "count", counts.back() } });
+        result["histogram"] = histogram;
+    }
+
+    return result;
+}
+
+OutputRenderStatistics::OutputRenderStatistics() :
+    cpu_time_ms { window_size },
+    gpu_time_ms { window_size },
+    commit_time_ms { window_size },
+    frame_interval_ms { window_size },
+    renderables { window_size },
+    draw_calls { window_size }
+{
+}
+
+void OutputRenderStatistics::set_viewport(mir::geometry::Rectangle const& rect)
+{
+    std::lock_guard lock(mutex);
+    viewport = rect;
+}
+
+void OutputRenderStatistics::set_gpu_timer_supported(bool supported)
+{
+    std::lock_guard lock(mutex);
+    gpu_timer_supported = supported;
+}
+
+void OutputRenderStatistics::record_frame(FrameTimings const& timings)
+{
+    std::lock_guard lock(mutex);
+    total_frames++;
+    cpu_time_ms.push(to_milliseconds(timings.cpu_time));
+    commit_time_ms.push(to_milliseconds(timings.commit_time));
+    renderables.push(static_cast<float>(timings.num_renderables));
+    draw_calls.push(static_cast<float>(timings.num_draw_calls));
+    if (timings.refresh_period)
+        reported_refresh_period_ms = to_milliseconds(timings.refresh_period.value());
+
+    if (last_frame_start)
+    {
+        // Without a refresh rate from the display configuration, we rely on the compositor never
+        // rendering faster than the display consumes frames. Thus, the shortest interval
+        // that we have seen recently is a good estimate of the refresh period.
+        auto const interval = timings.frame_start - last_frame_start.value();
+        if (interval < idle_threshold)
+            frame_interval_ms.push(to_milliseconds(interval));
+    }
+
+    // The interval between frames says nothing on its own, since we only draw when something is
+    // damaged. A frame is only late when it was committed after the vblank it was drawn for.
+    auto const committed_at = timings.frame_start + timings.cpu_time + timings.commit_time;
+    if (timings.deadline && committed_at > timings.deadline.value())
+    {
+        missed_frames++;
+        if (timings.refresh_period && timings.refresh_period.value() > std::chrono::nanoseconds::zero())
+            missed_frames += static_cast<uint64_t>((committed_at - timings.deadline.value()) / timings.refresh_period.value());
+    }
+
+    last_frame_start = timings.frame_start;
+}
+
+void OutputRenderStatistics::record_gpu_time(std::chrono::nanoseconds gpu_time)
+{
+    std::lock_guard lock(mutex);
+    gpu_time_ms.push(to_milliseconds(gpu_time));
+}
+
+mir::geometry::Rectangle OutputRenderStatistics::get_viewport() const
+{
+    std::lock_guard lock(mutex);
+    return viewport;
+}
+
+uint64_t OutputRenderStatistics::get_missed_frames() const
+{
+    std::lock_guard lock(mutex);
+    return missed_frames;
+}
+
+std::optional<float> OutputRenderStatistics::get_refresh_period_ms() const
+{
+    std::lock_guard lock(mutex);
+    if (reported_refresh_period_ms)
+        return reported_refresh_period_ms;
+    if (frame_interval_ms.empty())
+        return std::nullopt;
+    return frame_interval_ms.min();
+}
+
+nlohmann::json OutputRenderStatistics::to_json() const
+{
+    std::lock_guard lock(mutex);
+    nlohmann::json result = {
+        { "rect",                {
+                      { "x", viewport.top_left.x.as_int() },
+                      { "y", viewport.top_left.y.as_int() },
+                      { "width", viewport.size.width.as_int() },
+                      { "height", viewport.size.height.as_int() },
+                  }                                                        },
+        { "frames",              total_frames                              },
+        { "missed_frames",       missed_frames                             },
+        { "gpu_timer_supported", gpu_timer_supported                       },
+        { "cpu_time_ms",         cpu_time_ms.to_json(timing_bucket_bounds)       },
+        { "commit_time_ms",      commit_time_ms.to_json(timing_bucket_bounds)    },
+        { "frame_interval_ms",   frame_interval_ms.to_json(timing_bucket_bounds) },
+        { "renderables",         renderables.to_json()                     },
+        { "draw_calls",          draw_calls.to_json()                      }
+    };
+
+    if (gpu_timer_supported)
+        result["gpu_time_ms"] = gpu_time_ms.to_json(timing_bucket_bounds);
+
+    if (reported_refresh_period_ms && reported_refresh_period_ms.value() > 0.f)
+        result["refresh_rate"] = 1000.f / reported_refresh_period_ms.value();
+    else if (!frame_interval_ms.empty() && frame_interval_ms.min() > 0.f)
+        result["estimated_refresh_rate"] = 1000.f / frame_interval_ms.min();
+
+    return result;
+}
+
+std::shared_ptr<OutputRenderStatistics> RenderStatistics::register_output()
+{
+    auto output = std::make_shared<OutputRenderStatistics>();
+    std::lock_guard lock(mutex);
+    outputs.push_back(output);
+    return output;
+}
+
+std::vector<std::shared_ptr<OutputRenderStatistics>> RenderStatistics::get_outputs() const
+{
+    std::lock_guard lock(mutex);
+    std::erase_if(outputs, [](auto const& output)
+    { return output.expired(); });
+
+    std::vector<std::shared_ptr<OutputRenderStatistics>> result;
+    result.reserve(outputs.size());
+    for (auto const& output : outputs)
+    {
+        if (auto locked = output.lock())
+            result.push_back(locked);
+    }
+    return result;
+}
@@ -0,0 +1,128 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_RENDER_STATISTICS_H
+#define MIRACLEWM_RENDER_STATISTICS_H
+
+#include <chrono>
+#include <memory>
+#include <mir/geometry/rectangle.h>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <vector>
+
+namespace miracle
+{
+
+/// A fixed-size window of the most recent samples of a single metric.
+class RollingSamples
+{
+public:
+    explicit RollingSamples(size_t capacity);
+    void push(float value);
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] bool empty() const { return size() == 0; }
+    [[nodiscard]] float min() const;
+    [[nodiscard]] float max() const;
+    [[nodiscard]] float mean() const;
+    [[nodiscard]] float percentile(float p) const;
+
+    /// Reports the summary of the window. If [bucket_bounds] are provided, then a histogram
+    /// with one bucket per bound (plus an overflow bucket) is included as well.
+    [[nodiscard]] nlohmann::json to_json(std::vector<float> const& bucket_bounds = {}) const;
+
+private:
+    std::vector<float> samples;
+    size_t capacity;
+    size_t next = 0;
+};
+
+/// The timings of a single frame as measured by the renderer.
+struct FrameTimings
+{
+    std::chrono::steady_clock::time_point frame_start;
+    std::chrono::nanoseconds cpu_time { 0 };
+    std::chrono::nanoseconds commit_time { 0 };
+    size_t num_renderables = 0;
+    size_t num_draw_calls = 0;
+    /// The refresh period of the output from the display configuration, if it is known
+    std::optional<std::chrono::nanoseconds> refresh_period;
+    /// The vblank that the frame had to be committed by to be shown on time. This is only
+    /// set when the frame was drawn for pending damage and the vblank timing is known.
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+};
+
+/// Collects the render timings of a single output. The renderer thread of the output
+/// writes into this while IPC clients read from it, so all access is synchronized.
+class OutputRenderStatistics
+{
+public:
+    /// The number of frames that are kept in each rolling window.
+    static constexpr size_t window_size = 600;
+
+    /// Frames that are further apart than this are assumed to be caused by the
+    /// compositor idling, and are left out of the frame intervals.
+    static constexpr std::chrono::milliseconds idle_threshold { 250 };
+
+    OutputRenderStatistics();
+    void set_viewport(mir::geometry::Rectangle const&);
+    void set_gpu_timer_supported(bool);
+    void record_frame(FrameTimings const&);
+    void record_gpu_time(std::chrono::nanoseconds);
+    [[nodiscard]] mir::geometry::Rectangle get_viewport() const;
+    [[nodiscard]] uint64_t get_missed_frames() const;
+    /// The refresh period reported by the display configuration or, failing
+    /// that, one estimated from the intervals between frames.
+    [[nodiscard]] std::optional<float> get_refresh_period_ms() const;
+    [[nodiscard]] nlohmann::json to_json() const;
+
+private:
+    mutable std::mutex mutex;
+    mir::geometry::Rectangle viewport;
+    bool gpu_timer_supported = false;
+    uint64_t total_frames = 0;
+    uint64_t missed_frames = 0;
+    std::optional<std::chrono::steady_clock::time_point> last_frame_start;
+    std::optional<float> reported_refresh_period_ms;
+    RollingSamples cpu_time_ms;
+    RollingSamples gpu_time_ms;
+    RollingSamples commit_time_ms;
+    RollingSamples frame_interval_ms;
+    RollingSamples renderables;
+    RollingSamples draw_calls;
+};
+
+/// Holds the render statistics of every output so that they can be queried over IPC.
+class RenderStatistics
+{
+public:
+    /// Called by each renderer when it is created. The statistics live for as long
+    /// as the renderer holds on to them.
+    std::shared_ptr<OutputRenderStatistics> register_output();
+
+    /// Returns the statistics of every output that is still being rendered to.
+    [[nodiscard]] std::vector<std::shared_ptr<OutputRenderStatistics>> get_outputs() const;
+
+private:
+    mutable std::mutex mutex;
+    mutable std::vector<std::weak_ptr<OutputRenderStatistics>> outputs;
+};
+
+}
+
+#endif // MIRACLEWM_RENDER_STATISTICS_H
@@ -21,16 +21,23 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "renderer.h"
 #include "compositor_state.h"
 #include "config.h"
+#include "frame_clock.h"
 #include "program_factory.h"
+#include "render_statistics.h"
 #include "tessellation_helpers.h"
+#include "window_ghost.h"
 
 #include "container.h"
+#include "output.h"
 #include "window_tools_accessor.h"
 #include "workspace.h"
 
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstddef>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <mir/graphics/buffer.h>
@@ -145,17 +152,23 @@ Renderer::Renderer(
     std::shared_ptr<Config> const& config,
     SurfaceTracker& surface_tracker,
     CompositorState const& compositor_state,
-    std::shared_ptr<WindowToolsAccessor> const& accessor) :
+    std::shared_ptr<WindowToolsAccessor> const& accessor,
+    std::shared_ptr<RenderStatistics> const& render_statistics,
+    std::shared_ptr<FrameClock> const& frame_clock,
+    std::shared_ptr<WindowGhosts> const& window_ghosts) :
     output_surface { make_output_current(std::move(output)) },
     clear_color { 0.0f, 0.0f, 0.0f, 1.0f },
-    program_factory { std::make_unique<ProgramFactory>() },
+    program_factory { std::make_unique<ProgramFactory>(ProgramBinaryCache::default_directory()) },
     display_transform(1),
     screen_to_gl_coords(1),
     gl_interface { std::move(gl_interface) },
     config { config },
     surface_tracker { surface_tracker },
     compositor_state { compositor_state },
-    accessor { accessor }
+    accessor { accessor },
+    statistics { render_statistics->register_output() },
+    frame_clock { frame_clock },
+    window_ghosts { window_ghosts }
 {
     // http://directx.com/2014/06/egl-understanding-eglchooseconfig-then-ignoring-it/
     eglBindAPI(EGL_OPENGL_ES_API);
@@ -212,7 +225,24 @@ Renderer::Renderer(
         rbits, gbits, bbits, abits, dbits, sbits);
 
     has_stencil_support = dbits > 0;
+
+    // All of the vertices of a frame are streamed into this buffer once per frame
+    glGenBuffers(1, &vertex_buffer);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Compile the programs that we know we will need now, rather than on the first frame that uses them
+    program_factory->precompile_recorded_families();
+
+    gpu_timer = std::make_unique<GpuFrameTimer>();
+    statistics->set_gpu_timer_supported(gpu_timer->is_supported());
+}
+
+Renderer::~Renderer()
+{
+    frame_clock->remove_source(this);
+    output_surface->make_current();
+    glDeleteBuffers(1, &vertex_buffer);
+    gpu_timer.reset();
 }
 
 void Renderer::tessellate(
@@ -239,43 +269,161 @@ Renderer::DrawData Renderer::get_draw_data(mir::graphics::Renderable const& rend
                 && window.top_left() == renderable.screen_position().top_left; // HACK: This is a major hack! We only want the outline on the main layer, so we make sure that only renderables with the right top_left get an outline.
             data.workspace_transform = userdata->get_output_transform() * userdata->get_workspace_transform();
             data.is_focused = userdata->is_focused();
+            data.is_fullscreen = userdata->is_fullscreen();
+
+            auto output = userdata->get_output();
+            if (output && output->is_switching_workspaces())
+            {
+                data.switching_workspace = userdata->get_workspace();
+                data.workspace_switch_id = output->get_workspace_switch_id();
+            }
         }
     }
+    else if (auto const ghost = dynamic_cast<WindowGhost const*>(&renderable))
+    {
+        data.workspace_transform = ghost->get_workspace_transform();
+    }
 
     return data;
 }
 
-auto Renderer::render(mg::RenderableList const& renderables) const -> std::unique_ptr<mg::Framebuffer>
+auto Renderer::render(mg::RenderableList const& scene_renderables) const -> std::unique_ptr<mg::Framebuffer>
 {
+    auto const frame_start = std::chrono::steady_clock::now();
+
+    // Advance animations before we look at the scene, so that they are in step with the display
+    auto const frame = frame_clock->advise_frame(this, viewport, frame_start);
+
+    // Closed windows that are still animating are drawn where they were in the previous frame
+    auto const& renderables = [&]() -> mg::RenderableList const&
+    {
+        if (window_ghosts->empty())
+        {
+            // Do not hold on to the buffers of a previous frame
+            frame_renderables.clear();
+            return scene_renderables;
+        }
+
+        frame_renderables = scene_renderables;
+        window_ghosts->insert_into(frame_renderables, viewport, previous_surfaces);
+        return frame_renderables;
+    }();
+
+    previous_surfaces.clear();
+    for (auto const& renderable : scene_renderables)
+    {
+        if (auto const surface = renderable->surface_if_any())
+            previous_surfaces.push_back(surface.value());
+    }
+
     output_surface->make_current();
+    gpu_timer->begin_frame();
+    num_draw_calls = 0;
+
+    ++frameno;
+
+    frame_draw_data.clear();
+    for (auto const& r : renderables)
+        frame_draw_data.push_back(get_draw_data(*r));
+
+    // Snapshots are drawn into their own framebuffers, so this must happen before we start on the output
+    bool const captured_snapshots = prepare_workspace_snapshots(renderables);
+
     output_surface->bind();
+    if (captured_snapshots)
+        update_gl_viewport();
+
+    // Mir scans out a fullscreen client buffer directly whenever the platform allows it, in which
+    // case we are never asked to render. Otherwise, an opaque fullscreen window hides everything
+    // beneath it, so we start drawing from that window. When it is the only thing left to draw,
+    // the frame is a single blit: the window covers every pixel, so there is nothing to clear,
+    // and it is drawn without an outline or blending.
+    size_t first_visible = 0;
+    bool is_single_blit = false;
+    if (auto const occluder = find_fullscreen_occluder(renderables))
+    {
+        first_visible = occluder.value();
+        is_single_blit = first_visible == renderables.size() - 1 && viewport_fills_output;
+        frame_draw_data[first_visible].needs_outline = false;
+    }
 
-    glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
-    glClearStencil(0);
-    glStencilMask(0xFF);
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    if (!is_single_blit)
+    {
+        glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
+        glClearStencil(0);
+        glStencilMask(0xFF);
+        glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    }
 
-    ++frameno;
-    for (auto const& r : renderables)
+    ++render_pass;
+
+    // First, tessellate everything that we are going to draw this frame so that
+    // the vertices can be uploaded to the GPU in one go.
+    frame_vertices.clear();
+    frame_primitives.clear();
+    pending_draws.clear();
+    outline_renderables.clear();
+    for (size_t i = first_visible; i < renderables.size(); i++)
     {
-        auto data = draw(*r, get_draw_data(*r));
-        if (data.enabled && data.outline_context.enabled)
+        auto const& data = frame_draw_data[i];
+        if (auto entry = get_workspace_snapshot(data))
         {
-            if (has_stencil_support)
-            {
-                OutlineRenderable outline(*r, data.outline_context.size, data.outline_context.color.a);
-                draw(outline, data);
-                glClear(GL_STENCIL_BUFFER_BIT);
-            }
-            else
+            // The snapshot takes the place of the first renderable of its workspace
+            if (entry->last_queued_frameno != frameno)
             {
-                mir::log_warning("Renderer::render: outlines are not supported for the provided surface");
+                entry->last_queued_frameno = frameno;
+                queue_snapshot(*entry->snapshot, data);
             }
+            continue;
         }
+
+        queue_renderable(*renderables[i], data);
     }
 
+    // Drop the tessellations of renderables that have gone away
+    std::erase_if(tessellation_cache, [&](auto const& entry)
+    {
+        return entry.second.last_used_frameno != frameno;
+    });
+
+    upload_vertices();
+
+    for (auto const& pending : pending_draws)
+    {
+        if (pending.snapshot)
+        {
+            draw_snapshot(pending);
+            continue;
+        }
+
+        draw(pending, display_transform);
+        if (pending.data.outline_context.enabled)
+            glClear(GL_STENCIL_BUFFER_BIT);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    gpu_timer->end_frame();
+
+    auto const commit_start = std::chrono::steady_clock::now();
     auto output = output_surface->commit();
+    auto const commit_end = std::chrono::steady_clock::now();
+
+    statistics->record_frame({
+        .frame_start = frame_start,
+        .cpu_time = commit_start - frame_start,
+        .commit_time = commit_end - commit_start,
+        .num_renderables = renderables.size(),
+        .num_draw_calls = num_draw_calls,
+        .refresh_period = frame.refresh_period,
+        // Mir only composites when there is damage to show, so every frame is
+        // due by the vblank after the one that it was drawn from
+        .deadline = frame.refresh_period
+            ? std::optional(frame.time + frame.refresh_period.value())
+            : std::nullopt
+    });
+    while (auto const gpu_time = gpu_timer->poll())
+        statistics->record_gpu_time(gpu_time.value());
 
     // Report any GL errors after commit, to catch any *during* commit
     while (auto const gl_error = glGetError())
@@ -284,10 +432,309 @@ auto Renderer::render(mg::RenderableList const& renderables) const -> std::uniqu
     return output;
 }
 
-miracle::Renderer::DrawData Renderer::draw(
+void Renderer::queue_renderable(mg::Renderable const& renderable, DrawData const& data) const
+{
+    queue_draw(renderable, data, true);
+
+    auto outline_data = get_outline_draw_data(data);
+    if (outline_data.enabled && outline_data.outline_context.enabled)
+    {
+        if (has_stencil_support)
+        {
+            outline_renderables.push_back(std::make_unique<OutlineRenderable>(
+                renderable, outline_data.outline_context.size, outline_data.outline_context.color.a));
+            queue_draw(*outline_renderables.back(), outline_data, false);
+        }
+        else
+        {
+            mir::log_warning("Renderer::render: outlines are not supported for the provided surface");
+        }
+    }
+}
+
+bool Renderer::prepare_workspace_snapshots(mg::RenderableList const& renderables) const
+{
+    // Group the renderables of every workspace that is being switched
+    for (size_t i = 0; i < renderables.size(); i++)
+    {
+        auto const& data = frame_draw_data[i];
+        if (!data.switching_workspace)
+            continue;
+
+        auto& entry = workspace_snapshots[data.switching_workspace];
+        if (entry.last_seen_frameno != frameno)
+        {
+            entry.last_seen_frameno = frameno;
+            entry.members.clear();
+            entry.pending_signature = data.workspace_switch_id;
+        }
+
+        entry.members.push_back(i);
+        auto const id_hash = std::hash<mg::Renderable::ID> {}(renderables[i]->id());
+        entry.pending_signature ^= id_hash + 0x9e3779b9 + (entry.pending_signature << 6) + (entry.pending_signature >> 2);
+    }
+
+    // Once a switch is over, the snapshots are no longer needed
+    std::erase_if(workspace_snapshots, [&](auto const& entry)
+    {
+        return entry.second.last_seen_frameno != frameno;
+    });
+
+    bool captured = false;
+    for (auto& [workspace, entry] : workspace_snapshots)
+    {
+        auto const switch_id = frame_draw_data[entry.members.front()].workspace_switch_id;
+        if (entry.switch_id == switch_id && entry.signature == entry.pending_signature)
+            continue;
+
+        // A window has appeared or gone away, or a new switch has begun, so we capture again
+        entry.switch_id = switch_id;
+        entry.signature = entry.pending_signature;
+        try
+        {
+            capture_workspace(entry, renderables);
+        }
+        catch (std::exception const& e)
+        {
+            mir::log_warning("Unable to capture workspace snapshot, falling back to live rendering: %s", e.what());
+            entry.snapshot.reset();
+        }
+        captured = true;
+    }
+
+    return captured;
+}
+
+void Renderer::capture_workspace(SnapshotEntry& entry, mg::RenderableList const& renderables) const
+{
+    // The snapshot is drawn with the display transform when it is composited, so it only takes
+    // on the scale of the output here. Otherwise, it would be blurry on scaled outputs.
+    if (!entry.snapshot || entry.snapshot->size() != viewport_pixel_size)
+        entry.snapshot = std::make_unique<WorkspaceSnapshot>(viewport_pixel_size, has_stencil_support);
+
+    float const scale_x = (float)viewport_pixel_size.width.as_int() / (float)viewport.size.width.as_int();
+    float const scale_y = (float)viewport_pixel_size.height.as_int() / (float)viewport.size.height.as_int();
+
+    entry.snapshot->bind();
+    glClearColor(0.f, 0.f, 0.f, 0.f);
+    glClearStencil(0);
+    glStencilMask(0xFF);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+    ++render_pass;
+
+    frame_vertices.clear();
+    frame_primitives.clear();
+    pending_draws.clear();
+    outline_renderables.clear();
+    for (auto const i : entry.members)
+    {
+        // The workspace is captured at rest. The animation is applied to the snapshot instead.
+        auto data = frame_draw_data[i];
+        data.workspace_transform = glm::mat4(1.f);
+        queue_renderable(*renderables[i], data);
+    }
+
+    upload_vertices();
+
+    auto const identity = glm::mat4(1.f);
+    for (auto const& pending : pending_draws)
+    {
+        auto const& renderable = *pending.renderable;
+
+        // Opaque clients may leave garbage in their alpha channel, which would let whatever is
+        // below the snapshot bleed through. Thus, we make their area opaque before drawing them
+        // and leave the alpha channel untouched while we draw.
+        bool const is_opaque = !pending.data.outline_context.enabled && !renderable.shaped() && renderable.alpha() == 1.0f;
+        if (is_opaque)
+        {
+            auto area = renderable.screen_position();
+            if (auto const clip_area = renderable.clip_area())
+                area = geom::intersection_of(area, clip_area.value());
+
+            // GL counts rows from the bottom of the snapshot
+            auto const left = std::lround((float)(area.top_left.x.as_int() - viewport.top_left.x.as_int()) * scale_x);
+            auto const right = std::lround((float)(area.top_left.x.as_int() + area.size.width.as_int() - viewport.top_left.x.as_int()) * scale_x);
+            auto const top = std::lround((float)(area.top_left.y.as_int() - viewport.top_left.y.as_int()) * scale_y);
+            auto const bottom = std::lround((float)(area.top_left.y.as_int() + area.size.height.as_int() - viewport.top_left.y.as_int()) * scale_y);
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(
+                (GLint)left,
+                (GLint)(viewport_pixel_size.height.as_int() - bottom),
+                (GLsizei)(right - left),
+                (GLsizei)(bottom - top));
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_TRUE);
+            glClearColor(0.f, 0.f, 0.f, 1.f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            glDisable(GL_SCISSOR_TEST);
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_FALSE);
+        }
+
+        draw(pending, identity);
+
+        if (is_opaque)
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        if (pending.data.outline_context.enabled)
+            glClear(GL_STENCIL_BUFFER_BIT);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+std::optional<size_t> Renderer::find_fullscreen_occluder(mg::RenderableList const& renderables) const
+{
+    for (size_t i = renderables.size(); i-- > 0;)
+    {
+        auto const& renderable = *renderables[i];
+        auto const& data = frame_draw_data[i];
+        if (!data.is_fullscreen || data.switching_workspace)
+            continue;
+
+        if (renderable.shaped() || renderable.alpha() < 1.0f || renderable.transformation() != glm::mat4(1.f))
+            continue;
+
+        auto const area = renderable.screen_position();
+        auto const top_left = data.workspace_transform * glm::vec4(area.top_left.x.as_int(), area.top_left.y.as_int(), 0, 1);
+        auto const bottom_right = data.workspace_transform * glm::vec4(
+            area.top_left.x.as_int() + area.size.width.as_int(),
+            area.top_left.y.as_int() + area.size.height.as_int(),
+            0, 1);
+        bool const covers_viewport = top_left.x <= viewport.top_left.x.as_int()
+            && top_left.y <= viewport.top_left.y.as_int()
+            && bottom_right.x >= viewport.top_left.x.as_int() + viewport.size.width.as_int()
+            && bottom_right.y >= viewport.top_left.y.as_int() + viewport.size.height.as_int();
+        if (!covers_viewport)
+            continue;
+
+        if (auto const clip_area = renderable.clip_area())
+        {
+            if (!clip_area.value().contains(viewport))
+                continue;
+        }
+
+        return i;
+    }
+
+    return std::nullopt;
+}
+
+Renderer::SnapshotEntry* Renderer::get_workspace_snapshot(DrawData const& data) const
+{
+    if (!data.switching_workspace)
+        return nullptr;
+
+    auto it = workspace_snapshots.find(data.switching_workspace);
+    if (it == workspace_snapshots.end() || !it->second.snapshot)
+        return nullptr;
+
+    return &it->second;
+}
+
+void Renderer::queue_snapshot(WorkspaceSnapshot const& snapshot, DrawData const& data) const
+{
+    auto const left = static_cast<GLfloat>(viewport.top_left.x.as_int());
+    auto const top = static_cast<GLfloat>(viewport.top_left.y.as_int());
+    auto const right = left + static_cast<GLfloat>(viewport.size.width.as_int());
+    auto const bottom = top + static_cast<GLfloat>(viewport.size.height.as_int());
+
+    // The snapshot was rendered by GL, so its first row is the bottom of the workspace
+    PendingDraw pending { nullptr, data, frame_primitives.size(), 1, &snapshot };
+    frame_primitives.push_back({ GL_TRIANGLE_STRIP, static_cast<GLint>(frame_vertices.size()), 4 });
+    frame_vertices.push_back({ { left, top, 0.f }, { 0.f, 1.f } });
+    frame_vertices.push_back({ { right, top, 0.f }, { 1.f, 1.f } });
+    frame_vertices.push_back({ { left, bottom, 0.f }, { 0.f, 0.f } });
+    frame_vertices.push_back({ { right, bottom, 0.f }, { 1.f, 0.f } });
+    pending_draws.push_back(pending);
+}
+
+miracle::Renderer::DrawData Renderer::get_outline_draw_data(DrawData const& data) const
+{
+    if (!data.needs_outline)
+        return { false };
+
+    auto border_config = config->get_border_config();
+    if (border_config.size <= 0)
+        return { false };
+
+    auto color = data.is_focused ? border_config.focus_color : border_config.color;
+    return DrawData {
+        .enabled = true,
+        .needs_outline = false,
+        .workspace_transform = data.workspace_transform,
+        .is_focused = data.is_focused,
+        .outline_context = { .enabled = true, .color = color, .size = border_config.size }
+    };
+}
+
+void Renderer::queue_draw(
     mg::Renderable const& renderable,
-    DrawData const& data) const
+    DrawData const& data,
+    bool cacheable) const
 {
+    std::vector<mgl::Primitive> const* to_buffer = &primitives;
+    if (cacheable)
+    {
+        auto const screen_position = renderable.screen_position();
+        auto const src_bounds = renderable.src_bounds();
+        auto const buffer_size = renderable.buffer()->size();
+        auto& entry = tessellation_cache[renderable.id()];
+        if (entry.primitives.empty()
+            || entry.screen_position != screen_position
+            || entry.src_bounds != src_bounds
+            || entry.buffer_size != buffer_size)
+        {
+            entry.screen_position = screen_position;
+            entry.src_bounds = src_bounds;
+            entry.buffer_size = buffer_size;
+            entry.primitives.clear();
+            tessellate(entry.primitives, renderable);
+        }
+
+        entry.last_used_frameno = frameno;
+        to_buffer = &entry.primitives;
+    }
+    else
+    {
+        primitives.clear();
+        tessellate(primitives, renderable);
+    }
+
+    PendingDraw pending { &renderable, data, frame_primitives.size(), to_buffer->size() };
+    for (auto const& p : *to_buffer)
+    {
+        frame_primitives.push_back({ p.type,
+            static_cast<GLint>(frame_vertices.size()),
+            static_cast<GLsizei>(p.nvertices) });
+        frame_vertices.insert(frame_vertices.end(), p.vertices, p.vertices + p.nvertices);
+    }
+
+    pending_draws.push_back(pending);
+}
+
+void Renderer::upload_vertices() const
+{
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+
+    auto const size = static_cast<GLsizeiptr>(frame_vertices.size() * sizeof(mgl::Vertex));
+    if (size > vertex_buffer_capacity)
+    {
+        // Grow geometrically so that we rarely need to reallocate
+        while (vertex_buffer_capacity < size)
+            vertex_buffer_capacity = vertex_buffer_capacity ? vertex_buffer_capacity * 2 : 64 * sizeof(mgl::Vertex);
+    }
+
+    // Orphan the previous storage so that the driver does not have to wait on
+    // the GPU to finish with last frame's vertices before we overwrite them.
+    glBufferData(GL_ARRAY_BUFFER, vertex_buffer_capacity, nullptr, GL_STREAM_DRAW);
+    if (size > 0)
+        glBufferSubData(GL_ARRAY_BUFFER, 0, size, frame_vertices.data());
+}
+
+void Renderer::draw(PendingDraw const& pending, glm::mat4 const& pass_display_transform) const
+{
+    auto const& renderable = *pending.renderable;
+    auto const& data = pending.data;
     auto const texture = gl_interface->as_texture(renderable.buffer());
     auto const clip_area = renderable.clip_area();
     if (clip_area)
@@ -297,7 +744,7 @@ miracle::Renderer::DrawData Renderer::draw(
         auto clip_y = viewport.top_left.y.as_int() + viewport.size.height.as_int()
             - clip_area.value().top_left.y.as_int() - clip_area.value().size.height.as_int();
         glm::vec4 clip_pos(clip_area.value().top_left.x.as_int(), clip_y, 0, 1);
-        clip_pos = display_transform * data.workspace_transform * clip_pos;
+        clip_pos = pass_display_transform * data.workspace_transform * clip_pos;
 
         glScissor(
             (int)clip_pos.x - viewport.top_left.x.as_int(),
@@ -337,23 +784,7 @@ miracle::Renderer::DrawData Renderer::draw(
         return &family.opaque;
     }(renderable.alpha() < 1.0f);
 
-    glUseProgram(prog->id);
-    if (prog->last_used_frameno != frameno)
-    { // Avoid reloading the screen-global uniforms on every renderable
-        // TODO: We actually only need to bind these *once*, right? Not once per frame?
-        prog->last_used_frameno = frameno;
-        for (auto i = 0u; i < prog->tex_uniforms.size(); ++i)
-        {
-            if (prog->tex_uniforms[i] != -1)
-            {
-                glUniform1i(prog->tex_uniforms[i], (int)i);
-            }
-        }
-        glUniformMatrix4fv(prog->display_transform_uniform, 1, GL_FALSE,
-            glm::value_ptr(display_transform));
-        glUniformMatrix4fv(prog->screen_to_gl_coords_uniform, 1, GL_FALSE,
-            glm::value_ptr(screen_to_gl_coords));
-    }
+    use_program(*prog, pass_display_transform);
 
     glActiveTexture(GL_TEXTURE0);
 
@@ -410,9 +841,6 @@ miracle::Renderer::DrawData Renderer::draw(
     if (has_texcoord_attr)
         glEnableVertexAttribArray(prog->texcoord_attr);
 
-    primitives.clear();
-    tessellate(primitives, renderable);
-
     // if we fail to load the texture, we need to carry on (part of lp:1629275)
     try
     {
@@ -443,24 +871,26 @@ miracle::Renderer::DrawData Renderer::draw(
             glBlendColor(0.0f, 0.0f, 0.0f, renderable.alpha());
         }
 
-        for (auto const& p : primitives)
+        // The vertices live in the vertex buffer, so the attribute "pointers" are offsets into it
+        glVertexAttribPointer(prog->position_attr, 3, GL_FLOAT,
+            GL_FALSE, sizeof(mgl::Vertex),
+            reinterpret_cast<void const*>(offsetof(mgl::Vertex, position)));
+
+        if (has_texcoord_attr)
+        {
+            glVertexAttribPointer(prog->texcoord_attr, 2, GL_FLOAT,
+                GL_FALSE, sizeof(mgl::Vertex),
+                reinterpret_cast<void const*>(offsetof(mgl::Vertex, texcoord)));
+        }
+
+        for (size_t i = 0; i < pending.num_primitives; i++)
         {
+            auto const& p = frame_primitives[pending.first_primitive + i];
             BlendSeparate blend;
 
             blend = client_blend;
             texture->bind();
 
-            glVertexAttribPointer(prog->position_attr, 3, GL_FLOAT,
-                GL_FALSE, sizeof(mgl::Vertex),
-                &p.vertices[0].position);
-
-            if (has_texcoord_attr)
-            {
-                glVertexAttribPointer(prog->texcoord_attr, 2, GL_FLOAT,
-                    GL_FALSE, sizeof(mgl::Vertex),
-                    &p.vertices[0].texcoord);
-            }
-
             if (blend.dst_rgb == GL_ZERO)
             {
                 glDisable(GL_BLEND);
@@ -472,7 +902,8 @@ miracle::Renderer::DrawData Renderer::draw(
                     blend.src_alpha, blend.dst_alpha);
             }
 
-            glDrawArrays(p.type, 0, p.nvertices);
+            glDrawArrays(p.type, p.first_vertex, p.nvertices);
+            num_draw_calls++;
 
             // We're done with the texture for now
             texture->add_syncpoint();
@@ -490,27 +921,69 @@ miracle::Renderer::DrawData Renderer::draw(
     {
         glDisable(GL_SCISSOR_TEST);
     }
+}
 
-    // Next, draw the outline if we have container to facilitate it
-    if (data.needs_outline)
-    {
-        auto border_config = config->get_border_config();
-        if (border_config.size > 0)
+void Renderer::use_program(ProgramData const& prog, glm::mat4 const& pass_display_transform) const
+{
+    glUseProgram(prog.id);
+    if (prog.last_used_pass != render_pass)
+    { // Avoid reloading the screen-global uniforms on every renderable
+        // TODO: We actually only need to bind these *once*, right? Not once per frame?
+        prog.last_used_pass = render_pass;
+        for (auto i = 0u; i < prog.tex_uniforms.size(); ++i)
         {
-            auto color = data.is_focused ? border_config.focus_color : border_config.color;
-            return DrawData {
-                true,
-                false,
-                data.workspace_transform,
-                data.is_focused,
-                { true,
-                             color,
-                             border_config.size }
-            };
+            if (prog.tex_uniforms[i] != -1)
+            {
+                glUniform1i(prog.tex_uniforms[i], (int)i);
+            }
         }
+        glUniformMatrix4fv(prog.display_transform_uniform, 1, GL_FALSE,
+            glm::value_ptr(pass_display_transform));
+        glUniformMatrix4fv(prog.screen_to_gl_coords_uniform, 1, GL_FALSE,
+            glm::value_ptr(screen_to_gl_coords));
     }
+}
+
+void Renderer::draw_snapshot(PendingDraw const& pending) const
+{
+    auto const& prog = program_factory->get_rgba_texture_program().opaque;
+    use_program(prog, display_transform);
 
-    return { false };
+    glDisable(GL_STENCIL_TEST);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, pending.snapshot->texture());
+
+    GLfloat centrex = (float)viewport.top_left.x.as_int() + (float)viewport.size.width.as_int() / 2.0f;
+    GLfloat centrey = (float)viewport.top_left.y.as_int() + (float)viewport.size.height.as_int() / 2.0f;
+    glUniform2f(prog.centre_uniform, centrex, centrey);
+    glUniformMatrix4fv(prog.transform_uniform, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.f)));
+    glUniform1i(prog.mode_uniform, (int)RenderFilter::none);
+    glUniformMatrix4fv(prog.workspace_transform_uniform, 1, GL_FALSE,
+        glm::value_ptr(pending.data.workspace_transform));
+
+    // The snapshot holds premultiplied alpha
+    glEnable(GL_BLEND);
+    glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    glEnableVertexAttribArray(prog.position_attr);
+    glEnableVertexAttribArray(prog.texcoord_attr);
+    glVertexAttribPointer(prog.position_attr, 3, GL_FLOAT,
+        GL_FALSE, sizeof(mgl::Vertex),
+        reinterpret_cast<void const*>(offsetof(mgl::Vertex, position)));
+    glVertexAttribPointer(prog.texcoord_attr, 2, GL_FLOAT,
+        GL_FALSE, sizeof(mgl::Vertex),
+        reinterpret_cast<void const*>(offsetof(mgl::Vertex, texcoord)));
+
+    for (size_t i = 0; i < pending.num_primitives; i++)
+    {
+        auto const& p = frame_primitives[pending.first_primitive + i];
+        glDrawArrays(p.type, p.first_vertex, p.nvertices);
+        num_draw_calls++;
+    }
+
+    glDisableVertexAttribArray(prog.texcoord_attr);
+    glDisableVertexAttribArray(prog.position_attr);
+    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Renderer::set_viewport(mir::geometry::Rectangle const& rect)
@@ -552,10 +1025,11 @@ void Renderer::set_viewport(mir::geometry::Rectangle const& rect)
             0.0f });
 
     viewport = rect;
+    statistics->set_viewport(rect);
     update_gl_viewport();
 }
 
-void Renderer::update_gl_viewport()
+void Renderer::update_gl_viewport() const
 {
     /*
      * Letterboxing: Move the glViewport to add black bars in the case that
@@ -583,7 +1057,17 @@ void Renderer::update_gl_viewport()
         GLint offset_y = (output_height - reduced_height) / 2;
 
         glViewport(offset_x, offset_y, reduced_width, reduced_height);
+        viewport_fills_output = offset_x == 0 && offset_y == 0;
+
+        // Letterboxing keeps pixels square, so the viewport is scaled by the same amount on both axes
+        float const scale = (float)reduced_width / viewport_width;
+        viewport_pixel_size = mir::geometry::Size {
+            std::max(1, (int)std::lround((float)viewport.size.width.as_int() * scale)),
+            std::max(1, (int)std::lround((float)viewport.size.height.as_int() * scale))
+        };
     }
+    else
+        viewport_pixel_size = viewport.size;
 }
 
 void Renderer::set_output_transform(glm::mat2 const& t)
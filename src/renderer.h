@@ -18,9 +18,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIR_RENDERER_GL_RENDERER_H_
 #define MIR_RENDERER_GL_RENDERER_H_
 
+#include "gpu_frame_timer.h"
 #include "primitive.h"
 #include "program_factory.h"
 #include "surface_tracker.h"
+#include "workspace_snapshot.h"
 
 #include <GLES2/gl2.h>
 #include <mir/geometry/rectangle.h>
@@ -28,6 +30,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <mir/graphics/renderable.h>
 #include <mir/renderer/renderer.h>
 #include <miral/window_manager_tools.h>
+#include <optional>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -42,6 +45,10 @@ namespace graphics::gl
 {
     class OutputSurface;
 }
+namespace scene
+{
+    class Surface;
+}
 }
 
 namespace miracle
@@ -49,6 +56,11 @@ namespace miracle
 class Config;
 class CompositorState;
 class WindowToolsAccessor;
+class RenderStatistics;
+class OutputRenderStatistics;
+class Workspace;
+class FrameClock;
+class WindowGhosts;
 
 class Renderer : public mir::renderer::Renderer
 {
@@ -58,8 +70,11 @@ public:
         std::shared_ptr<Config> const& config,
         SurfaceTracker& surface_tracker,
         CompositorState const& compositor_state,
-        std::shared_ptr<WindowToolsAccessor> const& accessor);
-    ~Renderer() override = default;
+        std::shared_ptr<WindowToolsAccessor> const& accessor,
+        std::shared_ptr<RenderStatistics> const& render_statistics,
+        std::shared_ptr<FrameClock> const& frame_clock,
+        std::shared_ptr<WindowGhosts> const& window_ghosts);
+    ~Renderer() override;
 
     // These are called with a valid GL context:
     void set_viewport(mir::geometry::Rectangle const& rect) override;
@@ -69,6 +84,31 @@ public:
     // This is called _without_ a GL context:
     void suspend() override;
 
+protected:
+    struct DrawData
+    {
+        bool enabled = false;
+        bool needs_outline = false;
+        glm::mat4 workspace_transform = glm::mat4(1.f);
+        bool is_focused = false;
+        bool is_fullscreen = false;
+
+        struct
+        {
+            bool enabled = false;
+            glm::vec4 color;
+            int size;
+        } outline_context;
+
+        /// Set while the output of the renderable is switching workspaces
+        Workspace const* switching_workspace = nullptr;
+        uint32_t workspace_switch_id = 0;
+    };
+
+    /// Works out how the renderable should be drawn from the window that it belongs to. The
+    /// benchmarks override this to place their renderables without a window manager.
+    virtual DrawData get_draw_data(mir::graphics::Renderable const&) const;
+
 private:
     /**
      * tessellate defines the list of triangles that will be used to render
@@ -89,40 +129,113 @@ private:
     static void tessellate(std::vector<mir::gl::Primitive>& primitives,
         mir::graphics::Renderable const& renderable);
 
-    struct DrawData
+    /// A run of vertices in the frame's vertex buffer that is drawn with a single call.
+    struct BufferedPrimitive
     {
-        bool enabled = false;
-        bool needs_outline = false;
-        glm::mat4 workspace_transform = glm::mat4(1.f);
-        bool is_focused = false;
+        GLenum type;
+        GLint first_vertex;
+        GLsizei nvertices;
+    };
 
-        struct
-        {
-            bool enabled = false;
-            glm::vec4 color;
-            int size;
-        } outline_context;
+    /// A renderable that has been queued for drawing during this frame.
+    struct PendingDraw
+    {
+        mir::graphics::Renderable const* renderable;
+        DrawData data;
+        size_t first_primitive;
+        size_t num_primitives;
+        /// If set, the snapshot of a workspace is drawn instead of [renderable]
+        WorkspaceSnapshot const* snapshot = nullptr;
+    };
+
+    /// The snapshot of a workspace that is taking part in a workspace switch.
+    struct SnapshotEntry
+    {
+        std::unique_ptr<WorkspaceSnapshot> snapshot;
+        uint32_t switch_id = 0;
+        /// Identifies the set of renderables that the snapshot was captured from
+        size_t signature = 0;
+        /// Indices into the current frame's renderables that belong to the workspace
+        std::vector<size_t> members;
+        size_t pending_signature = 0;
+        long long last_seen_frameno = 0;
+        long long last_queued_frameno = 0;
+    };
+
+    /// The tessellation of a renderable from a previous frame. The vertices only
+    /// depend on the screen position, the source bounds and the buffer size, because
+    /// every transform is applied through uniforms.
+    struct TessellationCacheEntry
+    {
+        mir::geometry::Rectangle screen_position;
+        mir::geometry::RectangleD src_bounds;
+        mir::geometry::Size buffer_size;
+        std::vector<mir::gl::Primitive> primitives;
+        long long last_used_frameno = 0;
     };
 
-    DrawData get_draw_data(mir::graphics::Renderable const&) const;
-    /// Draws the current renderable and returns a follow-up draw if required.
-    DrawData draw(mir::graphics::Renderable const& renderable, DrawData const& data) const;
-    void update_gl_viewport();
+    /// Returns the follow-up outline draw for the provided draw, if one is required.
+    DrawData get_outline_draw_data(DrawData const& data) const;
+    /// Tessellates the renderable into the frame's vertex list and queues it for drawing.
+    void queue_draw(mir::graphics::Renderable const& renderable, DrawData const& data, bool cacheable) const;
+    /// Queues the renderable along with its outline, if it has one.
+    void queue_renderable(mir::graphics::Renderable const& renderable, DrawData const& data) const;
+    /// Queues a quad covering the viewport that is textured with the snapshot.
+    void queue_snapshot(WorkspaceSnapshot const& snapshot, DrawData const& data) const;
+    /// Uploads the vertices of every queued draw into the vertex buffer in a single transfer.
+    void upload_vertices() const;
+    void draw(PendingDraw const& pending, glm::mat4 const& pass_display_transform) const;
+    void draw_snapshot(PendingDraw const& pending) const;
+    void use_program(ProgramData const& prog, glm::mat4 const& pass_display_transform) const;
+    /// Captures any workspace snapshots that are out of date. Returns true if anything was captured.
+    bool prepare_workspace_snapshots(mir::graphics::RenderableList const& renderables) const;
+    /// Draws the workspace at rest into its snapshot, at the pixel density of the output. The
+    /// contents of clients are frozen from then on until the snapshot is captured again.
+    void capture_workspace(SnapshotEntry& entry, mir::graphics::RenderableList const& renderables) const;
+    SnapshotEntry* get_workspace_snapshot(DrawData const& data) const;
+    /// Returns the index of the topmost renderable that is an opaque fullscreen window
+    /// covering the entire viewport, if any. Nothing beneath it can be seen.
+    std::optional<size_t> find_fullscreen_occluder(mir::graphics::RenderableList const& renderables) const;
+    void update_gl_viewport() const;
 
     std::unique_ptr<mir::graphics::gl::OutputSurface> const output_surface;
     GLfloat clear_color[4];
     bool has_stencil_support = false;
     mutable long long frameno = 0;
+    /// Incremented for every pass over a framebuffer, so that programs know when to reload their uniforms
+    mutable long long render_pass = 0;
     std::unique_ptr<ProgramFactory> const program_factory;
     mir::geometry::Rectangle viewport;
     glm::mat4 screen_to_gl_coords;
     glm::mat4 display_transform;
+    /// False when the viewport is letterboxed within the output surface
+    bool mutable viewport_fills_output = true;
+    /// The number of output pixels that the viewport covers, before the display transform is applied
+    mir::geometry::Size mutable viewport_pixel_size;
     std::vector<mir::gl::Primitive> mutable primitives;
+    GLuint vertex_buffer = 0;
+    GLsizeiptr mutable vertex_buffer_capacity = 0;
+    std::vector<mir::gl::Vertex> mutable frame_vertices;
+    std::vector<BufferedPrimitive> mutable frame_primitives;
+    std::vector<PendingDraw> mutable pending_draws;
+    std::vector<std::unique_ptr<mir::graphics::Renderable>> mutable outline_renderables;
+    std::unordered_map<mir::graphics::Renderable::ID, TessellationCacheEntry> mutable tessellation_cache;
+    std::vector<DrawData> mutable frame_draw_data;
+    std::unordered_map<Workspace const*, SnapshotEntry> mutable workspace_snapshots;
     std::shared_ptr<mir::graphics::GLRenderingProvider> const gl_interface;
     std::shared_ptr<Config> config;
     SurfaceTracker& surface_tracker;
     CompositorState const& compositor_state;
     std::shared_ptr<WindowToolsAccessor> const& accessor;
+    std::shared_ptr<OutputRenderStatistics> const statistics;
+    std::shared_ptr<FrameClock> const frame_clock;
+    std::shared_ptr<WindowGhosts> const window_ghosts;
+    /// The scene along with any window ghosts, when there are ghosts to draw
+    mir::graphics::RenderableList mutable frame_renderables;
+    /// The surfaces of the previous frame from bottom to top, which place ghosts where their window was
+    std::vector<mir::scene::Surface const*> mutable previous_surfaces;
+    std::unique_ptr<GpuFrameTimer> mutable gpu_timer;
+    size_t mutable num_draw_calls = 0;
 };
 
 }
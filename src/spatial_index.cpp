@@ -0,0 +1,98 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace miracle;
+
+namespace
+{
+/// Upper bound on the cells along each axis, which keeps the grid small for many windows.
+constexpr int max_cells_per_axis = 64;
+}
+
+void SpatialIndex::rebuild(geom::Rectangle const& bounds_, std::vector<Entry> entries_)
+{
+    bounds = bounds_;
+    entries = std::move(entries_);
+
+    // Aim for roughly one entry per cell
+    int const cells_per_axis = std::clamp(
+        (int)std::ceil(std::sqrt((double)entries.size())), 1, max_cells_per_axis);
+    columns = cells_per_axis;
+    rows = cells_per_axis;
+    cell_width = std::max(1, (bounds.size.width.as_int() + columns - 1) / columns);
+    cell_height = std::max(1, (bounds.size.height.as_int() + rows - 1) / rows);
+
+    // Count the entries in each cell, then lay the cells out one after another
+    cell_offsets.assign(columns * rows + 1, 0);
+    auto const for_each_cell = [&](Entry const& entry, auto const& f)
+    {
+        if (entry.area.size.width.as_int() <= 0 || entry.area.size.height.as_int() <= 0)
+            return;
+
+        int const first_column = column_of(entry.area.top_left.x.as_int());
+        int const last_column = column_of(entry.area.top_left.x.as_int() + entry.area.size.width.as_int() - 1);
+        int const first_row = row_of(entry.area.top_left.y.as_int());
+        int const last_row = row_of(entry.area.top_left.y.as_int() + entry.area.size.height.as_int() - 1);
+        for (int row = first_row; row <= last_row; row++)
+            for (int column = first_column; column <= last_column; column++)
+                f(row * columns + column);
+    };
+
+    for (auto const& entry : entries)
+        for_each_cell(entry, [&](int cell)
+        { cell_offsets[cell + 1]++; });
+
+    for (size_t i = 1; i < cell_offsets.size(); i++)
+        cell_offsets[i] += cell_offsets[i - 1];
+
+    cell_entries.resize(cell_offsets.back());
+    std::vector<uint32_t> next(cell_offsets.begin(), cell_offsets.end() - 1);
+    for (uint32_t i = 0; i < entries.size(); i++)
+        for_each_cell(entries[i], [&](int cell)
+        { cell_entries[next[cell]++] = i; });
+}
+
+std::shared_ptr<Container> SpatialIndex::at(geom::Point const& point) const
+{
+    if (entries.empty() || !bounds.contains(point))
+        return nullptr;
+
+    int const cell = row_of(point.y.as_int()) * columns + column_of(point.x.as_int());
+    for (auto i = cell_offsets[cell]; i < cell_offsets[cell + 1]; i++)
+    {
+        auto const& entry = entries[cell_entries[i]];
+        if (entry.area.contains(point))
+            return entry.container.lock();
+    }
+
+    return nullptr;
+}
+
+int SpatialIndex::column_of(int x) const
+{
+    return std::clamp((x - bounds.top_left.x.as_int()) / cell_width, 0, columns - 1);
+}
+
+int SpatialIndex::row_of(int y) const
+{
+    return std::clamp((y - bounds.top_left.y.as_int()) / cell_height, 0, rows - 1);
+}
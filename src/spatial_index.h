@@ -0,0 +1,68 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_SPATIAL_INDEX_H
+#define MIRACLE_WM_SPATIAL_INDEX_H
+
+#include <memory>
+#include <mir/geometry/rectangle.h>
+#include <vector>
+
+namespace geom = mir::geometry;
+
+namespace miracle
+{
+class Container;
+
+/// A uniform grid over non-overlapping rectangles, such as those of the tiled windows
+/// on an output. Finding the container under a point looks at a single cell instead
+/// of walking the container tree.
+class SpatialIndex
+{
+public:
+    struct Entry
+    {
+        geom::Rectangle area;
+        std::weak_ptr<Container> container;
+    };
+
+    /// Replaces the contents of the index with [entries], which lie within [bounds].
+    void rebuild(geom::Rectangle const& bounds, std::vector<Entry> entries);
+
+    /// Returns the container whose area contains [point], or nullptr. Does not allocate.
+    [[nodiscard]] std::shared_ptr<Container> at(geom::Point const& point) const;
+
+    [[nodiscard]] size_t size() const { return entries.size(); }
+
+private:
+    geom::Rectangle bounds;
+    int columns = 0;
+    int rows = 0;
+    int cell_width = 1;
+    int cell_height = 1;
+    std::vector<Entry> entries;
+
+    /// The entries overlapping cell i are cell_entries[cell_offsets[i]..cell_offsets[i + 1]]
+    std::vector<uint32_t> cell_offsets;
+    std::vector<uint32_t> cell_entries;
+
+    [[nodiscard]] int column_of(int x) const;
+    [[nodiscard]] int row_of(int y) const;
+};
+}
+
+#endif // MIRACLE_WM_SPATIAL_INDEX_H
@@ -38,7 +38,7 @@ TilingWindowTree::TilingWindowTree(
     CompositorState const& state,
     std::shared_ptr<Config> const& config,
     geom::Rectangle const& area) :
-    root_lane { std::make_shared<ParentContainer>(
+    root_lane { pool.make<ParentContainer>(
         window_controller,
         area,
         config,
@@ -62,6 +62,12 @@ TilingWindowTree::~TilingWindowTree()
     config->unregister_listener(config_handle);
 }
 
+void TilingWindowTree::set_auto_layout(AutoLayout layout)
+{
+    LayoutTransactionScope transaction(*state.layout_transaction);
+    root_lane->set_auto_layout(layout);
+}
+
 miral::WindowSpecification TilingWindowTree::place_new_window(
     const miral::WindowSpecification& requested_specification,
     std::shared_ptr<ParentContainer> const& parent_)
@@ -92,16 +98,18 @@ std::shared_ptr<LeafContainer> TilingWindowTree::confirm_window(
 
 void TilingWindowTree::graft(std::shared_ptr<ParentContainer> const& parent)
 {
+    LayoutTransactionScope transaction(*state.layout_transaction);
     parent->set_tree(this);
     root_lane->graft_existing(parent, root_lane->num_nodes());
-    root_lane->commit_changes();
+    state.layout_transaction->commit(root_lane);
 }
 
 void TilingWindowTree::graft(std::shared_ptr<LeafContainer> const& leaf)
 {
+    LayoutTransactionScope transaction(*state.layout_transaction);
     leaf->set_tree(this);
     root_lane->graft_existing(leaf, root_lane->num_nodes());
-    root_lane->commit_changes();
+    state.layout_transaction->commit(root_lane);
 }
 
 bool TilingWindowTree::resize_container(miracle::Direction direction, Container& container)
@@ -112,8 +120,8 @@ bool TilingWindowTree::resize_container(miracle::Direction direction, Container&
         return false;
     }
 
-    handle_resize(container, direction, config->get_resize_jump());
-    return true;
+    LayoutTransactionScope transaction(*state.layout_transaction);
+    return handle_resize(container, direction, config->get_resize_jump());
 }
 
 bool TilingWindowTree::select_next(
@@ -125,7 +133,7 @@ bool TilingWindowTree::select_next(
         return false;
     }
 
-    auto node = handle_select(container, direction);
+    auto node = get_neighbor(container, direction);
     if (!node)
     {
         mir::log_warning("Unable to select the next window: handle_select failed");
@@ -136,6 +144,21 @@ bool TilingWindowTree::select_next(
     return true;
 }
 
+std::shared_ptr<LeafContainer> TilingWindowTree::get_neighbor(Container& container, Direction direction)
+{
+    if (neighbor_index_generation != layout_generation)
+    {
+        neighbor_index.clear();
+        neighbor_index_generation = layout_generation;
+    }
+
+    auto& neighbor = neighbor_index[&container][(size_t)direction];
+    if (!neighbor)
+        neighbor = handle_select(container, direction);
+
+    return neighbor->lock();
+}
+
 bool TilingWindowTree::toggle_fullscreen(LeafContainer& container)
 {
     if (is_active_window_fullscreen)
@@ -147,8 +170,10 @@ bool TilingWindowTree::toggle_fullscreen(LeafContainer& container)
 
 void TilingWindowTree::set_area(geom::Rectangle const& new_area)
 {
+    // A hidden tree only records the new rectangles. Its windows receive them when shown.
     root_lane->set_logical_area(new_area);
-    root_lane->commit_changes();
+    if (!is_hidden)
+        state.layout_transaction->commit(root_lane);
 }
 
 geom::Rectangle TilingWindowTree::get_area() const
@@ -177,6 +202,7 @@ bool TilingWindowTree::move_container(miracle::Direction direction, Container& c
         return false;
     }
 
+    LayoutTransactionScope transaction(*state.layout_transaction);
     auto traversal_result = handle_move(container, direction);
     switch (traversal_result.traversal_type)
     {
@@ -200,13 +226,13 @@ bool TilingWindowTree::move_container(miracle::Direction direction, Container& c
         if (active_parent == target_parent)
         {
             active_parent->swap_nodes(container.shared_from_this(), target_node);
-            active_parent->commit_changes();
+            state.layout_transaction->commit(active_parent);
             break;
         }
 
         auto [first, second] = transfer_node(container.shared_from_this(), target_node);
-        first->commit_changes();
-        second->commit_changes();
+        state.layout_transaction->commit(first);
+        state.layout_transaction->commit(second);
         break;
     }
     case MoveResult::traversal_type_append:
@@ -215,7 +241,7 @@ bool TilingWindowTree::move_container(miracle::Direction direction, Container& c
         auto moving_node = container.shared_from_this();
         handle_remove(moving_node);
         lane_node->graft_existing(moving_node, lane_node->num_nodes());
-        lane_node->commit_changes();
+        state.layout_transaction->commit(lane_node);
         break;
     }
     case MoveResult::traversal_type_prepend:
@@ -224,7 +250,7 @@ bool TilingWindowTree::move_container(miracle::Direction direction, Container& c
         auto moving_node = container.shared_from_this();
         handle_remove(moving_node);
         lane_node->graft_existing(moving_node, 0);
-        lane_node->commit_changes();
+        state.layout_transaction->commit(lane_node);
         break;
     }
     default:
@@ -328,7 +354,7 @@ void TilingWindowTree::advise_delete_window(std::shared_ptr<Container> const& co
     }
 
     auto parent = handle_remove(container);
-    parent->commit_changes();
+    state.layout_transaction->commit(parent);
 }
 
 namespace
@@ -411,8 +437,8 @@ std::shared_ptr<LeafContainer> TilingWindowTree::handle_select(
     //  4. If none match, we return nullptr
     bool is_vertical = is_vertical_direction(direction);
     bool is_negative = is_negative_direction(direction);
-    auto current_node = from.shared_from_this();
-    auto parent = current_node->get_parent().lock();
+    Container const* current_node = &from;
+    auto parent = from.get_parent_link();
     if (!parent)
     {
         mir::log_warning("Cannot handle_select the root node");
@@ -422,24 +448,21 @@ std::shared_ptr<LeafContainer> TilingWindowTree::handle_select(
     do
     {
         auto grandparent_direction = parent->get_direction();
-        int index = parent->get_index_of_node(current_node);
-        if (is_vertical && (grandparent_direction == LayoutScheme::vertical || grandparent_direction == LayoutScheme::stacking)
+        if (parent->get_auto_layout() != AutoLayout::none)
+        {
+            // Automatic layouts have no single axis, so the neighbor is found from the areas
+            if (auto neighbor = parent->get_auto_layout_neighbor(*current_node, direction))
+                return get_closest_window_to_select_from_node(neighbor, direction);
+        }
+        else if (is_vertical && (grandparent_direction == LayoutScheme::vertical || grandparent_direction == LayoutScheme::stacking)
             || !is_vertical && (grandparent_direction == LayoutScheme::horizontal || grandparent_direction == LayoutScheme::tabbing))
         {
-            if (is_negative)
-            {
-                if (index > 0)
-                    return get_closest_window_to_select_from_node(parent->at(index - 1), direction);
-            }
-            else
-            {
-                if (index < parent->num_nodes() - 1)
-                    return get_closest_window_to_select_from_node(parent->at(index + 1), direction);
-            }
+            if (auto sibling = parent->get_sibling(*current_node, is_negative ? -1 : 1))
+                return get_closest_window_to_select_from_node(sibling, direction);
         }
 
         current_node = parent;
-        parent = Container::as_parent(parent->get_parent().lock());
+        parent = parent->get_parent_link();
     } while (parent != nullptr);
 
     return nullptr;
@@ -452,7 +475,7 @@ TilingWindowTree::MoveResult TilingWindowTree::handle_move(Container& from, Dire
     //     currently is
     //  2. If our parent layout direction does not equal the root layout direction, we can append
     //     or prepend to the root
-    if (auto insert_node = handle_select(from, direction))
+    if (auto insert_node = get_neighbor(from, direction))
     {
         return {
             MoveResult::traversal_type_insert,
@@ -463,11 +486,12 @@ TilingWindowTree::MoveResult TilingWindowTree::handle_move(Container& from, Dire
     auto parent = from.get_parent().lock();
     if (root_lane == parent)
     {
+        // Wrapping the root in a new lane would drop its automatic layout
         auto new_layout_direction = from_direction(direction);
-        if (new_layout_direction == root_lane->get_direction())
+        if (new_layout_direction == root_lane->get_direction() || root_lane->get_auto_layout() != AutoLayout::none)
             return {};
 
-        auto after_root_lane = std::make_shared<ParentContainer>(
+        auto after_root_lane = pool.make<ParentContainer>(
             window_controller,
             root_lane->get_logical_area(),
             config,
@@ -493,7 +517,7 @@ TilingWindowTree::MoveResult TilingWindowTree::handle_move(Container& from, Dire
         };
 }
 
-void TilingWindowTree::handle_resize(
+bool TilingWindowTree::handle_resize(
     Container& node,
     Direction direction,
     int amount)
@@ -502,101 +526,36 @@ void TilingWindowTree::handle_resize(
     if (parent == nullptr)
     {
         // Can't resize, most likely the root
-        return;
+        return false;
+    }
+
+    if (parent->get_auto_layout() == AutoLayout::grid)
+    {
+        mir::log_warning("Unable to resize a window in a grid: every cell is the same size");
+        return false;
     }
 
     bool is_vertical = direction == Direction::up || direction == Direction::down;
-    bool is_main_axis_movement = (is_vertical && parent->get_direction() == LayoutScheme::vertical)
+    bool is_main_axis_movement = parent->get_auto_layout() != AutoLayout::none
+        || (is_vertical && parent->get_direction() == LayoutScheme::vertical)
         || (!is_vertical && parent->get_direction() == LayoutScheme::horizontal);
 
     if (is_main_axis_movement && parent->num_nodes() == 1)
     {
         // Can't resize if we only have ourselves!
-        return;
+        return false;
     }
 
     if (!is_main_axis_movement)
-    {
-        handle_resize(*parent, direction, amount);
-        return;
-    }
+        return handle_resize(*parent, direction, amount);
 
     bool is_negative = direction == Direction::left || direction == Direction::up;
     auto resize_amount = is_negative ? -amount : amount;
-    auto nodes = parent->get_sub_nodes();
-    std::vector<geom::Rectangle> pending_node_resizes;
-    if (is_vertical)
-    {
-        int height_for_others = (int)floor(-(double)resize_amount / static_cast<double>(nodes.size() - 1));
-        int total_height = 0;
-        for (size_t i = 0; i < nodes.size(); i++)
-        {
-            auto other_node = nodes[i];
-            auto other_rect = other_node->get_logical_area();
-            if (node.shared_from_this() == other_node)
-                other_rect.size.height = geom::Height { other_rect.size.height.as_int() + resize_amount };
-            else
-                other_rect.size.height = geom::Height { other_rect.size.height.as_int() + height_for_others };
-
-            if (i != 0)
-            {
-                auto prev_rect = pending_node_resizes[i - 1];
-                other_rect.top_left.y = geom::Y { prev_rect.top_left.y.as_int() + prev_rect.size.height.as_int() };
-            }
-
-            if (other_rect.size.height.as_int() <= other_node->get_min_height())
-            {
-                mir::log_warning("Unable to resize a rectangle that would cause another to be negative");
-                return;
-            }
-
-            total_height += other_rect.size.height.as_int();
-            pending_node_resizes.push_back(other_rect);
-        }
-
-        // Due to some rounding errors, we may have to extend the final node
-        int leftover_height = parent->get_logical_area().size.height.as_int() - total_height;
-        pending_node_resizes.back().size.height = geom::Height { pending_node_resizes.back().size.height.as_int() + leftover_height };
-    }
-    else
-    {
-        int width_for_others = (int)floor((double)-resize_amount / static_cast<double>(nodes.size() - 1));
-        int total_width = 0;
-        for (size_t i = 0; i < nodes.size(); i++)
-        {
-            auto other_node = nodes[i];
-            auto other_rect = other_node->get_logical_area();
-            if (node.shared_from_this() == other_node)
-                other_rect.size.width = geom::Width { other_rect.size.width.as_int() + resize_amount };
-            else
-                other_rect.size.width = geom::Width { other_rect.size.width.as_int() + width_for_others };
-
-            if (i != 0)
-            {
-                auto prev_rect = pending_node_resizes[i - 1];
-                other_rect.top_left.x = geom::X { prev_rect.top_left.x.as_int() + prev_rect.size.width.as_int() };
-            }
-
-            if (other_rect.size.width.as_int() <= other_node->get_min_width())
-            {
-                mir::log_warning("Unable to resize a rectangle that would cause another to be negative");
-                return;
-            }
-
-            total_width += other_rect.size.width.as_int();
-            pending_node_resizes.push_back(other_rect);
-        }
-
-        // Due to some rounding errors, we may have to extend the final node
-        int leftover_width = parent->get_logical_area().size.width.as_int() - total_width;
-        pending_node_resizes.back().size.width = geom::Width { pending_node_resizes.back().size.width.as_int() + leftover_width };
-    }
+    if (!parent->resize_node(node, resize_amount))
+        return false;
 
-    for (size_t i = 0; i < nodes.size(); i++)
-    {
-        nodes[i]->set_logical_area(pending_node_resizes[i]);
-        nodes[i]->commit_changes();
-    }
+    state.layout_transaction->commit(parent);
+    return true;
 }
 
 std::shared_ptr<ParentContainer> TilingWindowTree::handle_remove(std::shared_ptr<Container> const& node)
@@ -636,13 +595,27 @@ std::tuple<std::shared_ptr<ParentContainer>, std::shared_ptr<ParentContainer>> T
 }
 
 void TilingWindowTree::recalculate_root_node_area()
+{
+    // Windows on a hidden workspace are laid out once, with their final size, when it is shown
+    if (is_hidden)
+    {
+        is_root_area_stale = true;
+        return;
+    }
+
+    if (apply_root_node_area())
+        state.layout_transaction->commit(root_lane);
+}
+
+bool TilingWindowTree::apply_root_node_area()
 {
     for (auto const& zone : tree_interface->get_zones())
     {
         root_lane->set_logical_area(zone.extents());
-        root_lane->commit_changes();
-        break;
+        return true;
     }
+
+    return false;
 }
 
 bool TilingWindowTree::advise_fullscreen_container(LeafContainer& container)
@@ -659,8 +632,8 @@ bool TilingWindowTree::advise_restored_container(LeafContainer& container)
     auto active = active_container();
     if (active && active->window() == container.window().value() && is_active_window_fullscreen)
     {
+        // The area has not changed, so the container puts the window back where it belongs
         is_active_window_fullscreen = false;
-        container.set_logical_area(container.get_logical_area());
         container.commit_changes();
     }
 
@@ -764,6 +737,14 @@ std::shared_ptr<LeafContainer> TilingWindowTree::show()
         return nullptr;
     }
 
+    LayoutTransactionScope transaction(*state.layout_transaction);
+    if (is_root_area_stale)
+    {
+        // Showing commits every window, so the deferred layout needs no commit of its own
+        apply_root_node_area();
+        is_root_area_stale = false;
+    }
+
     root_lane->show();
     is_hidden = false;
 
@@ -18,15 +18,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIRACLE_TREE_H
 #define MIRACLE_TREE_H
 
+#include "auto_layout.h"
 #include "container.h"
+#include "container_pool.h"
 #include "direction.h"
 #include "layout_scheme.h"
+#include <array>
 #include <memory>
 #include <mir/geometry/rectangle.h>
 #include <miral/window.h>
 #include <miral/window_manager_tools.h>
 #include <miral/window_specification.h>
 #include <miral/zone.h>
+#include <optional>
+#include <unordered_map>
 #include <vector>
 
 namespace geom = mir::geometry;
@@ -80,6 +85,15 @@ public:
     /// Select the next window in the provided direction
     bool select_next(Direction direction, Container&);
 
+    /// Returns the window that navigation reaches from [container] in [direction], if any.
+    std::shared_ptr<LeafContainer> get_neighbor(Container& container, Direction direction);
+
+    /// Called by the lanes of this tree when they commit their layout.
+    void advise_layout_changed() { layout_generation++; }
+
+    /// Changes each time the layout of this tree is committed.
+    [[nodiscard]] uint64_t get_layout_generation() const { return layout_generation; }
+
     /// Toggle the active window between fullscreen and not fullscreen
     bool toggle_fullscreen(LeafContainer&);
 
@@ -138,6 +152,13 @@ public:
     [[nodiscard]] Workspace* get_workspace() const;
     [[nodiscard]] std::shared_ptr<ParentContainer> const& get_root() const { return root_lane; }
 
+    /// Places the top-level windows of this tree with [layout]. Windows that are split
+    /// into nested lanes keep their manual layout within their cell.
+    void set_auto_layout(AutoLayout layout);
+
+    /// The pool from which every container in this tree is allocated.
+    [[nodiscard]] ContainerPool const& get_pool() const { return pool; }
+
 private:
     struct MoveResult
     {
@@ -155,15 +176,30 @@ private:
     WindowController& window_controller;
     CompositorState const& state;
     std::shared_ptr<Config> config;
+    ContainerPool pool;
     std::shared_ptr<ParentContainer> root_lane;
     std::unique_ptr<TilingWindowTreeInterface> tree_interface;
 
     bool is_active_window_fullscreen = false;
     bool is_hidden = false;
+
+    /// Set when the root area changed while the tree was hidden
+    bool is_root_area_stale = false;
     int config_handle = 0;
 
+    /// Incremented each time a lane of this tree commits its layout
+    uint64_t layout_generation = 0;
+
+    /// The window that [handle_select] reaches from each leaf in every direction. Entries are
+    /// computed on first use and forgotten when the layout of this tree changes, so that
+    /// repeated navigation is a lookup.
+    std::unordered_map<Container const*, std::array<std::optional<std::weak_ptr<LeafContainer>>, (size_t)Direction::MAX>> neighbor_index;
+    std::optional<uint64_t> neighbor_index_generation;
+
+    /// Sets the root area from the first zone. Returns false if there are no zones.
+    bool apply_root_node_area();
     void handle_layout_scheme(LayoutScheme direction, Container& container);
-    void handle_resize(Container& node, Direction direction, int amount);
+    bool handle_resize(Container& node, Direction direction, int amount);
 
     /// Constrains the container to its tile in the tree
     bool constrain(Container&);
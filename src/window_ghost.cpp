@@ -0,0 +1,177 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "window_ghost.h"
+
+#include <algorithm>
+#include <mir/scene/surface.h>
+
+using namespace miracle;
+
+namespace
+{
+/// Mir keeps track of the buffers that each compositor has acquired from a surface by its id.
+/// Ghosts acquire the last buffer under an id of their own, so that they never take the
+/// place of a renderer in that bookkeeping.
+char const ghost_compositor_id = 0;
+}
+
+std::shared_ptr<WindowGhost> WindowGhost::capture(
+    mir::scene::Surface& surface,
+    mir::geometry::Rectangle const& output_area,
+    glm::mat4 const& workspace_transform)
+{
+    // The first renderable of a surface is the window itself, and it holds the last buffer the client submitted
+    auto const renderables = surface.generate_renderables(&ghost_compositor_id);
+    if (renderables.empty() || !renderables.front()->buffer())
+        return nullptr;
+
+    return std::make_shared<WindowGhost>(*renderables.front(), &surface, output_area, workspace_transform);
+}
+
+WindowGhost::WindowGhost(
+    mir::graphics::Renderable const& last_frame,
+    mir::scene::Surface const* origin,
+    mir::geometry::Rectangle const& output_area,
+    glm::mat4 const& workspace_transform) :
+    last_buffer { last_frame.buffer() },
+    position { last_frame.screen_position() },
+    bounds { last_frame.src_bounds() },
+    clip { last_frame.clip_area() },
+    is_shaped { last_frame.shaped() },
+    origin { origin },
+    output_area { output_area },
+    workspace_transform { workspace_transform },
+    transform { last_frame.transformation() },
+    alpha_ { last_frame.alpha() }
+{
+}
+
+auto WindowGhost::id() const -> ID
+{
+    return this;
+}
+
+std::shared_ptr<mir::graphics::Buffer> WindowGhost::buffer() const
+{
+    return last_buffer;
+}
+
+mir::geometry::Rectangle WindowGhost::screen_position() const
+{
+    return position;
+}
+
+mir::geometry::RectangleD WindowGhost::src_bounds() const
+{
+    return bounds;
+}
+
+std::optional<mir::geometry::Rectangle> WindowGhost::clip_area() const
+{
+    return clip;
+}
+
+float WindowGhost::alpha() const
+{
+    std::lock_guard lock(mutex);
+    return alpha_;
+}
+
+glm::mat4 WindowGhost::transformation() const
+{
+    std::lock_guard lock(mutex);
+    return transform;
+}
+
+bool WindowGhost::shaped() const
+{
+    return is_shaped;
+}
+
+std::optional<mir::scene::Surface const*> WindowGhost::surface_if_any() const
+{
+    return std::nullopt;
+}
+
+void WindowGhost::set_transformation(glm::mat4 const& next)
+{
+    std::lock_guard lock(mutex);
+    transform = next;
+}
+
+void WindowGhost::set_alpha(float next)
+{
+    std::lock_guard lock(mutex);
+    alpha_ = next;
+}
+
+mir::scene::Surface const* WindowGhost::get_surface_above(std::vector<mir::scene::Surface const*> const& previous_surfaces)
+{
+    std::lock_guard lock(mutex);
+    if (!surface_above)
+    {
+        // A surface may be drawn with several renderables, so we skip past the rest of its own
+        auto it = std::ranges::find(previous_surfaces, origin);
+        it = std::find_if(it, previous_surfaces.end(), [&](auto const surface)
+        { return surface != origin; });
+        surface_above = it == previous_surfaces.end() ? nullptr : *it;
+    }
+
+    return surface_above.value();
+}
+
+void WindowGhosts::add(std::shared_ptr<WindowGhost> const& ghost)
+{
+    std::lock_guard lock(mutex);
+    ghosts.push_back(ghost);
+}
+
+void WindowGhosts::remove(std::shared_ptr<WindowGhost> const& ghost)
+{
+    std::lock_guard lock(mutex);
+    std::erase(ghosts, ghost);
+}
+
+bool WindowGhosts::empty() const
+{
+    std::lock_guard lock(mutex);
+    return ghosts.empty();
+}
+
+void WindowGhosts::insert_into(
+    mir::graphics::RenderableList& renderables,
+    mir::geometry::Rectangle const& viewport,
+    std::vector<mir::scene::Surface const*> const& previous_surfaces) const
+{
+    std::lock_guard lock(mutex);
+    for (auto const& ghost : ghosts)
+    {
+        if (!ghost->get_output_area().overlaps(viewport))
+            continue;
+
+        // If the surface above has gone away as well, the ghost is drawn on top
+        auto position = renderables.end();
+        if (auto const above = ghost->get_surface_above(previous_surfaces))
+        {
+            position = std::ranges::find_if(renderables, [&](auto const& renderable)
+            { return renderable->surface_if_any() == above; });
+        }
+
+        renderables.insert(position, ghost);
+    }
+}
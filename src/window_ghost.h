@@ -0,0 +1,116 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_WINDOW_GHOST_H
+#define MIRACLEWM_WINDOW_GHOST_H
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <mir/geometry/rectangle.h>
+#include <mir/graphics/renderable.h>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace mir::scene
+{
+class Surface;
+}
+
+namespace miracle
+{
+/// The last frame of a window that has been closed. The ghost holds on to the window's
+/// final buffer so that the compositor can keep drawing it while the close animation
+/// plays, even though the client and its surface are already gone.
+class WindowGhost : public mir::graphics::Renderable
+{
+public:
+    /// Captures the last frame of [surface], which is shown on the output at [output_area].
+    /// Returns null if the surface has nothing to show.
+    static std::shared_ptr<WindowGhost> capture(
+        mir::scene::Surface& surface,
+        mir::geometry::Rectangle const& output_area,
+        glm::mat4 const& workspace_transform);
+
+    WindowGhost(
+        mir::graphics::Renderable const& last_frame,
+        mir::scene::Surface const* origin,
+        mir::geometry::Rectangle const& output_area,
+        glm::mat4 const& workspace_transform);
+
+    [[nodiscard]] ID id() const override;
+    [[nodiscard]] std::shared_ptr<mir::graphics::Buffer> buffer() const override;
+    [[nodiscard]] mir::geometry::Rectangle screen_position() const override;
+    [[nodiscard]] mir::geometry::RectangleD src_bounds() const override;
+    [[nodiscard]] std::optional<mir::geometry::Rectangle> clip_area() const override;
+    [[nodiscard]] float alpha() const override;
+    [[nodiscard]] glm::mat4 transformation() const override;
+    [[nodiscard]] bool shaped() const override;
+    [[nodiscard]] std::optional<mir::scene::Surface const*> surface_if_any() const override;
+
+    /// The output and workspace transform of the window when it was closed.
+    [[nodiscard]] glm::mat4 const& get_workspace_transform() const { return workspace_transform; }
+    [[nodiscard]] mir::geometry::Rectangle const& get_output_area() const { return output_area; }
+
+    /// Returns the surface that was drawn directly above the window, or null if the window was
+    /// on top. This is looked up in [previous_surfaces], the surfaces of the frame before the
+    /// window went away from bottom to top, the first time that it is asked for.
+    mir::scene::Surface const* get_surface_above(std::vector<mir::scene::Surface const*> const& previous_surfaces);
+
+    void set_transformation(glm::mat4 const&);
+    void set_alpha(float);
+
+private:
+    std::shared_ptr<mir::graphics::Buffer> const last_buffer;
+    mir::geometry::Rectangle const position;
+    mir::geometry::RectangleD const bounds;
+    std::optional<mir::geometry::Rectangle> const clip;
+    bool const is_shaped;
+    /// Only used to find the window in the scene. The surface may already be gone.
+    mir::scene::Surface const* const origin;
+    mir::geometry::Rectangle const output_area;
+    glm::mat4 const workspace_transform;
+
+    mutable std::mutex mutex;
+    glm::mat4 transform;
+    float alpha_;
+    std::optional<mir::scene::Surface const*> surface_above;
+};
+
+/// The ghosts that are currently being animated. Ghosts are added and removed on the
+/// server thread and drawn by the renderer of the output that their window was on.
+class WindowGhosts
+{
+public:
+    void add(std::shared_ptr<WindowGhost> const&);
+    void remove(std::shared_ptr<WindowGhost> const&);
+    [[nodiscard]] bool empty() const;
+
+    /// Inserts the ghosts of the output at [viewport] into [renderables], each beneath the
+    /// surface that was above its window in [previous_surfaces].
+    void insert_into(
+        mir::graphics::RenderableList& renderables,
+        mir::geometry::Rectangle const& viewport,
+        std::vector<mir::scene::Surface const*> const& previous_surfaces) const;
+
+private:
+    mutable std::mutex mutex;
+    std::vector<std::shared_ptr<WindowGhost>> ghosts;
+};
+}
+
+#endif // MIRACLEWM_WINDOW_GHOST_H
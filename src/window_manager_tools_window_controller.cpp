@@ -26,6 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define MIR_LOG_COMPONENT "window_manager_tools_tiling_interface"
 #include <glm/gtc/matrix_transform.hpp>
 #include <mir/log.h>
+#include <limits>
 
 using namespace miracle;
 
@@ -37,6 +38,12 @@ WindowManagerToolsWindowController::WindowManagerToolsWindowController(
     animator { animator },
     state { state }
 {
+    animator.set_batch_listener(this);
+}
+
+WindowManagerToolsWindowController::~WindowManagerToolsWindowController()
+{
+    animator.set_batch_listener(nullptr);
 }
 
 void WindowManagerToolsWindowController::open(miral::Window const& window)
@@ -154,8 +161,68 @@ void WindowManagerToolsWindowController::send_to_back(miral::Window const& windo
     tools.send_tree_to_back(window);
 }
 
+namespace
+{
+constexpr size_t no_frame_index = std::numeric_limits<size_t>::max();
+}
+
 void WindowManagerToolsWindowController::on_animation(
     miracle::AnimationStepResult const& result, std::shared_ptr<Container> const& container)
+{
+    if (!is_batching)
+    {
+        apply_animation(result, container);
+        return;
+    }
+
+    if (result.handle >= frame_index_by_handle.size())
+        frame_index_by_handle.resize(result.handle + 1, no_frame_index);
+
+    auto const index = frame_index_by_handle[result.handle];
+    if (index == no_frame_index)
+    {
+        frame_index_by_handle[result.handle] = animation_frame.size();
+        animation_frame.push_back({ result, container });
+        return;
+    }
+
+    // Several steps were delivered at once, so only the latest values need to be applied
+    auto& pending = animation_frame[index].result;
+    pending.is_complete = result.is_complete;
+    if (result.position)
+        pending.position = result.position;
+    if (result.size)
+        pending.size = result.size;
+    if (result.transform)
+        pending.transform = result.transform;
+}
+
+void WindowManagerToolsWindowController::begin_batch()
+{
+    is_batching = true;
+}
+
+void WindowManagerToolsWindowController::end_batch()
+{
+    is_batching = false;
+    if (animation_frame.empty())
+        return;
+
+    // Every window is updated in a single pass under one lock, so that nothing observes a
+    // frame in which only some of the windows have moved.
+    tools.invoke_under_lock([this]()
+    {
+        for (auto const& pending : animation_frame)
+            apply_animation(pending.result, pending.container);
+    });
+
+    for (auto const& pending : animation_frame)
+        frame_index_by_handle[pending.result.handle] = no_frame_index;
+    animation_frame.clear();
+}
+
+void WindowManagerToolsWindowController::apply_animation(
+    miracle::AnimationStepResult const& result, std::shared_ptr<Container> const& container)
 {
     auto window = container->window().value();
     auto surface = window.operator std::shared_ptr<mir::scene::Surface>();
@@ -197,19 +264,22 @@ void WindowManagerToolsWindowController::on_animation(
 
     // NOTE: The clip area needs to reflect the current position + transform of the window.
     // Failing to set a clip area will cause overflowing windows to briefly disregard their
-    // compacted size.
-    // TODO: When we have rotation in our transforms, then we need to handle rotations.
-    //  At that point, the top_left corner will change. We will need to find an AABB
-    //  to represent the clip area.
+    // compacted size. The transform is applied around the centre of the window, so we clip
+    // to the box that holds its transformed corners.
     auto transform = container->get_transform();
-    auto width = spec.size().value().width.as_int();
-    auto height = spec.size().value().height.as_int();
-
-    glm::vec4 scale = transform * glm::vec4(width, height, 0, 1);
+    auto width = static_cast<float>(spec.size().value().width.as_int());
+    auto height = static_cast<float>(spec.size().value().height.as_int());
+    glm::vec2 const centre(
+        spec.top_left().value().x.as_int() + width / 2.f,
+        spec.top_left().value().y.as_int() + height / 2.f);
+    glm::vec4 const first_corner = transform * glm::vec4(-width / 2.f, -height / 2.f, 0, 1);
+    glm::vec4 const second_corner = transform * glm::vec4(width / 2.f, height / 2.f, 0, 1);
+    glm::vec2 const top_left = centre + glm::min(glm::vec2(first_corner), glm::vec2(second_corner));
+    glm::vec2 const bottom_right = centre + glm::max(glm::vec2(first_corner), glm::vec2(second_corner));
 
     mir::geometry::Rectangle new_rectangle(
-        { spec.top_left().value().x.as_int(), spec.top_left().value().y.as_int() },
-        { scale.x, scale.y });
+        { top_left.x, top_left.y },
+        { bottom_right.x - top_left.x, bottom_right.y - top_left.y });
 
     if (container->get_type() == ContainerType::leaf)
         clip(window, new_rectangle);
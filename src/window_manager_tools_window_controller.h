@@ -18,21 +18,23 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIRACLEWM_WINDOW_MANAGER_TOOLS_TILING_INTERFACE_H
 #define MIRACLEWM_WINDOW_MANAGER_TOOLS_TILING_INTERFACE_H
 
+#include "animator.h"
 #include "window_controller.h"
 #include <miral/window_manager_tools.h>
+#include <vector>
 
 namespace miracle
 {
-class Animator;
 class CompositorState;
 
-class WindowManagerToolsWindowController : public WindowController
+class WindowManagerToolsWindowController : public WindowController, public AnimationBatchListener
 {
 public:
     WindowManagerToolsWindowController(
         miral::WindowManagerTools const&,
         Animator& animator,
         CompositorState& state);
+    ~WindowManagerToolsWindowController() override;
     void open(miral::Window const&) override;
     bool is_fullscreen(miral::Window const&) override;
     void set_rectangle(miral::Window const&, geom::Rectangle const&, geom::Rectangle const&) override;
@@ -49,11 +51,27 @@ public:
     void modify(miral::Window const&, miral::WindowSpecification const&) override;
     miral::WindowInfo& info_for(miral::Window const&) override;
     void close(miral::Window const& window) override;
+    void begin_batch() override;
+    void end_batch() override;
 
 private:
+    struct PendingAnimation
+    {
+        AnimationStepResult result;
+        std::shared_ptr<Container> container;
+    };
+
+    void apply_animation(miracle::AnimationStepResult const& result, std::shared_ptr<Container> const&);
+
     miral::WindowManagerTools tools;
     Animator& animator;
     CompositorState& state;
+
+    /// While a batch is being delivered, results are collected here and applied together in [end_batch]
+    bool is_batching = false;
+    std::vector<PendingAnimation> animation_frame;
+    /// The index of each handle in [animation_frame], so that a window is only modified once per frame
+    std::vector<size_t> frame_index_by_handle;
 };
 }
 
@@ -27,6 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "output.h"
 #include "parent_container.h"
 #include "shell_component_container.h"
+#include "spatial_index.h"
 #include "tiling_window_tree.h"
 #include "window_helpers.h"
 
@@ -87,6 +88,8 @@ Workspace::Workspace(
         std::make_unique<OutputTilingWindowTreeInterface>(output, this),
         window_controller, state, config, output->get_area()))
 {
+    if (auto const auto_layout = config->get_workspace_config(num, name).auto_layout)
+        tree->set_auto_layout(auto_layout.value());
 }
 
 void Workspace::set_area(mir::geometry::Rectangle const& area)
@@ -247,6 +250,34 @@ void Workspace::for_each_window(std::function<void(std::shared_ptr<Container>)>
     });
 }
 
+void Workspace::build_tiled_index(SpatialIndex& index, mir::geometry::Rectangle const& bounds) const
+{
+    std::vector<SpatialIndex::Entry> entries;
+    tree->foreach_node([&](std::shared_ptr<Container> const& node)
+    {
+        if (node->is_leaf())
+            entries.push_back({ node->get_visible_area(), node });
+    });
+    index.rebuild(bounds, std::move(entries));
+}
+
+bool Workspace::has_floating_content_at(mir::geometry::Point const& point) const
+{
+    for (auto const& window : floating_windows)
+    {
+        if (window->get_visible_area().contains(point))
+            return true;
+    }
+
+    for (auto const& floating_tree : floating_trees)
+    {
+        if (floating_tree->get_visible_area().contains(point))
+            return true;
+    }
+
+    return false;
+}
+
 void Workspace::toggle_floating(std::shared_ptr<Container> const& container)
 {
     auto const handle_ready = [&](
@@ -37,6 +37,7 @@ class CompositorState;
 class ParentContainer;
 class FloatingWindowContainer;
 class FloatingTreeContainer;
+class SpatialIndex;
 
 struct AllocationHint
 {
@@ -73,6 +74,12 @@ public:
     void hide();
     void transfer_pinned_windows_to(std::shared_ptr<Workspace> const& other);
     void for_each_window(std::function<void(std::shared_ptr<Container>)> const&) const;
+
+    /// Fills [index] with the visible areas of the tiled windows on this workspace.
+    void build_tiled_index(SpatialIndex& index, mir::geometry::Rectangle const& bounds) const;
+
+    /// True if a floating window or floating tree covers [point].
+    [[nodiscard]] bool has_floating_content_at(mir::geometry::Point const& point) const;
     void toggle_floating(std::shared_ptr<Container> const&);
     bool has_floating_window(std::shared_ptr<Container> const&);
     std::shared_ptr<FloatingWindowContainer> add_floating_window(miral::Window const&);
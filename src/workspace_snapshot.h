@@ -0,0 +1,59 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_WORKSPACE_SNAPSHOT_H
+#define MIRACLEWM_WORKSPACE_SNAPSHOT_H
+
+#include <GLES2/gl2.h>
+#include <mir/geometry/size.h>
+
+namespace miracle
+{
+
+/// An offscreen framebuffer holding a picture of a workspace. While an output switches
+/// between workspaces, each workspace is drawn into a snapshot once and the snapshots
+/// are animated instead of drawing every window of every workspace on every frame.
+///
+/// A snapshot is only captured again when a window appears or goes away, so clients
+/// that update during the switch are shown as they were when it began.
+///
+/// Must be constructed, used, and destroyed with a GL context current.
+class WorkspaceSnapshot
+{
+public:
+    /// [size] is in output pixels, which may be larger than the logical size of the workspace.
+    WorkspaceSnapshot(mir::geometry::Size const& size, bool with_stencil);
+    ~WorkspaceSnapshot();
+
+    WorkspaceSnapshot(WorkspaceSnapshot const&) = delete;
+    WorkspaceSnapshot& operator=(WorkspaceSnapshot const&) = delete;
+
+    /// Binds the framebuffer of the snapshot so that subsequent draws are captured.
+    void bind() const;
+    [[nodiscard]] GLuint texture() const { return texture_id; }
+    [[nodiscard]] mir::geometry::Size const& size() const { return size_; }
+
+private:
+    mir::geometry::Size size_;
+    GLuint framebuffer = 0;
+    GLuint texture_id = 0;
+    GLuint stencil_buffer = 0;
+};
+
+}
+
+#endif // MIRACLEWM_WORKSPACE_SNAPSHOT_H
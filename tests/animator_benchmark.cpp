@@ -0,0 +1,105 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "animator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <vector>
+
+using namespace miracle;
+
+namespace
+{
+constexpr int retargets_per_run = 200;
+
+AnimationDefinition slide_definition()
+{
+    AnimationDefinition definition;
+    definition.type = AnimationType::slide;
+    definition.function = EaseFunction::ease_out_cubic;
+    definition.duration_seconds = 0.25f;
+    return definition;
+}
+
+Animation make_move(AnimationHandle handle, int from_x, int to_x)
+{
+    mir::geometry::Rectangle const from { mir::geometry::Point(from_x, 0), mir::geometry::Size(400, 300) };
+    mir::geometry::Rectangle const to { mir::geometry::Point(to_x, 0), mir::geometry::Size(400, 300) };
+    return Animation(handle, slide_definition(), from, to, from, [](AnimationStepResult const&) {});
+}
+
+/// Times [retarget], which moves every animation to a new target, in microseconds per call.
+template <typename RetargetT>
+double time_retargets(RetargetT const& retarget)
+{
+    auto const start = std::chrono::steady_clock::now();
+    for (int i = 0; i < retargets_per_run; i++)
+        retarget(i);
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::micro>(elapsed).count() / retargets_per_run;
+}
+}
+
+class AnimationRetargetBenchmark : public testing::TestWithParam<int>
+{
+};
+
+TEST_P(AnimationRetargetBenchmark, RetargetAllAnimations)
+{
+    int const num_windows = GetParam();
+
+    // Baseline: the previous queue, which erased any animation with the same handle before appending
+    std::vector<Animation> queue;
+    for (int handle = 1; handle <= num_windows; handle++)
+        queue.push_back(make_move(handle, 0, 100));
+    auto const linear_us = time_retargets([&](int run)
+    {
+        for (int handle = 1; handle <= num_windows; handle++)
+        {
+            auto animation = make_move(handle, 0, 100 + run);
+            std::erase_if(queue, [&](Animation const& other)
+            { return other.get_handle() == animation.get_handle(); });
+            queue.push_back(animation);
+        }
+    });
+
+    AnimationStore store;
+    std::vector<AnimationStore::Update> updates;
+    for (int handle = 1; handle <= num_windows; handle++)
+        store.insert(make_move(handle, 0, 100));
+    store.step(0.016f, updates);
+    auto const indexed_us = time_retargets([&](int run)
+    {
+        for (int handle = 1; handle <= num_windows; handle++)
+            store.insert(make_move(handle, 0, 100 + run));
+    });
+
+    EXPECT_EQ(store.size(), num_windows);
+    std::cout << "animations: " << num_windows
+              << ", linear scan: " << linear_us << "us/relayout"
+              << ", indexed: " << indexed_us << "us/relayout" << std::endl;
+    RecordProperty("linear_us", std::to_string(linear_us));
+    RecordProperty("indexed_us", std::to_string(indexed_us));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    AnimationCounts,
+    AnimationRetargetBenchmark,
+    testing::Values(10, 40, 200, 1000));
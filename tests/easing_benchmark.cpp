@@ -0,0 +1,93 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "animation_defintion.h"
+#include "easing.h"
+
+#include <chrono>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <vector>
+
+using namespace miracle;
+
+namespace
+{
+/// Roughly the number of animations that a large relayout eases in a single step.
+constexpr size_t batch_size = 256;
+constexpr int batches_per_run = 20000;
+
+/// Times [evaluate], which eases a batch of values, in nanoseconds per value.
+template <typename EvaluateT>
+double time_batches(EvaluateT const& evaluate)
+{
+    auto const start = std::chrono::steady_clock::now();
+    for (int i = 0; i < batches_per_run; i++)
+        evaluate();
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (batches_per_run * batch_size);
+}
+}
+
+class EaseThroughputBenchmark : public testing::TestWithParam<EaseFunction>
+{
+};
+
+TEST_P(EaseThroughputBenchmark, EvaluateBatch)
+{
+    AnimationDefinition definition;
+    definition.function = GetParam();
+    auto const table = make_ease_table(definition);
+    ASSERT_NE(table, nullptr);
+
+    std::vector<float> t(batch_size);
+    for (size_t i = 0; i < batch_size; i++)
+        t[i] = static_cast<float>(i) / (batch_size - 1);
+    std::vector<float> out(batch_size);
+
+    // Keep a running sum so that the evaluations cannot be optimized away
+    float sum = 0.f;
+    auto const exact_ns = time_batches([&]
+    {
+        ease_exact(definition, t.data(), out.data(), batch_size);
+        sum += out[batch_size / 2];
+    });
+    auto const table_ns = time_batches([&]
+    {
+        table->evaluate(t.data(), out.data(), batch_size);
+        sum += out[batch_size / 2];
+    });
+
+    EXPECT_TRUE(std::isfinite(sum));
+    std::cout << "function: " << static_cast<int>(GetParam())
+              << ", exact: " << exact_ns << "ns/value"
+              << ", table: " << table_ns << "ns/value" << std::endl;
+    RecordProperty("exact_ns", std::to_string(exact_ns));
+    RecordProperty("table_ns", std::to_string(table_ns));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    EaseFunctions,
+    EaseThroughputBenchmark,
+    testing::Values(
+        EaseFunction::ease_out_sine,
+        EaseFunction::ease_out_cubic,
+        EaseFunction::ease_in_out_expo,
+        EaseFunction::ease_out_back,
+        EaseFunction::ease_out_elastic,
+        EaseFunction::ease_out_bounce));
@@ -467,3 +467,34 @@ TEST_F(FilesystemConfigurationTest, BorderCanbeParsedObjectColor)
     EXPECT_EQ(config.get_border_config().color.b, 30.f / 255.f);
     EXPECT_EQ(config.get_border_config().color.a, 55.f / 255.f);
 }
+
+TEST_F(FilesystemConfigurationTest, WorkspaceAutoLayoutCanBeParsed)
+{
+    YAML::Node workspace;
+    workspace["number"] = 1;
+    workspace["auto_layout"] = "spiral";
+
+    YAML::Node node;
+    node["workspaces"].push_back(workspace);
+    write_yaml_node(node);
+
+    FilesystemConfiguration config(runner, path, true);
+    EXPECT_EQ(config.get_workspace_config(1, std::nullopt).auto_layout, AutoLayout::spiral);
+}
+
+TEST_F(FilesystemConfigurationTest, WorkspaceWithInvalidAutoLayoutKeepsTheRestOfItsEntry)
+{
+    YAML::Node workspace;
+    workspace["number"] = 1;
+    workspace["name"] = "code";
+    workspace["auto_layout"] = "dwindle";
+
+    YAML::Node node;
+    node["workspaces"].push_back(workspace);
+    write_yaml_node(node);
+
+    FilesystemConfiguration config(runner, path, true);
+    auto const workspace_config = config.get_workspace_config(1, std::nullopt);
+    EXPECT_EQ(workspace_config.name, "code");
+    EXPECT_EQ(workspace_config.auto_layout, std::nullopt);
+}
@@ -0,0 +1,48 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_RECTANGLE_HELPERS_H
+#define MIRACLE_WM_RECTANGLE_HELPERS_H
+
+#include <algorithm>
+#include <mir/geometry/rectangle.h>
+
+namespace geom = mir::geometry;
+
+namespace miracle::test
+{
+inline int right(geom::Rectangle const& r) { return r.top_left.x.as_int() + r.size.width.as_int(); }
+inline int bottom(geom::Rectangle const& r) { return r.top_left.y.as_int() + r.size.height.as_int(); }
+
+/// Returns true if [inner] lies entirely within [outer].
+inline bool contains(geom::Rectangle const& outer, geom::Rectangle const& inner)
+{
+    return inner.top_left.x.as_int() >= outer.top_left.x.as_int()
+        && inner.top_left.y.as_int() >= outer.top_left.y.as_int()
+        && right(inner) <= right(outer)
+        && bottom(inner) <= bottom(outer);
+}
+
+/// Returns true if [a] and [b] share any area. Rectangles that only touch do not overlap.
+inline bool overlaps(geom::Rectangle const& a, geom::Rectangle const& b)
+{
+    return std::max(a.top_left.x.as_int(), b.top_left.x.as_int()) < std::min(right(a), right(b))
+        && std::max(a.top_left.y.as_int(), b.top_left.y.as_int()) < std::min(bottom(a), bottom(b));
+}
+}
+
+#endif // MIRACLE_WM_RECTANGLE_HELPERS_H
@@ -42,12 +42,12 @@ namespace test
 
         [[nodiscard]] int get_inner_gaps_x() const override
         {
-            return 0;
+            return inner_gaps_x;
         }
 
         [[nodiscard]] int get_inner_gaps_y() const override
         {
-            return 0;
+            return inner_gaps_y;
         }
 
         [[nodiscard]] int get_outer_gaps_x() const override
@@ -95,6 +95,11 @@ namespace test
             return false;
         }
 
+        [[nodiscard]] float get_animation_budget_ms() const override
+        {
+            return 0.f;
+        }
+
         [[nodiscard]] WorkspaceConfig get_workspace_config(std::optional<int> const& num, std::optional<std::string> const& name) const override
         {
             return { num, ContainerType::leaf, name };
@@ -128,6 +133,9 @@ namespace test
             return LayoutScheme::horizontal;
         }
 
+        int inner_gaps_x = 0;
+        int inner_gaps_y = 0;
+
     private:
         miracle::BorderConfig border_config;
         std::array<AnimationDefinition, static_cast<int>(AnimateableEvent::max)> animations;
@@ -0,0 +1,49 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_STUB_TILING_WINDOW_TREE_INTERFACE_H
+#define MIRACLE_WM_STUB_TILING_WINDOW_TREE_INTERFACE_H
+
+#include "tiling_window_tree.h"
+
+namespace miracle::test
+{
+/// A tree interface with a single zone covering [area] and no workspace.
+class StubTilingWindowTreeInterface : public TilingWindowTreeInterface
+{
+public:
+    explicit StubTilingWindowTreeInterface(geom::Rectangle const& area) :
+        zones { area }
+    {
+    }
+
+    std::vector<miral::Zone> const& get_zones() override
+    {
+        return zones;
+    }
+
+    Workspace* get_workspace() const override
+    {
+        return nullptr;
+    }
+
+private:
+    std::vector<miral::Zone> zones;
+};
+}
+
+#endif // MIRACLE_WM_STUB_TILING_WINDOW_TREE_INTERFACE_H
@@ -0,0 +1,146 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "animation_budget.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+using namespace std::chrono_literals;
+
+namespace
+{
+constexpr auto refresh_period = 16667us;
+
+/// Runs [count] frames that each spend [cost] on animations, starting at [now].
+std::optional<AnimationBudget::Event> run_frames(
+    AnimationBudget& budget,
+    int count,
+    AnimationBudget::clock::duration cost,
+    AnimationBudget::clock::time_point& now,
+    AnimationBudget::clock::duration interval = refresh_period)
+{
+    std::optional<AnimationBudget::Event> last_event;
+    for (int i = 0; i < count; i++)
+    {
+        now += interval;
+        budget.add_cost(cost);
+        if (auto event = budget.end_frame(AnimationBudget::FrameTiming { interval, refresh_period }, now))
+            last_event = event;
+    }
+    return last_event;
+}
+}
+
+TEST(AnimationBudgetTest, DegradesAfterConsecutiveFramesOverBudget)
+{
+    AnimationBudget budget;
+    budget.set_budget_ms(4);
+    auto now = AnimationBudget::clock::now();
+
+    EXPECT_FALSE(run_frames(budget, AnimationBudget::frames_before_degrading - 1, 6ms, now));
+    EXPECT_EQ(budget.get_level(), AnimationDegradation::none);
+
+    auto const event = run_frames(budget, 1, 6ms, now);
+    ASSERT_TRUE(event);
+    EXPECT_EQ(event->from, AnimationDegradation::none);
+    EXPECT_EQ(event->to, AnimationDegradation::transform_only);
+    EXPECT_NEAR(event->frame_cost_ms, 6.f, 0.01f);
+
+    run_frames(budget, AnimationBudget::frames_before_degrading, 6ms, now);
+    EXPECT_EQ(budget.get_level(), AnimationDegradation::snap);
+}
+
+TEST(AnimationBudgetTest, SingleSlowFramesDoNotDegrade)
+{
+    AnimationBudget budget;
+    budget.set_budget_ms(4);
+    auto now = AnimationBudget::clock::now();
+
+    for (int i = 0; i < 10; i++)
+    {
+        run_frames(budget, 1, 6ms, now);
+        run_frames(budget, 1, 1ms, now);
+    }
+    EXPECT_EQ(budget.get_level(), AnimationDegradation::none);
+}
+
+TEST(AnimationBudgetTest, LateFramesDegradeEvenWhenAnimationsAreCheap)
+{
+    AnimationBudget budget;
+    budget.set_budget_ms(4);
+    auto now = AnimationBudget::clock::now();
+
+    run_frames(budget, 10, 1ms, now);
+    run_frames(budget, AnimationBudget::frames_before_degrading, 1ms, now, refresh_period * 3);
+    EXPECT_EQ(budget.get_level(), AnimationDegradation::transform_only);
+}
+
+TEST(AnimationBudgetTest, RecoversAfterFramesWithinBudget)
+{
+    AnimationBudget budget;
+    budget.set_budget_ms(4);
+    auto now = AnimationBudget::clock::now();
+
+    run_frames(budget, AnimationBudget::frames_before_degrading, 6ms, now);
+    ASSERT_EQ(budget.get_level(), AnimationDegradation::transform_only);
+
+    EXPECT_FALSE(run_frames(budget, AnimationBudget::frames_before_recovering - 1, 1ms, now));
+    auto const event = run_frames(budget, 1, 1ms, now);
+    ASSERT_TRUE(event);
+    EXPECT_EQ(event->to, AnimationDegradation::none);
+}
+
+TEST(AnimationBudgetTest, ResumingAfterIdleRecoversOneLevel)
+{
+    AnimationBudget budget;
+    budget.set_budget_ms(4);
+    auto now = AnimationBudget::clock::now();
+
+    run_frames(budget, AnimationBudget::frames_before_degrading * 2, 6ms, now);
+    ASSERT_EQ(budget.get_level(), AnimationDegradation::snap);
+
+    EXPECT_FALSE(budget.resume(now + 100ms));
+    EXPECT_EQ(budget.get_level(), AnimationDegradation::snap);
+
+    auto const event = budget.resume(now + AnimationBudget::idle_recovery_period);
+    ASSERT_TRUE(event);
+    EXPECT_EQ(event->to, AnimationDegradation::transform_only);
+}
+
+TEST(AnimationBudgetTest, NonPositiveBudgetNeverDegrades)
+{
+    AnimationBudget budget;
+    budget.set_budget_ms(0);
+    auto now = AnimationBudget::clock::now();
+
+    run_frames(budget, 100, 50ms, now);
+    EXPECT_EQ(budget.get_level(), AnimationDegradation::none);
+}
+
+TEST(AnimationBudgetTest, ReportsEventsAsJson)
+{
+    AnimationBudget budget;
+    budget.set_budget_ms(4);
+    auto now = AnimationBudget::clock::now();
+    run_frames(budget, AnimationBudget::frames_before_degrading, 6ms, now);
+
+    auto const json = budget.to_json();
+    EXPECT_EQ(json["level"], "transform_only");
+    EXPECT_EQ(json["total_events"], 1);
+    ASSERT_EQ(json["events"].size(), 1);
+    EXPECT_EQ(json["events"][0]["from"], "none");
+}
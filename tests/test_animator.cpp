@@ -15,14 +15,21 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 **/
 
+#include "animation_trace.h"
 #include "animator.h"
 #include "config.h"
 #include "yaml-cpp/yaml.h"
+#include <atomic>
+#include <chrono>
+#include <ctime>
 #include <filesystem>
 #include <fstream>
 #include <gtest/gtest.h>
 #include <mir/server_action_queue.h>
 #include <miral/runner.h>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 using namespace miracle;
 
@@ -31,6 +38,18 @@ namespace
 int argc = 1;
 char const* argv[] = { "miracle-wm-tests" };
 const std::string path = std::filesystem::current_path() / "test.yaml";
+
+mir::geometry::Rectangle rect_at(int x, int y)
+{
+    return { mir::geometry::Point(x, y), mir::geometry::Size(0, 0) };
+}
+
+std::chrono::nanoseconds process_cpu_time()
+{
+    timespec ts {};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
 }
 
 class ImmediateServerActionQueue : public mir::ServerActionQueue
@@ -131,6 +150,220 @@ TEST_F(AnimatorTest, LinearSlideResultsInCorrectNewPoint)
     animator.step();
 }
 
+TEST_F(AnimatorTest, FramesAdvanceAnimationsByElapsedTime)
+{
+    Animator animator(queue, config);
+    animator.start();
+    auto handle = animator.register_animateable();
+    std::atomic<int> num_steps = 0;
+    std::atomic<bool> is_complete = false;
+    animator.window_move(
+        handle,
+        rect_at(0, 0),
+        rect_at(600, 0),
+        rect_at(0, 0),
+        [&](AnimationStepResult const& asr)
+    {
+        if (asr.is_complete)
+            is_complete = true;
+        else
+            num_steps++;
+    });
+
+    // Drive the animation with a 144Hz display
+    auto const duration = config->get_animation_definitions()[(int)AnimateableEvent::window_move].duration_seconds;
+    auto const frame_interval = std::chrono::microseconds(6944);
+    auto frame_time = std::chrono::steady_clock::now();
+    for (int i = 0; i < 1000 && !is_complete; i++)
+    {
+        frame_time += frame_interval;
+        animator.on_frame(frame_time);
+    }
+
+    EXPECT_TRUE(is_complete);
+    EXPECT_NEAR(num_steps, duration * 144, 3);
+}
+
+TEST_F(AnimatorTest, OutputsThatAreOutOfPhaseAreBudgetedByTheirOwnFrames)
+{
+    auto time_source = std::make_shared<ManualAnimationClock>();
+    time_source->set(std::chrono::steady_clock::time_point(std::chrono::seconds(100)));
+    Animator animator(queue, config, time_source);
+    auto handle = animator.register_animateable();
+    animator.window_move(handle, rect_at(0, 0), rect_at(600, 0), rect_at(0, 0), [](auto const&) { });
+
+    // Two 60Hz outputs whose frames are 3ms apart
+    int const first_output = 0;
+    int const second_output = 0;
+    auto const refresh_period = std::chrono::microseconds(16667);
+    for (int i = 0; i < 6; i++)
+    {
+        time_source->advance(std::chrono::milliseconds(3));
+        animator.on_frame(time_source->now(), &first_output);
+        time_source->advance(refresh_period - std::chrono::milliseconds(3));
+        animator.on_frame(time_source->now(), &second_output);
+    }
+
+    auto const json = animator.get_budget().to_json();
+    EXPECT_EQ(json["level"], "none");
+    EXPECT_NEAR(json["frame_interval_ms"].get<float>(), 16.667f, 0.01f);
+    EXPECT_NEAR(json["refresh_period_ms"].get<float>(), 16.667f, 0.01f);
+}
+
+TEST_F(AnimatorTest, AnimatingWithoutFramesDoesNotBusyWait)
+{
+    Animator animator(queue, config);
+    animator.start();
+    auto handle = animator.register_animateable();
+    std::atomic<bool> is_complete = false;
+
+    auto const cpu_start = process_cpu_time();
+    auto const wall_start = std::chrono::steady_clock::now();
+    animator.window_move(
+        handle,
+        rect_at(0, 0),
+        rect_at(600, 0),
+        rect_at(0, 0),
+        [&](AnimationStepResult const& asr)
+    {
+        if (asr.is_complete)
+            is_complete = true;
+    });
+
+    while (!is_complete && std::chrono::steady_clock::now() - wall_start < std::chrono::seconds(5))
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    auto const cpu_used = process_cpu_time() - cpu_start;
+    auto const wall_used = std::chrono::steady_clock::now() - wall_start;
+    EXPECT_TRUE(is_complete);
+
+    // A busy-waiting animator would use a whole core for the duration of the animation
+    EXPECT_LT(cpu_used, wall_used / 10);
+}
+
+TEST_F(AnimatorTest, StepResultsAreDeliveredAsASingleBatch)
+{
+    class RecordingListener : public AnimationBatchListener
+    {
+    public:
+        void begin_batch() override
+        {
+            is_in_batch = true;
+            results_in_batch = 0;
+        }
+
+        void end_batch() override
+        {
+            is_in_batch = false;
+            batch_sizes.push_back(results_in_batch);
+        }
+
+        bool is_in_batch = false;
+        int results_in_batch = 0;
+        int results_outside_batch = 0;
+        std::vector<int> batch_sizes;
+    };
+
+    constexpr int num_windows = 10;
+    Animator animator(queue, config);
+    animator.start();
+    RecordingListener listener;
+    animator.set_batch_listener(&listener);
+
+    for (int i = 0; i < num_windows; i++)
+    {
+        animator.window_move(
+            animator.register_animateable(),
+            rect_at(0, 0),
+            rect_at(600, 0),
+            rect_at(0, 0),
+            [&](AnimationStepResult const& asr)
+        {
+            // Results without a position are the initial results, which are applied immediately
+            if (!asr.position)
+                return;
+
+            if (listener.is_in_batch)
+                listener.results_in_batch++;
+            else
+                listener.results_outside_batch++;
+        });
+    }
+
+    animator.step();
+    animator.set_batch_listener(nullptr);
+
+    int results_in_batches = 0;
+    for (auto size : listener.batch_sizes)
+        results_in_batches += size;
+
+    EXPECT_EQ(listener.results_outside_batch, 0);
+    EXPECT_GE(results_in_batches, num_windows);
+}
+
+namespace
+{
+/// Moves [num_windows] windows across the screen and then back before they arrive,
+/// driving the animator with a 60Hz display on a manual clock.
+std::string record_relayout_storm(std::shared_ptr<mir::ServerActionQueue> const& queue, std::shared_ptr<Config> const& config, int num_windows)
+{
+    auto time_source = std::make_shared<ManualAnimationClock>();
+    time_source->set(std::chrono::steady_clock::time_point(std::chrono::seconds(100)));
+    auto out = std::make_shared<std::stringstream>();
+    Animator animator(queue, config, time_source);
+    animator.set_recorder(std::make_shared<AnimationRecorder>(out));
+
+    std::vector<AnimationHandle> handles;
+    for (int i = 0; i < num_windows; i++)
+        handles.push_back(animator.register_animateable());
+
+    auto const frame = [&]
+    {
+        time_source->advance(std::chrono::microseconds(16667));
+        animator.on_frame(time_source->now());
+    };
+
+    for (int i = 0; i < num_windows; i++)
+        animator.window_move(handles[i], rect_at(0, i * 10), rect_at(600, i * 10), rect_at(0, i * 10), [](auto const&) { });
+    for (int i = 0; i < 5; i++)
+        frame();
+    for (int i = 0; i < num_windows; i++)
+        animator.window_move(handles[i], rect_at(600, i * 10), rect_at(0, i * 10), rect_at(600, i * 10), [](auto const&) { });
+    for (int i = 0; i < 60; i++)
+        frame();
+
+    animator.set_recorder(nullptr);
+    return out->str();
+}
+}
+
+TEST_F(AnimatorTest, RecordingWithManualClockIsDeterministic)
+{
+    auto const first = record_relayout_storm(queue, config, 30);
+    auto const second = record_relayout_storm(queue, config, 30);
+    EXPECT_FALSE(first.empty());
+    EXPECT_EQ(first, second);
+}
+
+TEST_F(AnimatorTest, RecordedTraceReplaysToTheSameResults)
+{
+    std::stringstream in(record_relayout_storm(queue, config, 30));
+    auto const trace = AnimationTrace::read(in);
+    auto const report = trace.replay();
+
+    EXPECT_EQ(report.num_starts, 60);
+    EXPECT_GT(report.num_steps, 0);
+    EXPECT_GT(report.expected_results, 60);
+    EXPECT_TRUE(report.matches());
+    EXPECT_FALSE(report.first_mismatch);
+}
+
+TEST(AnimationTraceTest, ReadingSomethingElseThrows)
+{
+    std::stringstream in("not a trace");
+    EXPECT_THROW(AnimationTrace::read(in), std::runtime_error);
+}
+
 class AnimationTest : public testing::Test
 {
 };
@@ -156,4 +389,214 @@ TEST_F(AnimationTest, InterruptingSlideResultsInModifiedAnimationDuration)
             mir::geometry::Size(0, 0)),
         [](auto const& asr) {});
     ASSERT_NEAR(animation.get_runtime_seconds(), 2, 0.05);
-}
\ No newline at end of file
+}
+
+TEST_F(AnimationTest, StepAdvancesByTheProvidedTime)
+{
+    AnimationDefinition definition;
+    definition.duration_seconds = 1;
+    definition.type = AnimationType::slide;
+    definition.function = EaseFunction::linear;
+    Animation animation(
+        0,
+        definition,
+        rect_at(0, 0),
+        rect_at(600, 0),
+        rect_at(0, 0),
+        [](auto const& asr) {});
+
+    auto result = animation.step(1.f / 144.f);
+    ASSERT_TRUE(result.position);
+    EXPECT_NEAR(result.position.value().x, 600.f / 144.f, 0.01);
+
+    result = animation.step(1.f / 144.f);
+    ASSERT_TRUE(result.position);
+    EXPECT_NEAR(result.position.value().x, 2 * 600.f / 144.f, 0.01);
+}
+
+TEST_F(AnimationTest, RetargetingContinuesFromTheInterpolatedPosition)
+{
+    AnimationDefinition definition;
+    definition.duration_seconds = 1;
+    definition.type = AnimationType::slide;
+    definition.function = EaseFunction::linear;
+
+    AnimationStore store;
+    std::vector<AnimationStore::Update> updates;
+    store.insert(Animation(1, definition, rect_at(0, 0), rect_at(600, 0), rect_at(0, 0), [](auto const&) {}));
+    store.step(0.5f, updates);
+    ASSERT_EQ(updates.size(), 1);
+    ASSERT_TRUE(updates[0].result.position);
+    EXPECT_NEAR(updates[0].result.position.value().x, 300, 0.01);
+
+    // Retarget back to the start. The animation must not jump back to the original position.
+    store.insert(Animation(1, definition, rect_at(600, 0), rect_at(0, 0), rect_at(600, 0), [](auto const&) {}));
+    EXPECT_EQ(store.size(), 1);
+
+    updates.clear();
+    store.step(0.001f, updates);
+    ASSERT_EQ(updates.size(), 1);
+    ASSERT_TRUE(updates[0].result.position);
+    EXPECT_NEAR(updates[0].result.position.value().x, 300, 1);
+}
+
+TEST_F(AnimationTest, StoreReportsAnimationsInFlightUntilTheyComplete)
+{
+    AnimationDefinition definition;
+    definition.duration_seconds = 1;
+    definition.type = AnimationType::slide;
+    definition.function = EaseFunction::linear;
+
+    AnimationStore store;
+    std::vector<AnimationStore::Update> updates;
+    EXPECT_FALSE(store.has_animations_in_flight());
+
+    store.insert(Animation(1, definition, rect_at(0, 0), rect_at(600, 0), rect_at(0, 0), [](auto const&) {}));
+    store.insert(Animation(2, definition, rect_at(0, 0), rect_at(600, 0), rect_at(0, 0), [](auto const&) {}));
+    EXPECT_TRUE(store.has_animations_in_flight());
+
+    store.step(0.5f, updates);
+    EXPECT_TRUE(store.has_animations_in_flight());
+
+    store.step(0.5f, updates);
+    EXPECT_FALSE(store.has_animations_in_flight());
+
+    store.insert(Animation(1, definition, rect_at(0, 0), rect_at(600, 0), rect_at(0, 0), [](auto const&) {}));
+    store.finish(updates);
+    EXPECT_FALSE(store.has_animations_in_flight());
+}
+
+TEST_F(AnimationTest, TransformOnlySlideMovesTheWindowOnceAndTransformsItAfterwards)
+{
+    AnimationDefinition definition;
+    definition.duration_seconds = 1;
+    definition.type = AnimationType::slide;
+    definition.function = EaseFunction::linear;
+    definition.transform_only = true;
+
+    mir::geometry::Rectangle const from { mir::geometry::Point(0, 0), mir::geometry::Size(200, 100) };
+    mir::geometry::Rectangle const to { mir::geometry::Point(600, 0), mir::geometry::Size(400, 100) };
+    Animation animation(0, definition, from, to, from, [](auto const&) {});
+
+    auto result = animation.init();
+    ASSERT_TRUE(result.position);
+    ASSERT_TRUE(result.size);
+    EXPECT_EQ(result.position.value(), glm::vec2(600, 0));
+    EXPECT_EQ(result.size.value(), glm::vec2(400, 100));
+
+    result = animation.step(0.5f);
+    EXPECT_FALSE(result.position);
+    EXPECT_FALSE(result.size);
+    ASSERT_TRUE(result.transform);
+
+    // The transform is applied around the centre of the window at its final rectangle
+    glm::vec4 const centre(800, 50, 0, 0);
+    auto const top_left = result.transform.value() * glm::vec4(-200, -50, 0, 1) + centre;
+    auto const bottom_right = result.transform.value() * glm::vec4(200, 50, 0, 1) + centre;
+    EXPECT_NEAR(top_left.x, 300, 0.01);
+    EXPECT_NEAR(top_left.y, 0, 0.01);
+    EXPECT_NEAR(bottom_right.x - top_left.x, 300, 0.01);
+    EXPECT_NEAR(bottom_right.y - top_left.y, 100, 0.01);
+}
+
+TEST_F(AnimationTest, FadeReducesAlphaUntilComplete)
+{
+    AnimationDefinition definition;
+    definition.duration_seconds = 1;
+    definition.type = AnimationType::fade;
+    definition.function = EaseFunction::linear;
+    Animation animation(0, definition, std::nullopt, std::nullopt, std::nullopt, [](auto const&) {});
+
+    auto result = animation.init();
+    ASSERT_TRUE(result.alpha);
+    EXPECT_FLOAT_EQ(result.alpha.value(), 1.f);
+
+    result = animation.step(0.25f);
+    ASSERT_TRUE(result.alpha);
+    EXPECT_NEAR(result.alpha.value(), 0.75f, 0.001);
+
+    result = animation.step(1.f);
+    EXPECT_TRUE(result.is_complete);
+}
+
+TEST_F(AnimationTest, SpringSettlesAtItsTarget)
+{
+    AnimationDefinition definition;
+    definition.type = AnimationType::spring;
+    definition.stiffness = 400;
+
+    AnimationStore store;
+    std::vector<AnimationStore::Update> updates;
+    store.insert(Animation(1, definition, rect_at(0, 0), rect_at(600, 0), rect_at(0, 0), [](auto const&) {}));
+
+    float elapsed = 0;
+    while (store.size() > 0)
+    {
+        ASSERT_LT(elapsed, 10.f);
+        updates.clear();
+        store.step(1.f / 60.f, updates);
+        elapsed += 1.f / 60.f;
+    }
+
+    ASSERT_EQ(updates.size(), 1);
+    EXPECT_TRUE(updates[0].result.is_complete);
+    ASSERT_TRUE(updates[0].result.position);
+    EXPECT_NEAR(updates[0].result.position.value().x, 600, 0.01);
+}
+
+TEST_F(AnimationTest, RetargetingSpringKeepsPositionAndVelocityContinuous)
+{
+    AnimationDefinition definition;
+    definition.type = AnimationType::spring;
+    definition.stiffness = 400;
+
+    AnimationStore store;
+    std::vector<AnimationStore::Update> updates;
+    auto const step = [&](float dt)
+    {
+        updates.clear();
+        store.step(dt, updates);
+        EXPECT_EQ(updates.size(), 1);
+        EXPECT_TRUE(updates[0].result.position);
+        return updates[0].result.position.value().x;
+    };
+
+    store.insert(Animation(1, definition, rect_at(0, 0), rect_at(600, 0), rect_at(0, 0), [](auto const&) {}));
+    constexpr float dt = 0.0001f;
+    step(0.1f - dt);
+    float const before = step(dt);
+    float const x = step(dt);
+    float const velocity_before = (x - before) / dt;
+
+    // Retarget back to the start while the window is moving quickly towards the old target
+    store.insert(Animation(1, definition, rect_at(600, 0), rect_at(0, 0), rect_at(600, 0), [](auto const&) {}));
+    EXPECT_EQ(store.size(), 1);
+
+    float const after = step(dt);
+    float const velocity_after = (after - x) / dt;
+
+    EXPECT_NEAR(after, x, 1);
+    EXPECT_GT(velocity_before, 1000);
+    EXPECT_NEAR(velocity_after, velocity_before, 0.05f * velocity_before);
+}
+
+TEST_F(AnimationTest, FinishCompletesEveryAnimation)
+{
+    AnimationDefinition definition;
+    definition.duration_seconds = 1;
+    definition.type = AnimationType::slide;
+    definition.function = EaseFunction::linear;
+
+    AnimationStore store;
+    std::vector<AnimationStore::Update> updates;
+    store.insert(Animation(1, definition, rect_at(0, 0), rect_at(600, 0), rect_at(0, 0), [](auto const&) {}));
+    store.insert(Animation(2, definition, rect_at(0, 0), rect_at(0, 600), rect_at(0, 0), [](auto const&) {}));
+    store.finish(updates);
+
+    EXPECT_TRUE(store.empty());
+    ASSERT_EQ(updates.size(), 2);
+    for (auto const& update : updates)
+        EXPECT_TRUE(update.result.is_complete);
+    EXPECT_EQ(updates[0].result.position.value().x, 600);
+    EXPECT_EQ(updates[1].result.position.value().y, 600);
+}
@@ -0,0 +1,102 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "auto_layout.h"
+#include "rectangle_helpers.h"
+#include <gtest/gtest.h>
+#include <random>
+
+using namespace miracle;
+using namespace miracle::test;
+
+class AutoLayoutTest : public testing::TestWithParam<AutoLayout>
+{
+};
+
+TEST_P(AutoLayoutTest, areas_tile_the_whole_area_without_overlap)
+{
+    std::mt19937 rng(7);
+    geom::Rectangle const area { geom::Point { 13, 29 }, geom::Size { 1917, 1043 } };
+    for (size_t count = 1; count <= 40; count++)
+    {
+        std::vector<double> weights(count);
+        double total = 0;
+        for (auto& weight : weights)
+            total += weight = std::uniform_real_distribution<double>(0.5, 1.5)(rng);
+        for (auto& weight : weights)
+            weight /= total;
+
+        auto const areas = compute_auto_layout(GetParam(), area, weights);
+        ASSERT_EQ(areas.size(), count);
+
+        long covered = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            EXPECT_GE(areas[i].top_left.x.as_int(), area.top_left.x.as_int());
+            EXPECT_GE(areas[i].top_left.y.as_int(), area.top_left.y.as_int());
+            EXPECT_LE(right(areas[i]), right(area));
+            EXPECT_LE(bottom(areas[i]), bottom(area));
+            covered += (long)areas[i].size.width.as_int() * areas[i].size.height.as_int();
+            for (size_t j = 0; j < i; j++)
+                EXPECT_FALSE(overlaps(areas[i], areas[j])) << "count=" << count << " i=" << i << " j=" << j;
+        }
+        EXPECT_EQ(covered, (long)area.size.width.as_int() * area.size.height.as_int()) << "count=" << count;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    AutoLayouts,
+    AutoLayoutTest,
+    testing::Values(AutoLayout::master_stack, AutoLayout::spiral, AutoLayout::grid),
+    [](testing::TestParamInfo<AutoLayout> const& info) { return std::string(to_string(info.param)); });
+
+TEST(AutoLayout, master_stack_gives_the_master_half_of_the_width_by_default)
+{
+    auto const areas = compute_auto_layout(
+        AutoLayout::master_stack, { geom::Point { 0, 0 }, geom::Size { 1000, 600 } }, { 0.25, 0.25, 0.25, 0.25 });
+    EXPECT_EQ(areas[0], geom::Rectangle(geom::Point(0, 0), geom::Size(500, 600)));
+    EXPECT_EQ(areas[1], geom::Rectangle(geom::Point(500, 0), geom::Size(500, 200)));
+    EXPECT_EQ(areas[2], geom::Rectangle(geom::Point(500, 200), geom::Size(500, 200)));
+    EXPECT_EQ(areas[3], geom::Rectangle(geom::Point(500, 400), geom::Size(500, 200)));
+}
+
+TEST(AutoLayout, spiral_halves_the_remaining_space_turning_clockwise)
+{
+    auto const areas = compute_auto_layout(
+        AutoLayout::spiral, { geom::Point { 0, 0 }, geom::Size { 800, 800 } }, { 0.25, 0.25, 0.25, 0.25 });
+    EXPECT_EQ(areas[0], geom::Rectangle(geom::Point(0, 0), geom::Size(400, 800)));
+    EXPECT_EQ(areas[1], geom::Rectangle(geom::Point(400, 0), geom::Size(400, 400)));
+    EXPECT_EQ(areas[2], geom::Rectangle(geom::Point(600, 400), geom::Size(200, 400)));
+    EXPECT_EQ(areas[3], geom::Rectangle(geom::Point(400, 400), geom::Size(200, 400)));
+}
+
+TEST(AutoLayout, grid_stretches_the_last_row)
+{
+    std::vector<double> const weights(5, 0.2);
+    auto const areas = compute_auto_layout(AutoLayout::grid, { geom::Point { 0, 0 }, geom::Size { 900, 600 } }, weights);
+    EXPECT_EQ(areas[0], geom::Rectangle(geom::Point(0, 0), geom::Size(300, 300)));
+    EXPECT_EQ(areas[2], geom::Rectangle(geom::Point(600, 0), geom::Size(300, 300)));
+    EXPECT_EQ(areas[3], geom::Rectangle(geom::Point(0, 300), geom::Size(450, 300)));
+    EXPECT_EQ(areas[4], geom::Rectangle(geom::Point(450, 300), geom::Size(450, 300)));
+}
+
+TEST(AutoLayout, parses_every_layout_name)
+{
+    for (auto layout : { AutoLayout::none, AutoLayout::master_stack, AutoLayout::spiral, AutoLayout::grid })
+        EXPECT_EQ(auto_layout_from_string(to_string(layout)), layout);
+    EXPECT_EQ(auto_layout_from_string("dwindle"), std::nullopt);
+}
@@ -0,0 +1,140 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "animation_defintion.h"
+#include "easing.h"
+#include <cmath>
+#include <gtest/gtest.h>
+
+using namespace miracle;
+
+namespace
+{
+/// The largest difference that a table may have from the exact function that it was built from.
+float error_bound(EaseFunction function)
+{
+    switch (function)
+    {
+    // These jump by 2^-10 between t = 0 and the next value (or between the last value and t = 1),
+    // which the table interpolates over.
+    case EaseFunction::ease_in_expo:
+    case EaseFunction::ease_out_expo:
+    case EaseFunction::ease_in_out_expo:
+    case EaseFunction::ease_in_elastic:
+    case EaseFunction::ease_out_elastic:
+    case EaseFunction::ease_in_out_elastic:
+        return 1e-3f;
+    // The bounces have sharp corners where the curve touches 1
+    case EaseFunction::ease_in_bounce:
+    case EaseFunction::ease_out_bounce:
+    case EaseFunction::ease_in_out_bounce:
+        return 2.5e-3f;
+    default:
+        return 1e-4f;
+    }
+}
+}
+
+class EaseTableTest : public testing::TestWithParam<EaseFunction>
+{
+public:
+    EaseTableTest()
+    {
+        definition.function = GetParam();
+        table = make_ease_table(definition);
+    }
+
+    AnimationDefinition definition;
+    std::shared_ptr<EaseTable const> table;
+};
+
+TEST_P(EaseTableTest, StaysWithinErrorBoundOfExactFunction)
+{
+    ASSERT_NE(table, nullptr);
+
+    // Sample far more densely than the table so that the middle of every interval is checked
+    constexpr int num_samples = EaseTable::num_intervals * 64;
+    float max_error = 0.f;
+    for (int i = 0; i <= num_samples; i++)
+    {
+        float const t = static_cast<float>(i) / num_samples;
+        max_error = std::max(max_error, std::abs(table->evaluate(t) - ease_exact(definition, t)));
+    }
+
+    EXPECT_LE(max_error, error_bound(GetParam()));
+}
+
+TEST_P(EaseTableTest, EndpointsMatchExactFunction)
+{
+    ASSERT_NE(table, nullptr);
+    EXPECT_FLOAT_EQ(table->evaluate(0.f), ease_exact(definition, 0.f));
+    EXPECT_FLOAT_EQ(table->evaluate(1.f), ease_exact(definition, 1.f));
+}
+
+TEST_P(EaseTableTest, ClampsValuesOutsideOfTheUnitInterval)
+{
+    ASSERT_NE(table, nullptr);
+    EXPECT_FLOAT_EQ(table->evaluate(-0.5f), table->evaluate(0.f));
+    EXPECT_FLOAT_EQ(table->evaluate(1.5f), table->evaluate(1.f));
+}
+
+TEST_P(EaseTableTest, BatchMatchesSingleEvaluation)
+{
+    ASSERT_NE(table, nullptr);
+    std::vector<float> t;
+    for (int i = 0; i <= 100; i++)
+        t.push_back(static_cast<float>(i) / 100.f);
+
+    std::vector<float> out(t.size());
+    table->evaluate(t.data(), out.data(), t.size());
+    for (size_t i = 0; i < t.size(); i++)
+        EXPECT_EQ(out[i], table->evaluate(t[i]));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    TabulatedFunctions,
+    EaseTableTest,
+    testing::Values(
+        EaseFunction::ease_in_sine,
+        EaseFunction::ease_out_sine,
+        EaseFunction::ease_in_out_sine,
+        EaseFunction::ease_out_cubic,
+        EaseFunction::ease_in_out_cubic,
+        EaseFunction::ease_out_quart,
+        EaseFunction::ease_in_out_quart,
+        EaseFunction::ease_out_quint,
+        EaseFunction::ease_in_out_quint,
+        EaseFunction::ease_in_expo,
+        EaseFunction::ease_out_expo,
+        EaseFunction::ease_in_out_expo,
+        EaseFunction::ease_out_back,
+        EaseFunction::ease_in_elastic,
+        EaseFunction::ease_out_elastic,
+        EaseFunction::ease_in_out_elastic,
+        EaseFunction::ease_in_bounce,
+        EaseFunction::ease_out_bounce,
+        EaseFunction::ease_in_out_bounce));
+
+TEST(EaseTableTest, CheapFunctionsAreNotTabulated)
+{
+    for (auto function : { EaseFunction::linear, EaseFunction::ease_in_quad, EaseFunction::ease_in_circ, EaseFunction::ease_in_back })
+    {
+        AnimationDefinition definition;
+        definition.function = function;
+        EXPECT_EQ(make_ease_table(definition), nullptr);
+    }
+}
@@ -0,0 +1,119 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "frame_clock.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace miracle;
+using namespace std::chrono_literals;
+
+namespace geom = mir::geometry;
+
+namespace
+{
+geom::Rectangle const output_area { geom::Point(0, 0), geom::Size(1920, 1080) };
+}
+
+TEST(FrameClockTest, FramesAreReportedWithTheRefreshPeriodOfTheirOutput)
+{
+    FrameClock clock;
+    clock.set_refresh_rate(output_area, 60);
+    std::vector<FrameClock::Frame> frames;
+    clock.set_listener([&](FrameClock::Frame const& frame)
+    { frames.push_back(frame); });
+
+    int const source = 0;
+    clock.advise_frame(&source, output_area, FrameClock::clock::time_point(1s));
+
+    ASSERT_EQ(frames.size(), 1);
+    EXPECT_EQ(frames[0].source, &source);
+    ASSERT_TRUE(frames[0].refresh_period);
+    auto const refresh_period_ms = std::chrono::duration<double, std::milli>(frames[0].refresh_period.value()).count();
+    EXPECT_NEAR(refresh_period_ms, 16.667, 0.01);
+}
+
+TEST(FrameClockTest, FramesOnUnknownOutputsHaveNoRefreshPeriod)
+{
+    FrameClock clock;
+    std::vector<FrameClock::Frame> frames;
+    clock.set_listener([&](FrameClock::Frame const& frame)
+    { frames.push_back(frame); });
+
+    int const source = 0;
+    clock.advise_frame(&source, output_area, FrameClock::clock::time_point(1s));
+
+    ASSERT_EQ(frames.size(), 1);
+    EXPECT_FALSE(frames[0].refresh_period);
+}
+
+TEST(FrameClockTest, LateRenderStartsAreSnappedToTheVblank)
+{
+    FrameClock clock;
+    clock.set_refresh_rate(output_area, 50);
+    std::vector<FrameClock::Frame> frames;
+    clock.set_listener([&](FrameClock::Frame const& frame)
+    { frames.push_back(frame); });
+
+    int const source = 0;
+    auto const start = FrameClock::clock::time_point(1s);
+    clock.advise_frame(&source, output_area, start);
+    clock.advise_frame(&source, output_area, start + 20ms + 3ms);
+    clock.advise_frame(&source, output_area, start + 60ms + 1ms);
+
+    ASSERT_EQ(frames.size(), 3);
+    EXPECT_EQ(frames[1].time, start + 20ms);
+    EXPECT_EQ(frames[2].time, start + 60ms);
+}
+
+TEST(FrameClockTest, EarlierRenderStartsResynchronizeTheVblank)
+{
+    FrameClock clock;
+    clock.set_refresh_rate(output_area, 50);
+    std::vector<FrameClock::Frame> frames;
+    clock.set_listener([&](FrameClock::Frame const& frame)
+    { frames.push_back(frame); });
+
+    int const source = 0;
+    auto const start = FrameClock::clock::time_point(1s);
+    clock.advise_frame(&source, output_area, start + 5ms);
+    clock.advise_frame(&source, output_area, start + 20ms + 1ms);
+
+    ASSERT_EQ(frames.size(), 2);
+    EXPECT_EQ(frames[1].time, start + 20ms + 1ms);
+}
+
+TEST(FrameClockTest, ListenerIsCalledWithoutTheLock)
+{
+    FrameClock clock;
+    int const source = 0;
+    int const other_source = 0;
+    int num_frames = 0;
+    clock.set_listener([&](FrameClock::Frame const& frame)
+    {
+        // A renderer on another output reporting a frame must not block on this one
+        if (num_frames++ == 0)
+            clock.advise_frame(&other_source, output_area, frame.time);
+    });
+
+    clock.advise_frame(&source, output_area, FrameClock::clock::time_point(1s));
+    EXPECT_EQ(num_frames, 2);
+
+    clock.clear_listener();
+    clock.advise_frame(&source, output_area, FrameClock::clock::time_point(2s));
+    EXPECT_EQ(num_frames, 2);
+}
@@ -0,0 +1,165 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "render_statistics.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+
+namespace
+{
+FrameTimings frame_at(std::chrono::steady_clock::time_point start)
+{
+    return {
+        .frame_start = start,
+        .cpu_time = std::chrono::milliseconds(2),
+        .commit_time = std::chrono::milliseconds(1),
+        .num_renderables = 3,
+        .num_draw_calls = 3
+    };
+}
+
+/// A frame drawn for pending damage right on the vblank at [start], which is due by the next vblank
+FrameTimings damaged_frame_at(std::chrono::steady_clock::time_point start, std::chrono::nanoseconds period)
+{
+    auto frame = frame_at(start);
+    frame.refresh_period = period;
+    frame.deadline = start + period;
+    return frame;
+}
+}
+
+TEST(RollingSamplesTest, ReportsPercentilesOfTheWindow)
+{
+    RollingSamples samples(100);
+    for (int i = 1; i <= 100; i++)
+        samples.push(static_cast<float>(i));
+
+    EXPECT_FLOAT_EQ(samples.min(), 1.f);
+    EXPECT_FLOAT_EQ(samples.max(), 100.f);
+    EXPECT_FLOAT_EQ(samples.mean(), 50.5f);
+    EXPECT_FLOAT_EQ(samples.percentile(0.5f), 50.f);
+    EXPECT_FLOAT_EQ(samples.percentile(0.99f), 99.f);
+}
+
+TEST(RollingSamplesTest, OldestSamplesAreReplacedOnceFull)
+{
+    RollingSamples samples(4);
+    for (int i = 0; i < 8; i++)
+        samples.push(static_cast<float>(i));
+
+    EXPECT_EQ(samples.size(), 4);
+    EXPECT_FLOAT_EQ(samples.min(), 4.f);
+    EXPECT_FLOAT_EQ(samples.max(), 7.f);
+}
+
+TEST(RollingSamplesTest, HistogramCountsEverySample)
+{
+    RollingSamples samples(10);
+    samples.push(0.5f);
+    samples.push(3.f);
+    samples.push(200.f);
+
+    auto json = samples.to_json({ 1.f, 4.f });
+    ASSERT_EQ(json["histogram"].size(), 3);
+    EXPECT_EQ(json["histogram"][0]["count"], 1);
+    EXPECT_EQ(json["histogram"][1]["count"], 1);
+    EXPECT_EQ(json["histogram"][2]["count"], 1);
+}
+
+TEST(OutputRenderStatisticsTest, FramesOnTimeAreNotMissed)
+{
+    OutputRenderStatistics stats;
+    auto now = std::chrono::steady_clock::now();
+    auto const period = std::chrono::microseconds(16667);
+    for (int i = 0; i < 10; i++)
+        stats.record_frame(damaged_frame_at(now + i * period, period));
+
+    EXPECT_EQ(stats.get_missed_frames(), 0);
+    ASSERT_TRUE(stats.get_refresh_period_ms());
+    EXPECT_NEAR(stats.get_refresh_period_ms().value(), 16.667f, 0.01f);
+    EXPECT_NEAR(stats.to_json()["refresh_rate"].get<float>(), 60.f, 0.01f);
+}
+
+TEST(OutputRenderStatisticsTest, RefreshPeriodIsEstimatedWhenNotReported)
+{
+    OutputRenderStatistics stats;
+    auto now = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; i++)
+        stats.record_frame(frame_at(now + i * std::chrono::microseconds(16667)));
+
+    ASSERT_TRUE(stats.get_refresh_period_ms());
+    EXPECT_NEAR(stats.get_refresh_period_ms().value(), 16.667f, 0.01f);
+    EXPECT_NEAR(stats.to_json()["estimated_refresh_rate"].get<float>(), 60.f, 0.01f);
+}
+
+TEST(OutputRenderStatisticsTest, SlowDamageSourceIsNotCountedAsMissed)
+{
+    OutputRenderStatistics stats;
+    auto now = std::chrono::steady_clock::now();
+    auto const period = std::chrono::microseconds(16667);
+
+    // A 30Hz video on a 60Hz output only damages every other vblank, but each of its frames is on time
+    for (int i = 0; i < 30; i++)
+        stats.record_frame(damaged_frame_at(now + i * 2 * period, period));
+
+    EXPECT_EQ(stats.get_missed_frames(), 0);
+}
+
+TEST(OutputRenderStatisticsTest, FramesCommittedAfterTheirDeadlineAreCountedAsMissed)
+{
+    OutputRenderStatistics stats;
+    auto now = std::chrono::steady_clock::now();
+    auto const period = std::chrono::microseconds(16667);
+    stats.record_frame(damaged_frame_at(now, period));
+
+    // Committed just after the deadline, so it is shown one vblank late
+    auto late = damaged_frame_at(now + period, period);
+    late.cpu_time = period + std::chrono::milliseconds(1);
+    stats.record_frame(late);
+    EXPECT_EQ(stats.get_missed_frames(), 1);
+
+    // Committed more than a whole period after the deadline, so it is shown two vblanks late
+    auto very_late = damaged_frame_at(now + 3 * period, period);
+    very_late.cpu_time = 2 * period + std::chrono::milliseconds(1);
+    stats.record_frame(very_late);
+    EXPECT_EQ(stats.get_missed_frames(), 3);
+}
+
+TEST(OutputRenderStatisticsTest, FramesWithoutADeadlineAreNeverMissed)
+{
+    OutputRenderStatistics stats;
+    auto now = std::chrono::steady_clock::now();
+    auto const period = std::chrono::microseconds(16667);
+    stats.record_frame(frame_at(now));
+    stats.record_frame(frame_at(now + period));
+    stats.record_frame(frame_at(now + 5 * period));
+    stats.record_frame(frame_at(now + 5 * period + std::chrono::seconds(2)));
+
+    EXPECT_EQ(stats.get_missed_frames(), 0);
+}
+
+TEST(RenderStatisticsTest, OutputsAreDroppedWhenTheRendererGoesAway)
+{
+    RenderStatistics statistics;
+    auto first = statistics.register_output();
+    auto second = statistics.register_output();
+    EXPECT_EQ(statistics.get_outputs().size(), 2);
+
+    first.reset();
+    EXPECT_EQ(statistics.get_outputs().size(), 1);
+}
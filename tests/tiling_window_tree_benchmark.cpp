@@ -0,0 +1,188 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "compositor_state.h"
+#include "leaf_container.h"
+#include "parent_container.h"
+#include "spatial_index.h"
+#include "stub_configuration.h"
+#include "stub_tiling_window_tree_interface.h"
+#include "tiling_window_tree.h"
+#include "window_factory.h"
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <random>
+
+using namespace miracle;
+
+namespace
+{
+geom::Rectangle const area {
+    geom::Point(0, 0),
+    geom::Size(1 << 23, 1 << 23)
+};
+constexpr int tree_depth = 6;
+constexpr int num_leaves = 100;
+constexpr int resizes_per_run = 10000;
+constexpr int hit_test_columns = 10;
+constexpr int hit_test_rows = 20;
+constexpr int hit_tests_per_run = 1000000;
+}
+
+class TilingWindowTreeBenchmark : public testing::Test
+{
+public:
+    TilingWindowTreeBenchmark() :
+        tree(
+            std::make_unique<test::StubTilingWindowTreeInterface>(area),
+            windows.window_controller,
+            state,
+            std::make_shared<test::StubConfiguration>(),
+            area)
+    {
+    }
+
+    std::shared_ptr<LeafContainer> create_leaf(std::shared_ptr<ParentContainer> const& parent)
+    {
+        auto leaf = windows.create_leaf(tree, parent);
+        state.active = leaf;
+        return leaf;
+    }
+
+    /// Builds a tree that alternates between horizontal and vertical lanes for [tree_depth]
+    /// levels, spreading [num_leaves] evenly across them. Returns a leaf in the deepest lane.
+    std::shared_ptr<LeafContainer> create_nested_tree()
+    {
+        auto lane = tree.get_root();
+        auto leaf = create_leaf(lane);
+        int created = 1;
+        for (int level = 0; level < tree_depth; level++)
+        {
+            int const leaves_in_level = level == tree_depth - 1
+                ? num_leaves - created
+                : num_leaves / tree_depth - 1;
+            for (int i = 0; i < leaves_in_level; i++, created++)
+                leaf = create_leaf(lane);
+
+            if (level == tree_depth - 1)
+                break;
+
+            if (lane->get_scheme() == LayoutScheme::horizontal)
+                tree.request_vertical_layout(*leaf);
+            else
+                tree.request_horizontal_layout(*leaf);
+            lane = Container::as_parent(leaf->get_parent().lock());
+        }
+
+        return leaf;
+    }
+
+    CompositorState state;
+    test::WindowFactory windows;
+    TilingWindowTree tree;
+};
+
+TEST_F(TilingWindowTreeBenchmark, ResizeInDeeplyNestedTree)
+{
+    // Resize each container on the path from the deepest leaf up to the root, so that
+    // the siblings being checked against their minimum size include whole subtrees
+    std::vector<std::shared_ptr<Container>> path;
+    for (std::shared_ptr<Container> node = create_nested_tree(); node->get_parent().lock(); node = node->get_parent().lock())
+        path.push_back(node);
+    ASSERT_EQ(path.size(), static_cast<size_t>(tree_depth));
+
+    auto const start = std::chrono::steady_clock::now();
+    int succeeded = 0;
+    for (int i = 0; i < resizes_per_run; i++)
+    {
+        auto const& node = path[(i / 2) % path.size()];
+        if (node->get_parent().lock()->resize_node(*node, i % 2 == 0 ? 10 : -10))
+            succeeded++;
+    }
+    auto const elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(succeeded, resizes_per_run);
+
+    auto const us_per_resize = elapsed_us / resizes_per_run;
+    std::cout << "leaves: " << num_leaves << ", depth: " << tree_depth
+              << ", resize: " << us_per_resize << "us" << std::endl;
+    RecordProperty("us_per_resize", std::to_string(us_per_resize));
+}
+
+TEST_F(TilingWindowTreeBenchmark, HitTestWith200Windows)
+{
+    std::vector<std::shared_ptr<LeafContainer>> columns;
+    for (int i = 0; i < hit_test_columns; i++)
+        columns.push_back(create_leaf(tree.get_root()));
+
+    for (auto const& column : columns)
+    {
+        tree.request_vertical_layout(*column);
+        auto const lane = Container::as_parent(column->get_parent().lock());
+        for (int i = 1; i < hit_test_rows; i++)
+            create_leaf(lane);
+    }
+
+    std::vector<SpatialIndex::Entry> entries;
+    tree.foreach_node([&](std::shared_ptr<Container> const& node)
+    {
+        if (node->is_leaf())
+            entries.push_back({ node->get_logical_area(), node });
+    });
+    ASSERT_EQ(entries.size(), static_cast<size_t>(hit_test_columns * hit_test_rows));
+
+    SpatialIndex index;
+    index.rebuild(tree.get_area(), entries);
+
+    std::mt19937 rng(42);
+    std::vector<geom::Point> points;
+    for (int i = 0; i < 4096; i++)
+        points.push_back({ (int)(rng() % area.size.width.as_int()), (int)(rng() % area.size.height.as_int()) });
+
+    for (auto const& point : points)
+        ASSERT_EQ(index.at(point), tree.select_window_from_point(point.x.as_int(), point.y.as_int()));
+
+    auto const time_hit_tests = [&](auto const& hit_test)
+    {
+        size_t found = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (int i = 0; i < hit_tests_per_run; i++)
+        {
+            if (hit_test(points[i % points.size()]))
+                found++;
+        }
+        auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        EXPECT_EQ(found, static_cast<size_t>(hit_tests_per_run));
+        return hit_tests_per_run / elapsed;
+    };
+
+    auto const tree_per_second = time_hit_tests([&](geom::Point const& point)
+    {
+        return tree.select_window_from_point(point.x.as_int(), point.y.as_int()) != nullptr;
+    });
+    auto const index_per_second = time_hit_tests([&](geom::Point const& point)
+    {
+        return index.at(point) != nullptr;
+    });
+
+    std::cout << "windows: " << entries.size()
+              << ", tree: " << tree_per_second << " hit tests/s"
+              << ", index: " << index_per_second << " hit tests/s" << std::endl;
+    RecordProperty("tree_hit_tests_per_second", std::to_string(tree_per_second));
+    RecordProperty("index_hit_tests_per_second", std::to_string(index_per_second));
+}
@@ -0,0 +1,69 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "tiling_window_tree_fuzzer.h"
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <iostream>
+
+using namespace miracle;
+
+namespace
+{
+/// Large enough that a thousand windows never run into their minimum size
+geom::Rectangle const area {
+    geom::Point(0, 0),
+    geom::Size(1 << 20, 1 << 20)
+};
+constexpr int operations_per_run = 20000;
+}
+
+class TilingWindowTreeFuzzBenchmark : public testing::TestWithParam<size_t>
+{
+};
+
+TEST_P(TilingWindowTreeFuzzBenchmark, RandomOperations)
+{
+    auto const leaves = GetParam();
+    test::TilingWindowTreeFuzzer fuzzer(42, area);
+    fuzzer.set_resize_checks_enabled(false);
+    fuzzer.populate(leaves);
+
+    auto const modifications_before = fuzzer.num_window_modifications();
+    auto const start = std::chrono::steady_clock::now();
+    for (int i = 0; i < operations_per_run; i++)
+        fuzzer.step(leaves);
+    auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    auto const modifications = fuzzer.num_window_modifications() - modifications_before;
+
+    auto const violations = fuzzer.check_invariants();
+    EXPECT_TRUE(violations.empty()) << violations.front();
+
+    auto const operations_per_second = operations_per_run / elapsed;
+    auto const modifications_per_operation = (double)modifications / operations_per_run;
+    std::cout << "leaves: " << leaves
+              << ", operations/s: " << operations_per_second
+              << ", window modifications/operation: " << modifications_per_operation << std::endl;
+    RecordProperty("operations_per_second", std::to_string(operations_per_second));
+    RecordProperty("modifications_per_operation", std::to_string(modifications_per_operation));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Leaves,
+    TilingWindowTreeFuzzBenchmark,
+    testing::Values(10, 100, 1000));
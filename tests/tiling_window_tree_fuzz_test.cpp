@@ -0,0 +1,53 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "tiling_window_tree_fuzzer.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+
+namespace
+{
+geom::Rectangle const area {
+    geom::Point(0, 0),
+    geom::Size(1280, 720)
+};
+constexpr int steps_per_seed = 2000;
+constexpr size_t target_leaves = 12;
+}
+
+class TilingWindowTreeFuzzTest : public testing::TestWithParam<uint32_t>
+{
+};
+
+TEST_P(TilingWindowTreeFuzzTest, invariants_hold_after_every_operation)
+{
+    test::TilingWindowTreeFuzzer fuzzer(GetParam(), area);
+    for (int step = 0; step < steps_per_seed; step++)
+    {
+        auto const operation = fuzzer.step(target_leaves);
+        auto const violations = fuzzer.check_invariants();
+        ASSERT_TRUE(violations.empty())
+            << "seed " << GetParam() << ", step " << step
+            << " (" << test::TilingWindowTreeFuzzer::to_string(operation) << "): " << violations.front();
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Seeds,
+    TilingWindowTreeFuzzTest,
+    testing::Range(0u, 16u));
@@ -0,0 +1,509 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_TILING_WINDOW_TREE_FUZZER_H
+#define MIRACLE_WM_TILING_WINDOW_TREE_FUZZER_H
+
+#include "compositor_state.h"
+#include "leaf_container.h"
+#include "parent_container.h"
+#include "rectangle_helpers.h"
+#include "stub_configuration.h"
+#include "stub_tiling_window_tree_interface.h"
+#include "tiling_window_tree.h"
+#include "window_factory.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace miracle::test
+{
+/// Drives a [TilingWindowTree] with a random, reproducible sequence of the operations
+/// that a user can perform, and checks that the tree stays consistent after each one.
+/// A second tree stands in for another workspace that windows are moved to and from.
+class TilingWindowTreeFuzzer
+{
+public:
+    enum class Operation
+    {
+        insert,
+        remove,
+        move,
+        resize,
+        toggle_layout,
+        fullscreen,
+        graft,
+        auto_layout,
+        move_to_other_tree,
+        set_area
+    };
+
+    TilingWindowTreeFuzzer(uint32_t seed, geom::Rectangle const& area) :
+        initial_area { area },
+        area { area },
+        other_area { geom::Point(right(area), area.top_left.y), area.size },
+        rng { seed },
+        tree(
+            std::make_unique<StubTilingWindowTreeInterface>(area),
+            windows.window_controller,
+            state,
+            config,
+            area),
+        other_tree(
+            std::make_unique<StubTilingWindowTreeInterface>(other_area),
+            windows.window_controller,
+            state,
+            config,
+            other_area)
+    {
+    }
+
+    /// Inserts windows until the tree holds [count] of them.
+    void populate(size_t count)
+    {
+        while (leaves.size() < count)
+            insert();
+    }
+
+    /// Performs one random operation. Inserts and removals are weighted so that the
+    /// number of windows drifts towards [target_leaves].
+    Operation step(size_t target_leaves)
+    {
+        auto const operation = pick_operation(target_leaves);
+        switch (operation)
+        {
+        case Operation::insert:
+            insert();
+            break;
+        case Operation::remove:
+            remove(random_leaf());
+            break;
+        case Operation::move:
+            move(random_leaf());
+            break;
+        case Operation::resize:
+            resize(random_leaf());
+            break;
+        case Operation::toggle_layout:
+            toggle_layout(random_leaf());
+            break;
+        case Operation::fullscreen:
+            toggle_fullscreen(random_leaf());
+            break;
+        case Operation::graft:
+            graft(random_leaf());
+            break;
+        case Operation::auto_layout:
+            set_auto_layout();
+            break;
+        case Operation::move_to_other_tree:
+            move_to_other_tree();
+            break;
+        case Operation::set_area:
+            set_area();
+            break;
+        }
+
+        return operation;
+    }
+
+    /// Returns a description of every broken invariant, or an empty list if there are none.
+    [[nodiscard]] std::vector<std::string> check_invariants()
+    {
+        std::vector<std::string> violations = std::move(resize_violations);
+        resize_violations.clear();
+
+        check_tree(tree, area, leaves.size(), violations);
+        check_tree(other_tree, other_area, other_leaves.size(), violations);
+        return violations;
+    }
+
+    static const char* to_string(Operation operation)
+    {
+        switch (operation)
+        {
+        case Operation::insert:
+            return "insert";
+        case Operation::remove:
+            return "remove";
+        case Operation::move:
+            return "move";
+        case Operation::resize:
+            return "resize";
+        case Operation::toggle_layout:
+            return "toggle_layout";
+        case Operation::fullscreen:
+            return "fullscreen";
+        case Operation::graft:
+            return "graft";
+        case Operation::auto_layout:
+            return "auto_layout";
+        case Operation::move_to_other_tree:
+            return "move_to_other_tree";
+        default:
+            return "set_area";
+        }
+    }
+
+    /// Resizes snapshot the whole tree to verify them, which a benchmark may want to skip.
+    void set_resize_checks_enabled(bool enabled) { resize_checks_enabled = enabled; }
+
+    [[nodiscard]] size_t num_leaves() const { return leaves.size(); }
+    [[nodiscard]] size_t num_window_modifications() const { return windows.window_controller.modifications; }
+
+private:
+    class FuzzConfiguration : public StubConfiguration
+    {
+    public:
+        FuzzConfiguration()
+        {
+            // Gaps make the visible area of a window differ from its logical area
+            inner_gaps_x = 10;
+            inner_gaps_y = 6;
+        }
+
+        [[nodiscard]] int get_resize_jump() const override { return 50; }
+    };
+
+    /// The minimum size of a lane, as computed from scratch rather than from its cache
+    struct MinSize
+    {
+        size_t width = 0;
+        size_t height = 0;
+    };
+
+    /// Windows moved to the other tree are moved back once it holds this many
+    static constexpr size_t max_other_leaves = 4;
+
+    geom::Rectangle initial_area;
+    geom::Rectangle area;
+    geom::Rectangle other_area;
+    std::mt19937 rng;
+    CompositorState state;
+    WindowFactory windows;
+    std::shared_ptr<FuzzConfiguration> config = std::make_shared<FuzzConfiguration>();
+    TilingWindowTree tree;
+    TilingWindowTree other_tree;
+    std::vector<std::shared_ptr<LeafContainer>> leaves;
+    std::vector<std::shared_ptr<LeafContainer>> other_leaves;
+    std::shared_ptr<LeafContainer> fullscreen_leaf;
+    std::vector<std::string> resize_violations;
+    bool resize_checks_enabled = true;
+
+    Operation pick_operation(size_t target_leaves)
+    {
+        if (leaves.empty())
+            return Operation::insert;
+
+        // Inserting or removing is as likely as any other operation when at the target
+        int const insert_weight = leaves.size() < target_leaves ? 3 : 1;
+        int const remove_weight = leaves.size() > target_leaves ? 3 : 1;
+        std::discrete_distribution<int> distribution({
+            (double)insert_weight, (double)remove_weight, 1, 1, 1, 0.25, 0.5, 0.25, 0.5, 0.25 });
+        return (Operation)distribution(rng);
+    }
+
+    std::shared_ptr<LeafContainer> random_leaf()
+    {
+        // Focus stays on a fullscreen window, so it is the target of every operation
+        if (fullscreen_leaf)
+            return fullscreen_leaf;
+        return random_leaf_in(leaves);
+    }
+
+    std::shared_ptr<LeafContainer> random_leaf_in(std::vector<std::shared_ptr<LeafContainer>> const& from)
+    {
+        return from[std::uniform_int_distribution<size_t>(0, from.size() - 1)(rng)];
+    }
+
+    Direction random_direction()
+    {
+        return (Direction)std::uniform_int_distribution<int>(0, (int)Direction::MAX - 1)(rng);
+    }
+
+    void insert()
+    {
+        // New windows go next to an existing one, or at the root
+        std::shared_ptr<ParentContainer> parent;
+        if (!leaves.empty() && rng() % 2)
+            parent = random_leaf()->get_parent().lock();
+
+        auto leaf = windows.create_leaf(tree, parent);
+        leaves.push_back(leaf);
+        auto const focused = fullscreen_leaf ? fullscreen_leaf : leaf;
+        state.active = focused;
+        tree.advise_focus_gained(*focused);
+    }
+
+    void remove(std::shared_ptr<LeafContainer> const& leaf)
+    {
+        tree.advise_delete_window(leaf);
+        if (fullscreen_leaf == leaf)
+            fullscreen_leaf = nullptr;
+        if (state.active == leaf)
+            state.active = nullptr;
+
+        std::erase(leaves, leaf);
+        windows.forget(leaf);
+    }
+
+    void move(std::shared_ptr<LeafContainer> const& leaf)
+    {
+        state.active = leaf;
+        tree.move_container(random_direction(), *leaf);
+    }
+
+    void resize(std::shared_ptr<LeafContainer> const& leaf)
+    {
+        state.active = leaf;
+        if (!resize_checks_enabled)
+        {
+            tree.resize_container(random_direction(), *leaf);
+            return;
+        }
+
+        std::map<Container const*, geom::Rectangle> before;
+        tree.foreach_node([&](std::shared_ptr<Container> const& node)
+        {
+            before[node.get()] = node->get_logical_area();
+        });
+
+        tree.resize_container(random_direction(), *leaf);
+
+        // A resize takes space from siblings, but never pushes them below their minimum
+        tree.foreach_node([&](std::shared_ptr<Container> const& node)
+        {
+            auto const lane = Container::as_parent(node);
+            if (!lane || lane->get_logical_area() != before[lane.get()])
+                return;
+
+            bool width_shrank = false;
+            bool height_shrank = false;
+            for (auto const& child : lane->get_sub_nodes())
+            {
+                auto const previous = before[child.get()];
+                width_shrank |= child->get_logical_area().size.width < previous.size.width;
+                height_shrank |= child->get_logical_area().size.height < previous.size.height;
+            }
+
+            for (auto const& child : lane->get_sub_nodes())
+            {
+                auto const size = child->get_logical_area().size;
+                if ((width_shrank && size.width.as_int() <= (int)child->get_min_width())
+                    || (height_shrank && size.height.as_int() <= (int)child->get_min_height()))
+                    resize_violations.push_back("resize shrank a container to its minimum size");
+            }
+        });
+    }
+
+    void toggle_layout(std::shared_ptr<LeafContainer> const& leaf)
+    {
+        state.active = leaf;
+        switch (rng() % 6)
+        {
+        case 0:
+            tree.request_vertical_layout(*leaf);
+            break;
+        case 1:
+            tree.request_horizontal_layout(*leaf);
+            break;
+        case 2:
+            tree.request_tabbing_layout(*leaf);
+            break;
+        case 3:
+            tree.request_stacking_layout(*leaf);
+            break;
+        default:
+            tree.toggle_layout(*leaf, rng() % 2);
+            break;
+        }
+    }
+
+    void toggle_fullscreen(std::shared_ptr<LeafContainer> const& leaf)
+    {
+        state.active = leaf;
+        tree.advise_focus_gained(*leaf);
+        leaf->toggle_fullscreen();
+        fullscreen_leaf = tree.has_fullscreen_window() ? leaf : nullptr;
+    }
+
+    void graft(std::shared_ptr<LeafContainer> const& leaf)
+    {
+        // Take the window out of the tree and put it back, as a move between workspaces does
+        if (fullscreen_leaf)
+            return;
+
+        tree.advise_delete_window(leaf);
+        tree.graft(leaf);
+    }
+
+    void set_auto_layout()
+    {
+        auto const layout = (AutoLayout)std::uniform_int_distribution<int>(0, (int)AutoLayout::grid)(rng);
+        tree.set_auto_layout(layout);
+    }
+
+    void move_to_other_tree()
+    {
+        // A fullscreen window keeps the focus, so it cannot be moved away
+        if (fullscreen_leaf)
+            return;
+
+        // Windows are moved back once in a while, so that both trees see them come and go
+        bool const back = !other_leaves.empty() && (other_leaves.size() >= max_other_leaves || rng() % 2);
+        auto& from = back ? other_leaves : leaves;
+        auto& to = back ? leaves : other_leaves;
+        auto& from_tree = back ? other_tree : tree;
+        auto& to_tree = back ? tree : other_tree;
+
+        auto const leaf = random_leaf_in(from);
+        from_tree.advise_delete_window(leaf);
+        if (state.active == leaf)
+            state.active = nullptr;
+        std::erase(from, leaf);
+
+        to_tree.graft(leaf);
+        to.push_back(leaf);
+    }
+
+    void set_area()
+    {
+        // Stay between three quarters and one and a half times the initial size, so that
+        // windows that fit at first keep fitting
+        auto const scale = [&](geom::Size const& size)
+        {
+            std::uniform_int_distribution<int> percent(75, 150);
+            return geom::Size(
+                (int)((long)size.width.as_int() * percent(rng) / 100),
+                (int)((long)size.height.as_int() * percent(rng) / 100));
+        };
+
+        area = { initial_area.top_left, scale(initial_area.size) };
+        tree.set_area(area);
+    }
+
+    void check_tree(
+        TilingWindowTree const& checked,
+        geom::Rectangle const& checked_area,
+        size_t expected_leaves,
+        std::vector<std::string>& violations) const
+    {
+        auto const& root = checked.get_root();
+        if (root->get_logical_area() != checked_area)
+            violations.push_back("root does not cover the tree area");
+        if (root->get_parent().lock() || root->get_parent_link())
+            violations.push_back("root has a parent");
+
+        size_t leaf_count = 0;
+        check_lane(*root, violations, leaf_count);
+        if (leaf_count != expected_leaves)
+        {
+            std::stringstream ss;
+            ss << "tree holds " << leaf_count << " windows, expected " << expected_leaves;
+            violations.push_back(ss.str());
+        }
+    }
+
+    MinSize check_lane(ParentContainer const& lane, std::vector<std::string>& violations, size_t& leaf_count) const
+    {
+        auto const lane_area = lane.get_logical_area();
+        auto const& nodes = lane.get_sub_nodes();
+        if (nodes.empty() && lane.get_parent().lock())
+            violations.push_back("an empty lane was left in the tree");
+
+        long covered = 0;
+        MinSize min_size;
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+            auto const& node = nodes[i];
+            if (node->get_parent().lock().get() != &lane || node->get_parent_link() != &lane)
+                violations.push_back("a child does not point back to its parent");
+            if (node->get_index_in_parent() != (int)i || lane.get_index_of_node(node) != (int)i)
+                violations.push_back("a child does not know its index");
+
+            auto const child_area = node->get_logical_area();
+            if (child_area.size.width.as_int() < 0 || child_area.size.height.as_int() < 0)
+                violations.push_back("a container has a negative size");
+            if (!contains(lane_area, child_area))
+                violations.push_back("a child lies outside of its parent");
+
+            bool const stacked = lane.get_scheme() == LayoutScheme::tabbing || lane.get_scheme() == LayoutScheme::stacking;
+            if (stacked && lane.get_auto_layout() == AutoLayout::none)
+            {
+                if (child_area != lane_area)
+                    violations.push_back("a tabbed or stacked child does not fill its parent");
+            }
+            else
+            {
+                covered += (long)child_area.size.width.as_int() * child_area.size.height.as_int();
+                for (size_t j = 0; j < i; j++)
+                {
+                    if (overlaps(child_area, nodes[j]->get_logical_area()))
+                        violations.push_back("two siblings overlap");
+                }
+            }
+
+            if (auto const child_lane = Container::as_parent(node))
+            {
+                auto const child_min_size = check_lane(*child_lane, violations, leaf_count);
+                min_size.width += child_min_size.width;
+                min_size.height += child_min_size.height;
+            }
+            else
+            {
+                leaf_count++;
+                check_visible_area(*node, violations);
+                min_size.width += node->get_min_width();
+                min_size.height += node->get_min_height();
+            }
+        }
+
+        // Siblings that do not overlap and lie within the lane cover it when their areas add up
+        bool const tiled = lane.get_auto_layout() != AutoLayout::none
+            || lane.get_scheme() == LayoutScheme::horizontal
+            || lane.get_scheme() == LayoutScheme::vertical;
+        if (tiled && !nodes.empty() && covered != (long)lane_area.size.width.as_int() * lane_area.size.height.as_int())
+            violations.push_back("the children of a lane do not cover it");
+
+        // The minimum size of a lane is cached, so it goes stale if a change is not reported
+        if (lane.get_min_width() != min_size.width || lane.get_min_height() != min_size.height)
+            violations.push_back("the cached minimum size of a lane is out of date");
+
+        return min_size;
+    }
+
+    void check_visible_area(Container const& leaf, std::vector<std::string>& violations) const
+    {
+        // A window that is narrower than the gaps has nothing left to show
+        auto const logical = leaf.get_logical_area();
+        if (logical.size.width.as_int() < config->inner_gaps_x || logical.size.height.as_int() < config->inner_gaps_y)
+            return;
+
+        auto const visible = leaf.get_visible_area();
+        if (visible.size.width.as_int() < 0 || visible.size.height.as_int() < 0)
+            violations.push_back("a window has a negative visible size");
+        else if (!contains(logical, visible))
+            violations.push_back("a window is visible outside of its container");
+    }
+};
+}
+
+#endif // MIRACLE_WM_TILING_WINDOW_TREE_FUZZER_H
@@ -17,13 +17,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "compositor_state.h"
 #include "leaf_container.h"
+#include "parent_container.h"
+#include "spatial_index.h"
 #include "stub_configuration.h"
-#include "stub_session.h"
-#include "stub_surface.h"
+#include "stub_tiling_window_tree_interface.h"
 #include "tiling_window_tree.h"
-#include "window_controller.h"
+#include "window_factory.h"
 #include <gtest/gtest.h>
 #include <miral/window_management_options.h>
+#include <random>
 
 using namespace miracle;
 
@@ -33,108 +35,92 @@ geom::Rectangle r {
     geom::Point(0, 0),
     geom::Size(1280, 720)
 };
-}
 
-class SimpleTilingWindowTreeInterface : public TilingWindowTreeInterface
+/// Checks that the children of [parent] cover its area exactly, with no gaps or overlaps,
+/// and recurses into every child lane.
+void expect_children_tile_parent(ParentContainer const& parent)
 {
-public:
-    std::vector<miral::Zone> const& get_zones() override
+    auto const area = parent.get_logical_area();
+    auto const& nodes = parent.get_sub_nodes();
+    int x = area.top_left.x.as_int();
+    int y = area.top_left.y.as_int();
+    for (auto const& node : nodes)
     {
-        return zones;
-    }
+        auto const child = node->get_logical_area();
+        switch (parent.get_scheme())
+        {
+        case LayoutScheme::horizontal:
+            EXPECT_EQ(child.top_left, geom::Point(x, area.top_left.y));
+            EXPECT_EQ(child.size.height, area.size.height);
+            EXPECT_GE(child.size.width.as_int(), 0);
+            x += child.size.width.as_int();
+            break;
+        case LayoutScheme::vertical:
+            EXPECT_EQ(child.top_left, geom::Point(area.top_left.x, y));
+            EXPECT_EQ(child.size.width, area.size.width);
+            EXPECT_GE(child.size.height.as_int(), 0);
+            y += child.size.height.as_int();
+            break;
+        default:
+            EXPECT_EQ(child, area);
+            break;
+        }
 
-    Workspace* get_workspace() const override
-    {
-        return nullptr;
+        if (auto const lane = Container::as_parent(node))
+            expect_children_tile_parent(*lane);
     }
 
-private:
-    std::vector<miral::Zone> zones = { r };
-};
+    if (nodes.empty())
+        return;
 
-class StubWindowController : public miracle::WindowController
-{
-public:
-    StubWindowController(std::vector<std::pair<miral::Window, std::shared_ptr<Container>>>& pairs) :
-        pairs { pairs }
-    {
-    }
-    bool is_fullscreen(miral::Window const&) override
-    {
-        return false;
-    }
-    void set_rectangle(miral::Window const&, geom::Rectangle const&, geom::Rectangle const&) override { }
-    MirWindowState get_state(miral::Window const&) override
-    {
-        return mir_window_state_restored;
-    }
+    if (parent.get_scheme() == LayoutScheme::horizontal)
+        EXPECT_EQ(x, area.top_left.x.as_int() + area.size.width.as_int());
+    else if (parent.get_scheme() == LayoutScheme::vertical)
+        EXPECT_EQ(y, area.top_left.y.as_int() + area.size.height.as_int());
+}
 
-    void change_state(miral::Window const&, MirWindowState state) override { }
-    void clip(miral::Window const&, geom::Rectangle const&) override { }
-    void noclip(miral::Window const&) override { }
-    void select_active_window(miral::Window const&) override { }
-    std::shared_ptr<Container> get_container(miral::Window const& window) override
+std::vector<geom::Rectangle> collect_leaf_areas(ParentContainer const& parent)
+{
+    std::vector<geom::Rectangle> areas;
+    for (auto const& node : parent.get_sub_nodes())
     {
-        for (auto const& p : pairs)
+        if (auto const lane = Container::as_parent(node))
         {
-            if (p.first == window)
-                return p.second;
+            auto const nested = collect_leaf_areas(*lane);
+            areas.insert(areas.end(), nested.begin(), nested.end());
         }
-        return nullptr;
+        else
+            areas.push_back(node->get_logical_area());
     }
-
-    void raise(miral::Window const&) override { }
-    void send_to_back(miral::Window const&) override { }
-    void open(miral::Window const&) override { }
-    void close(miral::Window const&) override { }
-    void on_animation(miracle::AnimationStepResult const& result, std::shared_ptr<Container> const&) override { }
-    void set_user_data(miral::Window const&, std::shared_ptr<void> const&) override { }
-    void modify(miral::Window const&, miral::WindowSpecification const&) override { }
-    miral::WindowInfo& info_for(miral::Window const&) override { }
-
-private:
-    std::vector<std::pair<miral::Window, std::shared_ptr<Container>>>& pairs;
-};
+    return areas;
+}
+}
 
 class TilingWindowTreeTest : public testing::Test
 {
 public:
     TilingWindowTreeTest() :
         tree(
-            std::make_unique<SimpleTilingWindowTreeInterface>(),
+            std::make_unique<test::StubTilingWindowTreeInterface>(r),
             window_controller,
             state,
-            std::make_shared<test::StubConfiguration>(),
+            config,
             r)
     {
     }
 
-    std::shared_ptr<LeafContainer> create_leaf()
+    std::shared_ptr<LeafContainer> create_leaf(std::shared_ptr<ParentContainer> const& parent = nullptr)
     {
-        miral::WindowSpecification spec;
-        spec = tree.place_new_window(spec, nullptr);
-
-        auto session = std::make_shared<test::StubSession>();
-        sessions.push_back(session);
-        auto surface = std::make_shared<test::StubSurface>();
-        surfaces.push_back(surface);
-
-        miral::Window window(session, surface);
-        miral::WindowInfo info(window, spec);
-
-        auto leaf = tree.confirm_window(info, nullptr);
-        pairs.push_back({ window, leaf });
-
+        auto leaf = windows.create_leaf(tree, parent);
         state.active = leaf;
         tree.advise_focus_gained(*leaf);
         return leaf;
     }
 
     CompositorState state;
-    std::vector<std::shared_ptr<test::StubSession>> sessions;
-    std::vector<std::shared_ptr<test::StubSurface>> surfaces;
-    std::vector<std::pair<miral::Window, std::shared_ptr<Container>>> pairs;
-    StubWindowController window_controller { pairs };
+    test::WindowFactory windows;
+    test::StubWindowController& window_controller = windows.window_controller;
+    std::shared_ptr<test::StubConfiguration> config = std::make_shared<test::StubConfiguration>();
     TilingWindowTree tree;
 };
 
@@ -184,5 +170,412 @@ TEST_F(TilingWindowTreeTest, can_add_three_windows_horizontally_without_border_a
     ASSERT_EQ(leaf2->get_logical_area().top_left, geom::Point(ceilf(1280 / 3.f), 0));
 
     ASSERT_EQ(leaf3->get_logical_area().size, geom::Size(floorf(1280 / 3.f), 720));
-    ASSERT_EQ(leaf3->get_logical_area().top_left, geom::Point(floorf(1280 * (2.f / 3.f)) - 1, 0));
-}
\ No newline at end of file
+    ASSERT_EQ(leaf3->get_logical_area().top_left, geom::Point(2 * ceilf(1280 / 3.f), 0));
+}
+
+TEST_F(TilingWindowTreeTest, children_of_equal_weight_differ_by_at_most_one_pixel)
+{
+    for (int i = 0; i < 7; i++)
+        create_leaf();
+
+    int min_width = std::numeric_limits<int>::max();
+    int max_width = 0;
+    for (auto const& area : collect_leaf_areas(*tree.get_root()))
+    {
+        min_width = std::min(min_width, area.size.width.as_int());
+        max_width = std::max(max_width, area.size.width.as_int());
+    }
+
+    EXPECT_LE(max_width - min_width, 1);
+    expect_children_tile_parent(*tree.get_root());
+}
+
+TEST_F(TilingWindowTreeTest, resizing_a_window_keeps_children_tiling_the_parent)
+{
+    auto leaf1 = create_leaf();
+    auto leaf2 = create_leaf();
+    auto leaf3 = create_leaf();
+
+    ASSERT_TRUE(tree.get_root()->resize_node(*leaf2, 101));
+    EXPECT_EQ(leaf2->get_logical_area().size.width.as_int(), 427 + 101);
+    expect_children_tile_parent(*tree.get_root());
+
+    // Shrinking the others below their minimum is refused and leaves the layout alone
+    auto const before = collect_leaf_areas(*tree.get_root());
+    EXPECT_FALSE(tree.get_root()->resize_node(*leaf2, 1280));
+    EXPECT_EQ(collect_leaf_areas(*tree.get_root()), before);
+}
+
+TEST_F(TilingWindowTreeTest, resizing_the_output_and_back_restores_the_layout)
+{
+    std::mt19937 rng(7);
+    std::vector<std::shared_ptr<LeafContainer>> leaves { create_leaf() };
+    for (int i = 0; i < 12; i++)
+    {
+        auto const target = leaves[rng() % leaves.size()];
+        if (i % 3 == 0)
+            tree.request_vertical_layout(*target);
+        leaves.push_back(create_leaf(Container::as_parent(target->get_parent().lock())));
+        Container::as_parent(target->get_parent().lock())->resize_node(*target, (int)(rng() % 61) - 30);
+    }
+
+    auto const before = collect_leaf_areas(*tree.get_root());
+    for (int i = 0; i < 100; i++)
+    {
+        tree.set_area(geom::Rectangle {
+            geom::Point(0, 0),
+            geom::Size(1000 + rng() % 3000, 700 + rng() % 1500)
+        });
+        expect_children_tile_parent(*tree.get_root());
+    }
+
+    tree.set_area(r);
+    EXPECT_EQ(collect_leaf_areas(*tree.get_root()), before);
+}
+
+TEST_F(TilingWindowTreeTest, min_size_follows_changes_to_the_tree)
+{
+    auto leaf1 = create_leaf();
+    auto leaf2 = create_leaf();
+    EXPECT_EQ(tree.get_root()->get_min_width(), leaf1->get_min_width() + leaf2->get_min_width());
+
+    tree.request_vertical_layout(*leaf2);
+    auto leaf3 = create_leaf(Container::as_parent(leaf2->get_parent().lock()));
+    EXPECT_EQ(tree.get_root()->get_min_width(), leaf1->get_min_width() + leaf2->get_min_width() + leaf3->get_min_width());
+
+    tree.advise_delete_window(leaf1);
+    EXPECT_EQ(tree.get_root()->get_min_width(), leaf2->get_min_width() + leaf3->get_min_width());
+}
+
+TEST_F(TilingWindowTreeTest, moving_a_window_modifies_each_changed_window_once)
+{
+    auto leaf1 = create_leaf();
+    auto leaf2 = create_leaf();
+    auto leaf3 = create_leaf();
+
+    ASSERT_TRUE(tree.move_container(Direction::right, *leaf1));
+    EXPECT_EQ(state.layout_transaction->get_statistics().last_operation_modifications, 2u);
+    EXPECT_EQ(leaf2->get_logical_area().top_left, geom::Point(0, 0));
+}
+
+TEST_F(TilingWindowTreeTest, transaction_modifies_windows_once_when_it_is_closed)
+{
+    create_leaf();
+    create_leaf();
+    create_leaf();
+    auto const operations = state.layout_transaction->get_statistics().operations;
+
+    {
+        LayoutTransactionScope transaction(*state.layout_transaction);
+        tree.set_area({
+            geom::Point(0, 0),
+            geom::Size(1920, 1080)
+        });
+        tree.set_area({
+            geom::Point(0, 0),
+            geom::Size(2560, 1440)
+        });
+        EXPECT_EQ(state.layout_transaction->get_statistics().operations, operations);
+    }
+
+    EXPECT_EQ(state.layout_transaction->get_statistics().operations, operations + 1);
+    EXPECT_EQ(state.layout_transaction->get_statistics().last_operation_modifications, 3u);
+}
+
+TEST_F(TilingWindowTreeTest, spatial_index_finds_the_same_window_as_the_tree)
+{
+    auto leaf1 = create_leaf();
+    auto leaf2 = create_leaf();
+    tree.request_vertical_layout(*leaf2);
+    create_leaf(Container::as_parent(leaf2->get_parent().lock()));
+    create_leaf(Container::as_parent(leaf2->get_parent().lock()));
+
+    std::vector<SpatialIndex::Entry> entries;
+    tree.foreach_node([&](std::shared_ptr<Container> const& node)
+    {
+        if (node->is_leaf())
+            entries.push_back({ node->get_logical_area(), node });
+    });
+    SpatialIndex index;
+    index.rebuild(r, entries);
+
+    for (int x = -10; x < 1300; x += 7)
+    {
+        for (int y = -10; y < 740; y += 7)
+            ASSERT_EQ(index.at({ x, y }), tree.select_window_from_point(x, y)) << x << ", " << y;
+    }
+}
+
+TEST_F(TilingWindowTreeTest, neighbors_follow_changes_to_the_layout)
+{
+    auto leaf1 = create_leaf();
+    auto leaf2 = create_leaf();
+    auto leaf3 = create_leaf();
+    tree.request_vertical_layout(*leaf2);
+    auto leaf4 = create_leaf(Container::as_parent(leaf2->get_parent().lock()));
+
+    EXPECT_EQ(tree.get_neighbor(*leaf1, Direction::right), leaf2);
+    EXPECT_EQ(tree.get_neighbor(*leaf2, Direction::down), leaf4);
+    EXPECT_EQ(tree.get_neighbor(*leaf4, Direction::up), leaf2);
+    EXPECT_EQ(tree.get_neighbor(*leaf4, Direction::right), leaf3);
+    EXPECT_EQ(tree.get_neighbor(*leaf3, Direction::right), nullptr);
+    EXPECT_EQ(tree.get_neighbor(*leaf1, Direction::up), nullptr);
+
+    tree.advise_delete_window(leaf2);
+    state.active = leaf1;
+    EXPECT_EQ(tree.get_neighbor(*leaf1, Direction::right), leaf4);
+    EXPECT_EQ(tree.get_neighbor(*leaf4, Direction::up), nullptr);
+}
+
+TEST_F(TilingWindowTreeTest, layout_changes_in_another_tree_keep_the_neighbors)
+{
+    auto leaf1 = create_leaf();
+    auto leaf2 = create_leaf();
+    EXPECT_EQ(tree.get_neighbor(*leaf1, Direction::right), leaf2);
+    auto const generation = tree.get_layout_generation();
+
+    TilingWindowTree other(
+        std::make_unique<test::StubTilingWindowTreeInterface>(r),
+        window_controller,
+        state,
+        config,
+        r);
+    other.set_area({
+        geom::Point(0, 0),
+        geom::Size(640, 720)
+    });
+    EXPECT_EQ(tree.get_layout_generation(), generation);
+
+    tree.set_area({
+        geom::Point(0, 0),
+        geom::Size(640, 720)
+    });
+    EXPECT_NE(tree.get_layout_generation(), generation);
+    EXPECT_EQ(tree.get_neighbor(*leaf1, Direction::right), leaf2);
+}
+
+TEST_F(TilingWindowTreeTest, children_know_their_index_after_insert_swap_and_remove)
+{
+    auto leaf1 = create_leaf();
+    auto leaf2 = create_leaf();
+    auto leaf3 = create_leaf();
+    auto root = tree.get_root();
+    EXPECT_EQ(root->get_index_of_node(leaf1), 0);
+    EXPECT_EQ(root->get_index_of_node(leaf2), 1);
+    EXPECT_EQ(root->get_index_of_node(leaf3), 2);
+
+    root->swap_nodes(leaf1, leaf3);
+    EXPECT_EQ(leaf3->get_index_in_parent(), 0);
+    EXPECT_EQ(leaf1->get_index_in_parent(), 2);
+    EXPECT_EQ(root->get_sibling(*leaf2, -1), leaf3);
+    EXPECT_EQ(root->get_sibling(*leaf2, 1), leaf1);
+    EXPECT_EQ(root->get_sibling(*leaf3, -1), nullptr);
+
+    tree.advise_delete_window(leaf3);
+    EXPECT_EQ(root->get_index_of_node(leaf3), -1);
+    EXPECT_EQ(root->get_index_of_node(leaf2), 0);
+    EXPECT_EQ(root->get_index_of_node(leaf1), 1);
+
+    tree.request_vertical_layout(*leaf1);
+    auto lane = Container::as_parent(leaf1->get_parent().lock());
+    EXPECT_EQ(lane->get_index_in_parent(), 1);
+    EXPECT_EQ(lane->get_index_of_node(leaf1), 0);
+    EXPECT_EQ(root->get_index_of_node(leaf1), -1);
+}
+
+TEST_F(TilingWindowTreeTest, parent_links_follow_nodes_across_lanes)
+{
+    auto leaf1 = create_leaf();
+    auto leaf2 = create_leaf();
+    auto root = tree.get_root();
+    EXPECT_EQ(leaf1->get_parent_link(), root.get());
+    EXPECT_EQ(root->get_parent_link(), nullptr);
+
+    tree.request_vertical_layout(*leaf1);
+    auto lane = Container::as_parent(leaf1->get_parent().lock());
+    EXPECT_EQ(leaf1->get_parent_link(), lane.get());
+    EXPECT_EQ(lane->get_parent_link(), root.get());
+
+    auto leaf3 = create_leaf(lane);
+    EXPECT_EQ(leaf3->get_parent_link(), lane.get());
+
+    // Whatever the tree does with the lane, each node links to the parent that holds it
+    tree.advise_delete_window(leaf1);
+    EXPECT_EQ(leaf1->get_parent_link(), nullptr);
+    lane.reset();
+    EXPECT_EQ(leaf3->get_parent_link(), Container::as_parent(leaf3->get_parent().lock()).get());
+    EXPECT_EQ(leaf2->get_parent_link(), root.get());
+}
+
+TEST_F(TilingWindowTreeTest, auto_layout_places_top_level_windows)
+{
+    std::vector<std::shared_ptr<LeafContainer>> leaves;
+    for (int i = 0; i < 4; i++)
+        leaves.push_back(create_leaf());
+
+    tree.set_auto_layout(AutoLayout::grid);
+    auto const area = tree.get_root()->get_logical_area();
+    auto const expected = compute_auto_layout(AutoLayout::grid, area, { 0.25, 0.25, 0.25, 0.25 });
+    for (size_t i = 0; i < leaves.size(); i++)
+        EXPECT_EQ(leaves[i]->get_logical_area(), expected[i]);
+
+    // A new window joins the layout, and the others make room for it
+    tree.set_auto_layout(AutoLayout::master_stack);
+    leaves.push_back(create_leaf());
+    auto const master = leaves[0]->get_logical_area();
+    EXPECT_EQ(master.top_left, area.top_left);
+    EXPECT_EQ(master.size.height, area.size.height);
+    for (size_t i = 1; i < leaves.size(); i++)
+        EXPECT_EQ(leaves[i]->get_logical_area().top_left.x.as_int(), master.top_left.x.as_int() + master.size.width.as_int());
+
+    // Growing the master widens its column
+    ASSERT_TRUE(tree.get_root()->resize_node(*leaves[0], 100));
+    EXPECT_GT(leaves[0]->get_logical_area().size.width.as_int(), master.size.width.as_int());
+}
+
+TEST_F(TilingWindowTreeTest, auto_layout_puts_gaps_only_between_windows)
+{
+    config->inner_gaps_x = 10;
+    config->inner_gaps_y = 10;
+    std::vector<std::shared_ptr<LeafContainer>> leaves;
+    for (int i = 0; i < 5; i++)
+        leaves.push_back(create_leaf());
+
+    auto const area = tree.get_root()->get_logical_area();
+    for (auto const layout : { AutoLayout::master_stack, AutoLayout::spiral, AutoLayout::grid })
+    {
+        tree.set_auto_layout(layout);
+        for (auto const& leaf : leaves)
+        {
+            auto const logical = leaf->get_logical_area();
+            auto const visible = leaf->get_visible_area();
+            int const left_inset = logical.top_left.x.as_int() > area.top_left.x.as_int() ? 5 : 0;
+            int const top_inset = logical.top_left.y.as_int() > area.top_left.y.as_int() ? 5 : 0;
+            int const right_inset = logical.right().as_int() < area.right().as_int() ? 5 : 0;
+            int const bottom_inset = logical.bottom().as_int() < area.bottom().as_int() ? 5 : 0;
+            EXPECT_EQ(visible.top_left.x.as_int(), logical.top_left.x.as_int() + left_inset) << to_string(layout);
+            EXPECT_EQ(visible.top_left.y.as_int(), logical.top_left.y.as_int() + top_inset) << to_string(layout);
+            EXPECT_EQ(visible.right().as_int(), logical.right().as_int() - right_inset) << to_string(layout);
+            EXPECT_EQ(visible.bottom().as_int(), logical.bottom().as_int() - bottom_inset) << to_string(layout);
+        }
+    }
+}
+
+TEST_F(TilingWindowTreeTest, master_stack_navigates_between_the_master_and_the_stack)
+{
+    auto leaf1 = create_leaf();
+    auto leaf2 = create_leaf();
+    auto leaf3 = create_leaf();
+    tree.set_auto_layout(AutoLayout::master_stack);
+
+    EXPECT_EQ(tree.get_neighbor(*leaf1, Direction::right), leaf2);
+    EXPECT_EQ(tree.get_neighbor(*leaf1, Direction::left), nullptr);
+    EXPECT_EQ(tree.get_neighbor(*leaf2, Direction::down), leaf3);
+    EXPECT_EQ(tree.get_neighbor(*leaf2, Direction::up), nullptr);
+    EXPECT_EQ(tree.get_neighbor(*leaf3, Direction::left), leaf1);
+    EXPECT_EQ(tree.get_neighbor(*leaf3, Direction::down), nullptr);
+
+    // Moving the master into the stack swaps it with the window beside it
+    ASSERT_TRUE(tree.move_container(Direction::right, *leaf1));
+    EXPECT_EQ(leaf2->get_logical_area().top_left, tree.get_root()->get_logical_area().top_left);
+    EXPECT_EQ(tree.get_neighbor(*leaf2, Direction::right), leaf1);
+}
+
+TEST_F(TilingWindowTreeTest, spiral_navigates_to_the_adjacent_window)
+{
+    auto leaf1 = create_leaf();
+    auto leaf2 = create_leaf();
+    auto leaf3 = create_leaf();
+    tree.set_auto_layout(AutoLayout::spiral);
+
+    EXPECT_EQ(tree.get_neighbor(*leaf1, Direction::right), leaf2);
+    EXPECT_EQ(tree.get_neighbor(*leaf2, Direction::down), leaf3);
+    EXPECT_EQ(tree.get_neighbor(*leaf3, Direction::up), leaf2);
+    EXPECT_EQ(tree.get_neighbor(*leaf3, Direction::left), leaf1);
+    EXPECT_EQ(tree.get_neighbor(*leaf2, Direction::right), nullptr);
+}
+
+TEST_F(TilingWindowTreeTest, grid_navigates_by_rows_and_columns)
+{
+    auto leaf1 = create_leaf();
+    auto leaf2 = create_leaf();
+    auto leaf3 = create_leaf();
+    auto leaf4 = create_leaf();
+    tree.set_auto_layout(AutoLayout::grid);
+
+    EXPECT_EQ(tree.get_neighbor(*leaf1, Direction::right), leaf2);
+    EXPECT_EQ(tree.get_neighbor(*leaf1, Direction::down), leaf3);
+    EXPECT_EQ(tree.get_neighbor(*leaf4, Direction::up), leaf2);
+    EXPECT_EQ(tree.get_neighbor(*leaf4, Direction::left), leaf3);
+    EXPECT_EQ(tree.get_neighbor(*leaf2, Direction::right), nullptr);
+    EXPECT_EQ(tree.get_neighbor(*leaf3, Direction::down), nullptr);
+}
+
+TEST_F(TilingWindowTreeTest, windows_in_a_grid_cannot_be_resized)
+{
+    auto leaf1 = create_leaf();
+    create_leaf();
+    tree.set_auto_layout(AutoLayout::grid);
+
+    auto const area = leaf1->get_logical_area();
+    EXPECT_FALSE(tree.resize_container(Direction::right, *leaf1));
+    EXPECT_FALSE(tree.get_root()->resize_node(*leaf1, 100));
+    EXPECT_EQ(leaf1->get_logical_area(), area);
+}
+
+TEST_F(TilingWindowTreeTest, changing_the_gaps_configures_every_window)
+{
+    create_leaf();
+    create_leaf();
+    auto const modifications = window_controller.modifications;
+
+    // The logical areas stay the same, but the windows are given different rectangles
+    config->inner_gaps_x = 10;
+    tree.recalculate_root_node_area();
+    EXPECT_EQ(window_controller.modifications, modifications + 2);
+
+    tree.recalculate_root_node_area();
+    EXPECT_EQ(window_controller.modifications, modifications + 2);
+}
+
+TEST_F(TilingWindowTreeTest, hidden_tree_configures_windows_once_when_shown)
+{
+    auto leaf1 = create_leaf();
+    auto leaf2 = create_leaf();
+    tree.hide();
+
+    auto const before_resize = state.layout_transaction->get_statistics().window_modifications;
+    geom::Rectangle const half { geom::Point { 0, 0 }, geom::Size { 640, 720 } };
+    tree.set_area(half);
+    tree.set_area(geom::Rectangle { geom::Point { 0, 0 }, geom::Size { 320, 720 } });
+    tree.set_area(half);
+    EXPECT_EQ(state.layout_transaction->get_statistics().window_modifications, before_resize);
+
+    tree.show();
+    EXPECT_EQ(state.layout_transaction->get_statistics().window_modifications, before_resize + 2u);
+    EXPECT_EQ(leaf2->get_logical_area().top_left.x.as_int() + leaf2->get_logical_area().size.width.as_int(), 640);
+
+    // Recalculating while hidden is deferred until the tree is shown, where it restores the zone
+    tree.hide();
+    auto const before_recalculate = state.layout_transaction->get_statistics().window_modifications;
+    tree.recalculate_root_node_area();
+    EXPECT_EQ(state.layout_transaction->get_statistics().window_modifications, before_recalculate);
+    tree.show();
+    EXPECT_EQ(state.layout_transaction->get_statistics().window_modifications, before_recalculate + 2u);
+    EXPECT_EQ(tree.get_root()->get_logical_area(), r);
+}
+
+TEST_F(TilingWindowTreeTest, hidden_tree_applies_changed_gaps_when_shown)
+{
+    create_leaf();
+    create_leaf();
+    tree.hide();
+    auto const modifications = window_controller.modifications;
+
+    config->inner_gaps_x = 10;
+    tree.recalculate_root_node_area();
+    EXPECT_EQ(window_controller.modifications, modifications);
+
+    tree.show();
+    EXPECT_EQ(window_controller.modifications, modifications + 2);
+}
@@ -0,0 +1,80 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_WINDOW_FACTORY_H
+#define MIRACLE_WM_WINDOW_FACTORY_H
+
+#include "leaf_container.h"
+#include "parent_container.h"
+#include "stub_session.h"
+#include "stub_surface.h"
+#include "stub_window_controller.h"
+#include "tiling_window_tree.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace miracle::test
+{
+/// Creates windows in a [TilingWindowTree] and keeps the sessions and surfaces that back
+/// them alive. The trees that it fills should use [window_controller].
+class WindowFactory
+{
+public:
+    WindowFactory() = default;
+    WindowFactory(WindowFactory const&) = delete;
+    WindowFactory& operator=(WindowFactory const&) = delete;
+
+    /// Places a new window in [tree] under [parent], or wherever the tree puts new windows
+    /// when [parent] is null.
+    std::shared_ptr<LeafContainer> create_leaf(
+        TilingWindowTree& tree,
+        std::shared_ptr<ParentContainer> const& parent = nullptr)
+    {
+        miral::WindowSpecification spec;
+        spec = tree.place_new_window(spec, parent);
+
+        auto session = std::make_shared<StubSession>();
+        sessions.push_back(session);
+        auto surface = std::make_shared<StubSurface>();
+        surfaces.push_back(surface);
+
+        miral::Window window(session, surface);
+        miral::WindowInfo info(window, spec);
+
+        auto leaf = tree.confirm_window(info, parent);
+        pairs.push_back({ window, leaf });
+        return leaf;
+    }
+
+    /// Forgets the window of a [container] that was removed from its tree.
+    void forget(std::shared_ptr<Container> const& container)
+    {
+        std::erase_if(pairs, [&](auto const& pair) { return pair.second == container; });
+    }
+
+    StubWindowController window_controller { pairs };
+
+private:
+    std::vector<std::shared_ptr<StubSession>> sessions;
+    std::vector<std::shared_ptr<StubSurface>> surfaces;
+    std::vector<std::pair<miral::Window, std::shared_ptr<Container>>> pairs;
+};
+}
+
+#endif // MIRACLE_WM_WINDOW_FACTORY_H
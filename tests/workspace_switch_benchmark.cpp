@@ -0,0 +1,350 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "compositor_state.h"
+#include "frame_clock.h"
+#include "render_statistics.h"
+#include "renderer.h"
+#include "stub_configuration.h"
+#include "surface_tracker.h"
+#include "window_ghost.h"
+#include "window_tools_accessor.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <array>
+#include <chrono>
+#include <glm/gtc/matrix_transform.hpp>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <mir/graphics/buffer.h>
+#include <mir/graphics/platform.h>
+#include <mir/graphics/program_factory.h>
+#include <mir/graphics/texture.h>
+#include <vector>
+
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+using namespace miracle;
+
+namespace
+{
+constexpr int output_width = 1920;
+constexpr int output_height = 1080;
+constexpr int window_size = 256;
+constexpr int frames_per_run = 120;
+
+char const* const window_fragment = R"(uniform sampler2D tex;
+vec4 sample_to_rgba(in vec2 texcoord)
+{
+    return texture2D(tex, texcoord);
+}
+)";
+
+/// A headless GLES2 context, so that the benchmark does not need a display. Its pbuffer
+/// stands in for the output.
+class HeadlessContext
+{
+public:
+    HeadlessContext()
+    {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+        {
+            // Without a display server, we can still render offscreen with Mesa
+            display = eglGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+                return;
+        }
+
+        EGLint const config_attribs[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+            EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+            EGL_STENCIL_SIZE, 8,
+            EGL_NONE
+        };
+        EGLConfig config;
+        EGLint num_configs = 0;
+        if (!eglChooseConfig(display, config_attribs, &config, 1, &num_configs) || num_configs == 0)
+            return;
+
+        EGLint const surface_attribs[] = { EGL_WIDTH, output_width, EGL_HEIGHT, output_height, EGL_NONE };
+        surface = eglCreatePbufferSurface(display, config, surface_attribs);
+
+        eglBindAPI(EGL_OPENGL_ES_API);
+        EGLint const context_attribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+        valid = surface != EGL_NO_SURFACE
+            && context != EGL_NO_CONTEXT
+            && eglMakeCurrent(display, surface, surface, context);
+    }
+
+    ~HeadlessContext()
+    {
+        if (display == EGL_NO_DISPLAY)
+            return;
+
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context != EGL_NO_CONTEXT)
+            eglDestroyContext(display, context);
+        if (surface != EGL_NO_SURFACE)
+            eglDestroySurface(display, surface);
+        eglTerminate(display);
+    }
+
+    bool valid = false;
+
+private:
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLSurface surface = EGL_NO_SURFACE;
+    EGLContext context = EGL_NO_CONTEXT;
+};
+
+/// The buffer of a client, which is also its own texture like a shm buffer in Mir.
+class StubBuffer : public mg::Buffer, public mg::gl::Texture
+{
+public:
+    StubBuffer()
+    {
+        std::vector<unsigned char> pixels(window_size * window_size * 4, 0x80);
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, window_size, window_size, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+    ~StubBuffer() override
+    {
+        glDeleteTextures(1, &texture);
+    }
+
+    mg::BufferID id() const override { return mg::BufferID {}; }
+    geom::Size size() const override { return { window_size, window_size }; }
+    MirPixelFormat pixel_format() const override { return mir_pixel_format_abgr_8888; }
+    mg::NativeBufferBase* native_buffer_base() override { return this; }
+
+    auto shader(mg::gl::ProgramFactory& cache) const -> mg::gl::Program const& override
+    {
+        return cache.compile_fragment_shader(window_fragment, "", window_fragment);
+    }
+
+    auto layout() const -> Layout override { return Layout::GL; }
+    void bind() override { glBindTexture(GL_TEXTURE_2D, texture); }
+    auto tex_id() const -> GLuint override { return texture; }
+    void add_syncpoint() override { }
+
+private:
+    GLuint texture = 0;
+};
+
+/// A window on one of the workspaces of the output.
+class StubRenderable : public mg::Renderable
+{
+public:
+    StubRenderable(std::shared_ptr<StubBuffer> const& buffer, geom::Rectangle const& position, int workspace) :
+        buffer_ { buffer },
+        position { position },
+        workspace { workspace }
+    {
+    }
+
+    [[nodiscard]] ID id() const override { return this; }
+    [[nodiscard]] std::shared_ptr<mg::Buffer> buffer() const override { return buffer_; }
+    [[nodiscard]] geom::Rectangle screen_position() const override { return position; }
+    [[nodiscard]] geom::RectangleD src_bounds() const override
+    {
+        return { { 0, 0 }, { window_size, window_size } };
+    }
+    [[nodiscard]] std::optional<geom::Rectangle> clip_area() const override { return std::nullopt; }
+    [[nodiscard]] float alpha() const override { return 1.f; }
+    [[nodiscard]] glm::mat4 transformation() const override { return glm::mat4(1.f); }
+    [[nodiscard]] bool shaped() const override { return false; }
+    [[nodiscard]] std::optional<mir::scene::Surface const*> surface_if_any() const override { return std::nullopt; }
+
+    std::shared_ptr<StubBuffer> const buffer_;
+    geom::Rectangle const position;
+    int const workspace;
+};
+
+/// Draws into the default framebuffer of the headless context. Committing waits for
+/// the GPU, so that the time of a frame includes drawing it.
+class StubOutputSurface : public mg::gl::OutputSurface
+{
+public:
+    void bind() override { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
+    void make_current() override { }
+    void release_current() override { }
+
+    auto commit() -> std::unique_ptr<mg::Framebuffer> override
+    {
+        glFinish();
+        return nullptr;
+    }
+
+    auto size() const -> geom::Size override { return { output_width, output_height }; }
+    auto layout() const -> Layout override { return Layout::GL; }
+};
+
+class StubRenderingProvider : public mg::GLRenderingProvider
+{
+public:
+    auto as_texture(std::shared_ptr<mg::Buffer> buffer) -> std::shared_ptr<mg::gl::Texture> override
+    {
+        return std::dynamic_pointer_cast<mg::gl::Texture>(buffer);
+    }
+
+    auto suitability_for_allocator(std::shared_ptr<mg::GraphicBufferAllocator> const&) -> mg::probe::Result override
+    {
+        return mg::probe::unsupported;
+    }
+
+    auto suitability_for_display(mg::DisplaySink&) -> mg::probe::Result override
+    {
+        return mg::probe::unsupported;
+    }
+
+    auto surface_for_sink(mg::DisplaySink&, mg::GLConfig const&) -> std::unique_ptr<mg::gl::OutputSurface> override
+    {
+        return nullptr;
+    }
+
+    auto make_framebuffer_provider(mg::DisplaySink&) -> std::unique_ptr<mg::FramebufferProvider> override
+    {
+        return nullptr;
+    }
+};
+
+/// The renderer only uses the workspace of a renderable to group it with the others
+/// on the same workspace, so any distinct address can stand in for one.
+Workspace const* workspace_at(int index)
+{
+    static std::array<char, 2> const workspaces {};
+    return reinterpret_cast<Workspace const*>(&workspaces[index]);
+}
+
+/// Places the renderables on their workspaces itself, rather than asking the window manager.
+class BenchmarkRenderer : public Renderer
+{
+public:
+    using Renderer::Renderer;
+
+    /// The horizontal position of each workspace on the output
+    std::array<float, 2> workspace_offsets { 0.f, output_width };
+    bool switching = false;
+    uint32_t switch_id = 0;
+
+protected:
+    DrawData get_draw_data(mg::Renderable const& renderable) const override
+    {
+        auto const& window = dynamic_cast<StubRenderable const&>(renderable);
+        DrawData data { .enabled = true };
+        data.workspace_transform = glm::translate(glm::mat4(1.f), glm::vec3(workspace_offsets[window.workspace], 0.f, 0.f));
+        if (switching)
+        {
+            data.switching_workspace = workspace_at(window.workspace);
+            data.workspace_switch_id = switch_id;
+        }
+        return data;
+    }
+};
+
+/// Slides the second workspace over the first, returning the mean frame time in milliseconds.
+double time_switch(BenchmarkRenderer& renderer, mg::RenderableList const& renderables)
+{
+    auto const start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames_per_run; frame++)
+    {
+        float const progress = static_cast<float>(frame) / frames_per_run;
+        renderer.workspace_offsets = { -progress * output_width, (1.f - progress) * output_width };
+        renderer.render(renderables);
+    }
+    auto const end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / frames_per_run;
+}
+}
+
+class WorkspaceSwitchBenchmark : public testing::TestWithParam<int>
+{
+};
+
+TEST_P(WorkspaceSwitchBenchmark, FrameTimeDuringSwitch)
+{
+    HeadlessContext context;
+    if (!context.valid)
+        GTEST_SKIP() << "Unable to create a headless GLES2 context";
+
+    CompositorState state;
+    SurfaceTracker surface_tracker;
+    auto const accessor = std::make_shared<WindowToolsAccessor>();
+    BenchmarkRenderer renderer(
+        std::make_shared<StubRenderingProvider>(),
+        std::make_unique<StubOutputSurface>(),
+        std::make_shared<test::StubConfiguration>(),
+        surface_tracker,
+        state,
+        accessor,
+        std::make_shared<RenderStatistics>(),
+        std::make_shared<FrameClock>(),
+        std::make_shared<WindowGhosts>());
+    renderer.set_viewport({ { 0, 0 }, { output_width, output_height } });
+    renderer.set_output_transform(glm::mat2(1.f));
+
+    // Both workspaces are tiled with the same number of windows
+    int const num_windows = GetParam();
+    auto const buffer = std::make_shared<StubBuffer>();
+    auto const columns = std::max(1, output_width / window_size);
+    mg::RenderableList renderables;
+    for (int workspace = 0; workspace < 2; workspace++)
+    {
+        for (int i = 0; i < num_windows; i++)
+        {
+            geom::Rectangle const position {
+                { (i % columns) * window_size, ((i / columns) * window_size) % output_height },
+                { window_size, window_size }
+            };
+            renderables.push_back(std::make_shared<StubRenderable>(buffer, position, workspace));
+        }
+    }
+
+    // Live: every window of both workspaces is drawn on every frame
+    auto const live_ms = time_switch(renderer, renderables);
+
+    // Snapshots: the first frame of the switch captures each workspace, then only the snapshots are drawn
+    renderer.switching = true;
+    renderer.switch_id++;
+    renderer.workspace_offsets = { 0.f, output_width };
+    auto const capture_start = std::chrono::steady_clock::now();
+    renderer.render(renderables);
+    auto const capture_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - capture_start).count();
+    auto const snapshot_ms = time_switch(renderer, renderables);
+
+    std::cout << "windows per workspace: " << num_windows
+              << ", live: " << live_ms << "ms/frame"
+              << ", snapshot: " << snapshot_ms << "ms/frame"
+              << " (capture: " << capture_ms << "ms)" << std::endl;
+    RecordProperty("live_ms", std::to_string(live_ms));
+    RecordProperty("snapshot_ms", std::to_string(snapshot_ms));
+    RecordProperty("capture_ms", std::to_string(capture_ms));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    WindowCounts,
+    WorkspaceSwitchBenchmark,
+    testing::Values(1, 10, 50, 200));